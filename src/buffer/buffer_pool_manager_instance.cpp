@@ -12,29 +12,58 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <new>
+
+#include "common/exception.h"
 #include "common/macros.h"
 
 namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
-    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager) {}
+                                                     LogManager *log_manager, ReplacerType replacer_type,
+                                                     size_t replacer_k, uint64_t correlated_reference_period)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager, replacer_type, replacer_k,
+                                correlated_reference_period) {}
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                                                     DiskManager *disk_manager, LogManager *log_manager)
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     ReplacerType replacer_type, size_t replacer_k,
+                                                     uint64_t correlated_reference_period)
     : pool_size_(pool_size),
       num_instances_(num_instances),
       instance_index_(instance_index),
       next_page_id_(instance_index),
+      frame_arena_(pool_size),
       disk_manager_(disk_manager),
-      log_manager_(log_manager) {
+      log_manager_(log_manager),
+      stripes_(NUM_PAGE_TABLE_STRIPES),
+      io_in_progress_(new bool[pool_size]()),
+      io_cvs_(pool_size),
+      write_back_cvs_(pool_size),
+      in_replacer_(new std::atomic<bool>[pool_size]()) {
   BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
   BUSTUB_ASSERT(
       instance_index < num_instances,
       "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 1.");
-  // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+  // The frame data lives in the frame arena; the frame metadata in a separate array, one cache line per frame.
+  pages_ = static_cast<Page *>(::operator new[](pool_size_ * sizeof(Page), std::align_val_t{alignof(Page)}));
+  for (size_t i = 0; i < pool_size_; ++i) {
+    new (&pages_[i]) Page(frame_arena_.GetFrameData(static_cast<frame_id_t>(i)));
+  }
+  switch (replacer_type) {
+    case ReplacerType::LRU:
+      replacer_ = new LRUReplacer(pool_size);
+      break;
+    case ReplacerType::CLOCK:
+      replacer_ = new ClockReplacer(pool_size);
+      break;
+    case ReplacerType::LRU_K:
+      replacer_ = new LRUKReplacer(pool_size, replacer_k, correlated_reference_period);
+      break;
+  }
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
@@ -43,67 +72,125 @@ BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t
     pages_[i].is_dirty_ = false;
     pages_[i].pin_count_ = 0;
   }
+  num_free_frames_ = pool_size_;
+  LoadFreePages();
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  StopBackgroundWriter();
+  // Wait for the prefetches in flight, they read into pages_.
+  async_disk_manager_.reset();
+  for (size_t i = 0; i < pool_size_; ++i) {
+    pages_[i].~Page();
+  }
+  ::operator delete[](pages_, std::align_val_t{alignof(Page)});
   delete replacer_;
 }
 
 auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
   // Make sure you call DiskManager::WritePage!
-  std::lock_guard<std::mutex> lock(latch_);
-  auto it = page_table_.find(page_id);
-  if (it == page_table_.end()) {
-    return false;
-  }
-  auto frame_id = it->second;
-  disk_manager_->WritePage(page_id, pages_[frame_id].GetData());
-  pages_[frame_id].is_dirty_ = false;
-  return true;
+  return WritePageOut(page_id, false);
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
-  // You can do it!
-  for (const auto page : page_table_) {
-    FlushPgImp(page.first);
+  std::vector<page_id_t> page_ids;
+  CollectDirtyPages(&page_ids);
+  std::sort(page_ids.begin(), page_ids.end());
+  size_t batch_size = GetFlushBatchSize();
+  std::vector<DiskManager::PageWrite> pages;
+  for (size_t begin = 0; begin < page_ids.size(); begin += batch_size) {
+    std::vector<page_id_t> batch(page_ids.begin() + begin,
+                                 page_ids.begin() + std::min(page_ids.size(), begin + batch_size));
+    pages.clear();
+    PinDirtyPages(batch, &pages);
+    disk_manager_->WritePages(pages);
+    UnpinFlushedPages(pages);
+  }
+  disk_manager_->SyncPages();
+}
+
+void BufferPoolManagerInstance::CollectDirtyPages(std::vector<page_id_t> *page_ids) {
+  for (auto &stripe : stripes_) {
+    std::scoped_lock stripe_lock(stripe.latch_);
+    for (const auto &[page_id, frame_id] : stripe.page_table_) {
+      if (pages_[frame_id].is_dirty_) {
+        page_ids->push_back(page_id);
+      }
+    }
+  }
+}
+
+void BufferPoolManagerInstance::PinDirtyPages(const std::vector<page_id_t> &page_ids,
+                                              std::vector<DiskManager::PageWrite> *pages) {
+  for (auto page_id : page_ids) {
+    auto &stripe = GetStripe(page_id);
+    std::scoped_lock stripe_lock(stripe.latch_);
+    auto it = stripe.page_table_.find(page_id);
+    if (it == stripe.page_table_.end()) {
+      continue;
+    }
+    frame_id_t frame_id = it->second;
+    if (!pages_[frame_id].is_dirty_ || io_in_progress_[frame_id]) {
+      continue;
+    }
+    pages_[frame_id].pin_count_++;
+    pages_[frame_id].is_dirty_ = false;
+    pages->push_back({page_id, pages_[frame_id].GetData()});
+  }
+}
+
+void BufferPoolManagerInstance::UnpinFlushedPages(const std::vector<DiskManager::PageWrite> &pages) {
+  for (const auto &page : pages) {
+    auto &stripe = GetStripe(page.page_id_);
+    std::scoped_lock stripe_lock(stripe.latch_);
+    UnpinFrame(stripe.page_table_.at(page.page_id_));
   }
 }
 
 auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
+  return NewPgWithStrategyImp(page_id, nullptr);
+}
+
+auto BufferPoolManagerInstance::NewPgWithStrategyImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * {
   // 0.   Make sure you call AllocatePage!
   // 1.   If all the pages in the buffer pool are pinned, return nullptr.
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
   // 3.   Update P's metadata, zero out memory and add P to the page table.
   // 4.   Set the page ID output parameter. Return a pointer to P.
-  std::lock_guard<std::mutex> lock(latch_);
+  std::unique_lock<std::mutex> lock = LockLatch();
   frame_id_t frame_id;
-  // find frame_id
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else if (replacer_->Victim(&frame_id)) {
-    auto page_id_old = pages_[frame_id].GetPageId();
-    if (pages_[frame_id].IsDirty()) {
-      disk_manager_->WritePage(page_id_old, pages_[frame_id].data_);
-      pages_[frame_id].is_dirty_ = false;
-    }
-    page_table_.erase(page_id_old);
-  } else {
+  bool write_back;
+  BufferAccessStrategy::RingSlot *slot = NextRingSlot(strategy);
+  if (!PickVictim(&frame_id, &write_back, slot)) {
+    num_pin_failures_.fetch_add(1, std::memory_order_relaxed);
     return nullptr;
   }
-  pages_[frame_id].pin_count_++;
-  pages_[frame_id].is_dirty_ = false;
   *page_id = AllocatePage();
-  page_table_[*page_id] = frame_id;
-  pages_[frame_id].page_id_ = *page_id;
-  replacer_->Pin(frame_id);
-  // memset(pages_[frame_id].data_, 0, PAGE_SIZE);
+  num_new_pages_++;
+  page_id_t old_page_id = pages_[frame_id].page_id_;
+  InstallPage(frame_id, *page_id);
+  if (slot != nullptr) {
+    *slot = {frame_id, *page_id};
+  }
+  // Write the victim back without holding the latch.
+  lock.unlock();
+  if (write_back) {
+    disk_manager_->WritePage(old_page_id, pages_[frame_id].GetData());
+    num_sync_writes_++;
+  }
   pages_[frame_id].ResetMemory();
+  // The page is not on disk yet, or has its old content there if it is reused, so it has to be written out even if it
+  // is never modified.
+  pages_[frame_id].is_dirty_ = true;
+  FinishIo(frame_id, *page_id, write_back ? old_page_id : INVALID_PAGE_ID);
   return &pages_[frame_id];
 }
 
 auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
+  return FetchPgWithStrategyImp(page_id, nullptr);
+}
+
+auto BufferPoolManagerInstance::FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
   // 1.     Search the page table for the requested page (P).
   // 1.1    If P exists, pin it and return it immediately.
   // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
@@ -111,37 +198,68 @@ auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  std::lock_guard<std::mutex> lock(latch_);
-  frame_id_t frame_id;
-  // If p exists
-  if (page_table_.find(page_id) != page_table_.end()) {
-    frame_id = page_table_.find(page_id)->second;
-    replacer_->Pin(frame_id);
-    pages_[frame_id].pin_count_++;
-    // pages_[frame_id].is_dirty_ = true;
+  auto &stripe = GetStripe(page_id);
+  stripe.num_fetches_.fetch_add(1, std::memory_order_relaxed);
+  while (true) {
+    {
+      // A hit only takes the latch of P's stripe.
+      std::unique_lock<std::mutex> stripe_lock(stripe.latch_);
+      Page *page = PinResidentPage(page_id, &stripe_lock);
+      if (page != nullptr) {
+        stripe.num_hits_.fetch_add(1, std::memory_order_relaxed);
+        return page;
+      }
+    }
+    std::unique_lock<std::mutex> lock = LockLatch();
+    {
+      // Another thread may have brought P in since we looked. Pages are only installed under latch_, so if P is still
+      // absent now, it stays absent until we install it.
+      std::scoped_lock stripe_lock(stripe.latch_);
+      if (stripe.page_table_.count(page_id) > 0 || stripe.write_back_table_.count(page_id) > 0) {
+        continue;
+      }
+    }
+    // If P does not exist
+    frame_id_t frame_id;
+    bool write_back;
+    BufferAccessStrategy::RingSlot *slot = NextRingSlot(strategy);
+    if (!PickVictim(&frame_id, &write_back, slot)) {
+      num_pin_failures_.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    num_misses_.fetch_add(1, std::memory_order_relaxed);
+    page_id_t old_page_id = pages_[frame_id].page_id_;
+    InstallPage(frame_id, page_id);
+    if (slot != nullptr) {
+      *slot = {frame_id, page_id};
+    }
+    // Do the I/O without holding the latch, so that other pages can be fetched in the meantime.
+    lock.unlock();
+    if (write_back) {
+      disk_manager_->WritePage(old_page_id, pages_[frame_id].GetData());
+      num_sync_writes_++;
+    }
+    try {
+      disk_manager_->ReadPage(page_id, pages_[frame_id].GetData());
+    } catch (const Exception &e) {
+      // P failed checksum verification, it is not handed out.
+      AbortIo(frame_id, page_id, write_back ? old_page_id : INVALID_PAGE_ID);
+      return nullptr;
+    }
+    FinishIo(frame_id, page_id, write_back ? old_page_id : INVALID_PAGE_ID);
     return &pages_[frame_id];
   }
-  // If P does not exist
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else if (replacer_->Victim(&frame_id)) {
-    auto page_id_old = pages_[frame_id].GetPageId();
-    if (pages_[frame_id].IsDirty()) {
-      disk_manager_->WritePage(page_id_old, pages_[frame_id].data_);
-      pages_[frame_id].is_dirty_ = false;
-    }
-    page_table_.erase(page_id_old);
-  } else {
+}
+
+auto BufferPoolManagerInstance::FetchPgIfResidentImp(page_id_t page_id) -> Page * {
+  auto &stripe = GetStripe(page_id);
+  std::scoped_lock stripe_lock(stripe.latch_);
+  auto it = stripe.page_table_.find(page_id);
+  if (it == stripe.page_table_.end() || io_in_progress_[it->second]) {
     return nullptr;
   }
-  replacer_->Pin(frame_id);
-  pages_[frame_id].pin_count_ = 1;
-  pages_[frame_id].is_dirty_ = false;
-  page_table_[page_id] = frame_id;
-  pages_[frame_id].page_id_ = page_id;
-  disk_manager_->ReadPage(page_id, pages_[frame_id].data_);
-  return &pages_[frame_id];
+  pages_[it->second].pin_count_++;
+  return &pages_[it->second];
 }
 
 auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
@@ -150,52 +268,446 @@ auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
   // 1.   If P does not exist, return true.
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  std::lock_guard<std::mutex> lock(latch_);
-  DeallocatePage(page_id);
-  frame_id_t frame_id;
+  std::unique_lock<std::mutex> lock = LockLatch();
+  auto &stripe = GetStripe(page_id);
+  std::unique_lock<std::mutex> stripe_lock(stripe.latch_);
+  // If P was just evicted and is still being written back, let the write finish before P is marked free on disk.
+  auto write_back_it = stripe.write_back_table_.find(page_id);
+  if (write_back_it != stripe.write_back_table_.end()) {
+    write_back_cvs_[write_back_it->second].wait(stripe_lock,
+                                                [&] { return stripe.write_back_table_.count(page_id) == 0; });
+  }
+  auto it = stripe.page_table_.find(page_id);
   // If p does not exist
-  if (page_table_.find(page_id) == page_table_.end()) {
+  if (it == stripe.page_table_.end()) {
+    stripe_lock.unlock();
+    lock.unlock();
+    DeallocatePage(page_id);
     return true;
   }
-  frame_id = page_table_.find(page_id)->second;
+  frame_id_t frame_id = it->second;
   // If p exists, but has a non-zero pin-count
   if (pages_[frame_id].pin_count_ != 0) {
     return false;
   }
   // Otherwise
   pages_[frame_id].ResetMemory();
-  page_table_.erase(page_id);
-  replacer_->Pin(frame_id);
+  stripe.page_table_.erase(it);
+  replacer_->Remove(frame_id);
+  in_replacer_[frame_id] = false;
   free_list_.push_back(frame_id);
+  num_free_frames_++;
   pages_[frame_id].page_id_ = INVALID_PAGE_ID;
   pages_[frame_id].is_dirty_ = false;
+  stripe_lock.unlock();
+  lock.unlock();
+  DeallocatePage(page_id);
   return true;
 }
 
 auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
-  std::lock_guard<std::mutex> lock(latch_);
-  frame_id_t frame_id;
-  if (page_table_.find(page_id) == page_table_.end()) {
+  auto &stripe = GetStripe(page_id);
+  std::scoped_lock stripe_lock(stripe.latch_);
+  auto it = stripe.page_table_.find(page_id);
+  if (it == stripe.page_table_.end()) {
+    return false;
+  }
+  frame_id_t frame_id = it->second;
+  if (pages_[frame_id].pin_count_ <= 0) {
     return false;
   }
-  frame_id = page_table_.find(page_id)->second;
   // pages_[frame_id].is_dirty_ = is_dirty;
   if (is_dirty) {
     pages_[frame_id].is_dirty_ = is_dirty;  // 不然会直接把之前的 is_dirty 状态给覆盖了。
   }
-  if (--pages_[frame_id].pin_count_ == 0) {
+  UnpinFrame(frame_id);
+  return true;
+}
+
+void BufferPoolManagerInstance::PrefetchPgsImp(const std::vector<page_id_t> &page_ids,
+                                               BufferAccessStrategy *strategy) {
+  for (auto page_id : page_ids) {
+    if (!PrefetchPage(page_id, strategy)) {
+      return;
+    }
+  }
+}
+
+auto BufferPoolManagerInstance::PrefetchPage(page_id_t page_id, BufferAccessStrategy *strategy) -> bool {
+  auto &stripe = GetStripe(page_id);
+  std::unique_lock<std::mutex> lock = LockLatch();
+  {
+    std::scoped_lock stripe_lock(stripe.latch_);
+    if (stripe.page_table_.count(page_id) > 0 || stripe.write_back_table_.count(page_id) > 0) {
+      return true;
+    }
+  }
+  frame_id_t frame_id;
+  bool write_back;
+  BufferAccessStrategy::RingSlot *slot = NextRingSlot(strategy);
+  if (!PickVictim(&frame_id, &write_back, slot)) {
+    return false;
+  }
+  page_id_t old_page_id = pages_[frame_id].page_id_;
+  InstallPage(frame_id, page_id);
+  if (slot != nullptr) {
+    *slot = {frame_id, page_id};
+  }
+  if (async_disk_manager_ == nullptr) {
+    async_disk_manager_ = std::make_unique<AsyncDiskManager>(disk_manager_, PREFETCH_QUEUE_DEPTH);
+  }
+  lock.unlock();
+  // Only the read is asynchronous. A dirty victim is rare with the background writer running, and it has to reach the
+  // disk before the frame can be reused.
+  if (write_back) {
+    disk_manager_->WritePage(old_page_id, pages_[frame_id].GetData());
+    num_sync_writes_++;
+  }
+  async_disk_manager_->ReadPage(page_id, pages_[frame_id].GetData(), [=](bool success) {
+    if (!success) {
+      // An I/O error, or the page failed checksum verification. Drop the page; a fetch reads it again and sees why.
+      AbortIo(frame_id, page_id, write_back ? old_page_id : INVALID_PAGE_ID);
+      return;
+    }
+    // Drop the pin of InstallPage, nobody asked for the page yet.
+    FinishIo(frame_id, page_id, write_back ? old_page_id : INVALID_PAGE_ID, true);
+  });
+  return true;
+}
+
+auto BufferPoolManagerInstance::PinResidentPage(page_id_t page_id, std::unique_lock<std::mutex> *stripe_lock)
+    -> Page * {
+  auto &stripe = GetStripe(page_id);
+  while (true) {
+    auto it = stripe.page_table_.find(page_id);
+    if (it != stripe.page_table_.end()) {
+      frame_id_t frame_id = it->second;
+      pages_[frame_id].pin_count_++;
+      replacer_->RecordAccess(frame_id);
+      // If another thread is still reading P in, wait for it rather than for the whole instance.
+      io_cvs_[frame_id].wait(*stripe_lock, [&] { return !io_in_progress_[frame_id]; });
+      if (pages_[frame_id].page_id_ != page_id) {
+        // The read failed and P was dropped, see AbortIo. Let go of the frame and look again.
+        pages_[frame_id].pin_count_--;
+        io_cvs_[frame_id].notify_all();
+        continue;
+      }
+      return &pages_[frame_id];
+    }
+    // If P was just evicted and is still being written back, wait until the disk has its latest version.
+    auto write_back_it = stripe.write_back_table_.find(page_id);
+    if (write_back_it == stripe.write_back_table_.end()) {
+      return nullptr;
+    }
+    write_back_cvs_[write_back_it->second].wait(*stripe_lock,
+                                                [&] { return stripe.write_back_table_.count(page_id) == 0; });
+  }
+}
+
+auto BufferPoolManagerInstance::LockLatch() -> std::unique_lock<std::mutex> {
+  num_latch_acquisitions_++;
+  std::unique_lock<std::mutex> lock(latch_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    num_latch_waits_++;
+    lock.lock();
+  }
+  return lock;
+}
+
+void BufferPoolManagerInstance::UnpinFrame(frame_id_t frame_id) {
+  if (--pages_[frame_id].pin_count_ == 0 && !in_replacer_[frame_id].exchange(true)) {
     replacer_->Unpin(frame_id);
   }
+}
+
+auto BufferPoolManagerInstance::PickVictim(frame_id_t *frame_id, bool *write_back,
+                                           BufferAccessStrategy::RingSlot *slot) -> bool {
+  // Recycle the frame of the ring slot if it still holds the page we put there and nobody else is using it.
+  if (slot != nullptr && slot->frame_id_ != INVALID_PAGE_ID && pages_[slot->frame_id_].page_id_ == slot->page_id_) {
+    auto &stripe = GetStripe(slot->page_id_);
+    std::scoped_lock stripe_lock(stripe.latch_);
+    if (pages_[slot->frame_id_].pin_count_ == 0) {
+      *frame_id = slot->frame_id_;
+      replacer_->Pin(*frame_id);
+      in_replacer_[*frame_id] = false;
+      *write_back = DetachPage(*frame_id, &stripe);
+      return true;
+    }
+  }
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    num_free_frames_--;
+    *write_back = false;
+    return true;
+  }
+  while (replacer_->Victim(frame_id)) {
+    in_replacer_[*frame_id] = false;
+    auto &stripe = GetStripe(pages_[*frame_id].page_id_);
+    std::scoped_lock stripe_lock(stripe.latch_);
+    // The frame was pinned by a hit after it entered the replacer; it comes back once it is unpinned.
+    if (pages_[*frame_id].pin_count_ > 0) {
+      continue;
+    }
+    *write_back = DetachPage(*frame_id, &stripe);
+    return true;
+  }
+  return false;
+}
+
+auto BufferPoolManagerInstance::DetachPage(frame_id_t frame_id, PageTableStripe *stripe) -> bool {
+  Page &page = pages_[frame_id];
+  stripe->page_table_.erase(page.page_id_);
+  if (page.is_dirty_) {
+    stripe->write_back_table_[page.page_id_] = frame_id;
+    num_dirty_evictions_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    num_clean_evictions_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return page.is_dirty_;
+}
+
+auto BufferPoolManagerInstance::NextRingSlot(BufferAccessStrategy *strategy) -> BufferAccessStrategy::RingSlot * {
+  if (strategy == nullptr || strategy->GetRingSize() == 0) {
+    return nullptr;
+  }
+  // Like the ring itself, keep the share of the pool a single operation can take small.
+  size_t ring_size = std::min(strategy->GetRingSize(), std::max<size_t>(pool_size_ / 8, 2));
+  return &strategy->NextRingSlot(instance_index_, ring_size);
+}
+
+void BufferPoolManagerInstance::InstallPage(frame_id_t frame_id, page_id_t page_id) {
+  Page &page = pages_[frame_id];
+  auto &stripe = GetStripe(page_id);
+  std::scoped_lock stripe_lock(stripe.latch_);
+  page.page_id_ = page_id;
+  page.pin_count_ = 1;
+  page.is_dirty_ = false;
+  io_in_progress_[frame_id] = true;
+  stripe.page_table_[page_id] = frame_id;
+  replacer_->Remove(frame_id);
+  replacer_->RecordAccess(frame_id);
+}
+
+void BufferPoolManagerInstance::FinishIo(frame_id_t frame_id, page_id_t page_id, page_id_t old_page_id,
+                                         bool unpin) {
+  FinishWriteBack(frame_id, old_page_id);
+  auto &stripe = GetStripe(page_id);
+  std::scoped_lock stripe_lock(stripe.latch_);
+  io_in_progress_[frame_id] = false;
+  if (unpin) {
+    UnpinFrame(frame_id);
+  }
+  io_cvs_[frame_id].notify_all();
+}
+
+void BufferPoolManagerInstance::AbortIo(frame_id_t frame_id, page_id_t page_id, page_id_t old_page_id) {
+  // The write-back is done either way; DeletePgImp may be waiting for it with latch_ held.
+  FinishWriteBack(frame_id, old_page_id);
+  auto &stripe = GetStripe(page_id);
+  std::unique_lock<std::mutex> stripe_lock(stripe.latch_);
+  Page &page = pages_[frame_id];
+  stripe.page_table_.erase(page_id);
+  page.page_id_ = INVALID_PAGE_ID;
+  page.is_dirty_ = false;
+  io_in_progress_[frame_id] = false;
+  io_cvs_[frame_id].notify_all();
+  // The threads that pinned the page while it was read find it gone and drop their pins; ours is the last one. This
+  // may run on the completion thread of the AsyncDiskManager, so latch_ is only taken once the frame is ours.
+  io_cvs_[frame_id].wait(stripe_lock, [&] { return page.pin_count_ == 1; });
+  page.pin_count_ = 0;
+  page.ResetMemory();
+  stripe_lock.unlock();
+  std::unique_lock<std::mutex> lock = LockLatch();
+  free_list_.push_back(frame_id);
+  num_free_frames_++;
+}
+
+void BufferPoolManagerInstance::FinishWriteBack(frame_id_t frame_id, page_id_t old_page_id) {
+  if (old_page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  auto &stripe = GetStripe(old_page_id);
+  std::scoped_lock stripe_lock(stripe.latch_);
+  stripe.write_back_table_.erase(old_page_id);
+  write_back_cvs_[frame_id].notify_all();
+}
+
+auto BufferPoolManagerInstance::WritePageOut(page_id_t page_id, bool only_if_dirty) -> bool {
+  auto &stripe = GetStripe(page_id);
+  std::unique_lock<std::mutex> stripe_lock(stripe.latch_);
+  auto it = stripe.page_table_.find(page_id);
+  if (it == stripe.page_table_.end()) {
+    return false;
+  }
+  auto frame_id = it->second;
+  // A pinned page is in use and likely to be modified again, the writer leaves it alone.
+  if (only_if_dirty && (!pages_[frame_id].is_dirty_ || pages_[frame_id].pin_count_ > 0)) {
+    return false;
+  }
+  // Pin the page so that it is not evicted while we write it out without the latch. It is marked clean first, so
+  // that a modification made during the write is not lost. A read in progress is waited for, there is nothing to
+  // write before it completes.
+  pages_[frame_id].pin_count_++;
+  io_cvs_[frame_id].wait(stripe_lock, [&] { return !io_in_progress_[frame_id]; });
+  if (pages_[frame_id].page_id_ != page_id) {
+    // The read failed and the page was dropped, see AbortIo.
+    pages_[frame_id].pin_count_--;
+    io_cvs_[frame_id].notify_all();
+    return false;
+  }
+  pages_[frame_id].is_dirty_ = false;
+  stripe_lock.unlock();
+  disk_manager_->WritePage(page_id, pages_[frame_id].GetData());
+  stripe_lock.lock();
+  UnpinFrame(frame_id);
   return true;
 }
 
+void BufferPoolManagerInstance::StartBackgroundWriter(const BackgroundWriterOptions &options) {
+  std::scoped_lock lock(background_writer_latch_);
+  if (background_writer_.joinable()) {
+    return;
+  }
+  background_writer_stop_ = false;
+  background_writer_ = std::thread(&BufferPoolManagerInstance::RunBackgroundWriter, this, options);
+}
+
+void BufferPoolManagerInstance::StopBackgroundWriter() {
+  std::unique_lock<std::mutex> lock(background_writer_latch_);
+  if (!background_writer_.joinable()) {
+    return;
+  }
+  background_writer_stop_ = true;
+  lock.unlock();
+  background_writer_cv_.notify_all();
+  background_writer_.join();
+}
+
+void BufferPoolManagerInstance::RunBackgroundWriter(BackgroundWriterOptions options) {
+  std::unique_lock<std::mutex> lock(background_writer_latch_);
+  while (!background_writer_cv_.wait_for(lock, options.interval_, [&] { return background_writer_stop_; })) {
+    lock.unlock();
+    WriteColdPages(options);
+    lock.lock();
+  }
+}
+
+void BufferPoolManagerInstance::WriteColdPages(const BackgroundWriterOptions &options) {
+  // The frames the replacer would victimize next are the ones a foreground fetch would have to write back.
+  size_t clean_target = pool_size_ * options.clean_target_percent_ / 100;
+  std::vector<page_id_t> page_ids;
+  {
+    std::scoped_lock lock(latch_);
+    // Free frames need no write, they count toward the target.
+    if (free_list_.size() >= clean_target) {
+      return;
+    }
+    std::vector<frame_id_t> frame_ids;
+    replacer_->PeekVictims(clean_target - free_list_.size(), &frame_ids);
+    // Page ids only change under latch_, so they can be read here.
+    for (auto frame_id : frame_ids) {
+      page_ids.push_back(pages_[frame_id].page_id_);
+    }
+  }
+  size_t num_written = 0;
+  for (auto page_id : page_ids) {
+    if (num_written >= options.max_pages_per_round_) {
+      break;
+    }
+    if (page_id != INVALID_PAGE_ID && WritePageOut(page_id, true)) {
+      num_written++;
+      num_background_writes_++;
+    }
+  }
+}
+
+auto BufferPoolManagerInstance::GetStats() const -> BufferPoolInstanceStats {
+  BufferPoolInstanceStats stats;
+  stats.pool_size_ = pool_size_;
+  stats.num_free_frames_ = num_free_frames_;
+  stats.num_new_pages_ = num_new_pages_;
+  for (const auto &stripe : stripes_) {
+    stats.num_fetches_ += stripe.num_fetches_.load(std::memory_order_relaxed);
+    stats.num_hits_ += stripe.num_hits_.load(std::memory_order_relaxed);
+  }
+  stats.num_misses_ = num_misses_;
+  stats.num_clean_evictions_ = num_clean_evictions_;
+  stats.num_dirty_evictions_ = num_dirty_evictions_;
+  stats.num_pin_failures_ = num_pin_failures_;
+  stats.num_sync_writes_ = num_sync_writes_;
+  stats.num_background_writes_ = num_background_writes_;
+  stats.num_latch_acquisitions_ = num_latch_acquisitions_;
+  stats.num_latch_waits_ = num_latch_waits_;
+  return stats;
+}
+
+void BufferPoolManagerInstance::LoadFreePages() {
+  std::scoped_lock lock(latch_);
+  free_pages_.clear();
+  for (page_id_t page_id : disk_manager_->GetFreePages()) {
+    if (page_id % num_instances_ == instance_index_) {
+      free_pages_.insert(page_id);
+    }
+  }
+  // Resume at the first page of this instance past the end of the file.
+  auto num_pages = static_cast<uint32_t>(disk_manager_->GetNumPages());
+  uint32_t num_own_pages =
+      num_pages <= instance_index_ ? 0 : (num_pages - instance_index_ + num_instances_ - 1) / num_instances_;
+  next_page_id_ = static_cast<page_id_t>(instance_index_ + num_own_pages * num_instances_);
+}
+
+auto BufferPoolManagerInstance::ReleaseFreeTail() -> page_id_t {
+  std::scoped_lock lock(latch_);
+  // Pages beyond the new end of the file read as zeroes, so they need not be marked free any more.
+  while (!free_pages_.empty() && *free_pages_.rbegin() == next_page_id_ - static_cast<page_id_t>(num_instances_)) {
+    next_page_id_ -= num_instances_;
+    free_pages_.erase(std::prev(free_pages_.end()));
+  }
+  page_id_t last_page_id = next_page_id_ - static_cast<page_id_t>(num_instances_);
+  return last_page_id < 0 ? 0 : last_page_id + 1;
+}
+
+void BufferPoolManagerInstance::ShrinkFile() {
+  BUSTUB_ASSERT(num_instances_ == 1, "The instances of a parallel BPM share the file, shrink it from there");
+  disk_manager_->Truncate(ReleaseFreeTail());
+}
+
+auto BufferPoolManagerInstance::GetNumFreePages() -> size_t {
+  std::scoped_lock lock(latch_);
+  return free_pages_.size();
+}
+
 auto BufferPoolManagerInstance::AllocatePage() -> page_id_t {
+  if (!free_pages_.empty()) {
+    page_id_t page_id = *free_pages_.begin();
+    free_pages_.erase(free_pages_.begin());
+    return page_id;
+  }
   const page_id_t next_page_id = next_page_id_;
   next_page_id_ += num_instances_;
   ValidatePageId(next_page_id);
   return next_page_id;
 }
 
+void BufferPoolManagerInstance::DeallocatePage(page_id_t page_id) {
+  ValidatePageId(page_id);
+  {
+    std::scoped_lock lock(latch_);
+    if (page_id >= next_page_id_ || free_pages_.count(page_id) > 0) {
+      return;
+    }
+  }
+  // Mark the page free on disk first, so that LoadFreePages finds it after a restart. This is done without the latch;
+  // until the page is in free_pages_, it cannot be allocated again, and writing it would take it off the bitmap.
+  disk_manager_->MarkPageFree(page_id);
+  std::scoped_lock lock(latch_);
+  // The file may have been shrunk below the page in the meantime.
+  if (page_id < next_page_id_) {
+    free_pages_.insert(page_id);
+  }
+}
+
 void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
   assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
 }
@@ -14,16 +14,77 @@
 
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages)
+    : num_pages_(num_pages),
+      in_clock_(new std::atomic<bool>[num_pages]()),
+      referenced_(new std::atomic<bool>[num_pages]()) {}
 
 ClockReplacer::~ClockReplacer() = default;
 
-bool ClockReplacer::Victim(frame_id_t *frame_id) { return false; }
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  // Without concurrent accesses, two sweeps are enough: the first one clears every reference bit it passes.
+  while (size_ > 0) {
+    size_t pos = hand_.fetch_add(1, std::memory_order_relaxed) % num_pages_;
+    if (!in_clock_[pos].load(std::memory_order_relaxed)) {
+      continue;
+    }
+    if (referenced_[pos].load(std::memory_order_relaxed)) {
+      referenced_[pos].store(false, std::memory_order_relaxed);
+      continue;
+    }
+    // Another thread may have pinned or victimized the frame since we looked.
+    if (in_clock_[pos].exchange(false)) {
+      size_--;
+      *frame_id = static_cast<frame_id_t>(pos);
+      return true;
+    }
+  }
+  *frame_id = INVALID_PAGE_ID;
+  return false;
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  if (in_clock_[frame_id].exchange(false)) {
+    size_--;
+  }
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  if (!in_clock_[frame_id].load(std::memory_order_relaxed)) {
+    referenced_[frame_id].store(true, std::memory_order_relaxed);
+    if (!in_clock_[frame_id].exchange(true)) {
+      size_++;
+    }
+  }
+}
 
-size_t ClockReplacer::Size() { return 0; }
+size_t ClockReplacer::Size() { return size_; }
+
+void ClockReplacer::RecordAccess(frame_id_t frame_id) {
+  // The hand clears this bit once per sweep while a hot frame is hit far more often than that, so most hits
+  // find it already set and skip the store.
+  if (!referenced_[frame_id].load(std::memory_order_relaxed)) {
+    referenced_[frame_id].store(true, std::memory_order_relaxed);
+  }
+}
+
+void ClockReplacer::Remove(frame_id_t frame_id) {
+  Pin(frame_id);
+  referenced_[frame_id].store(false, std::memory_order_relaxed);
+}
+
+void ClockReplacer::PeekVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) {
+  // Walk ahead of the hand like Victim would, without clearing reference bits: unreferenced frames go first.
+  size_t hand = hand_.load(std::memory_order_relaxed);
+  for (bool referenced : {false, true}) {
+    for (size_t i = 0; i < num_pages_ && frame_ids->size() < max_frames; i++) {
+      size_t pos = (hand + i) % num_pages_;
+      if (in_clock_[pos].load(std::memory_order_relaxed) &&
+          referenced_[pos].load(std::memory_order_relaxed) == referenced) {
+        frame_ids->push_back(static_cast<frame_id_t>(pos));
+      }
+    }
+  }
+}
 
 }  // namespace bustub
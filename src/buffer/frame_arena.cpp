@@ -0,0 +1,56 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+FrameArena::FrameArena(size_t num_frames) {
+  size_t size = num_frames * PAGE_SIZE;
+  if (size == 0) {
+    return;
+  }
+  if (size >= HUGE_PAGE_SIZE) {
+    // Explicit huge pages have to be reserved by the OS up front, so this fails unless someone did.
+    size_t huge_size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void *data = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data != MAP_FAILED) {
+      data_ = static_cast<char *>(data);
+      size_ = huge_size;
+      huge_tlb_ = true;
+      return;
+    }
+  }
+  // Anonymous mappings are page-aligned and zero-filled.
+  void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (data == MAP_FAILED) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "can't map the buffer pool frames");
+  }
+  data_ = static_cast<char *>(data);
+  size_ = size;
+  if (size >= HUGE_PAGE_SIZE) {
+    // Only a hint, the OS may ignore it.
+    madvise(data_, size_, MADV_HUGEPAGE);
+  }
+}
+
+FrameArena::~FrameArena() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+}
+
+}  // namespace bustub
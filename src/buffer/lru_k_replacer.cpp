@@ -0,0 +1,159 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include <algorithm>
+#include <tuple>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, uint64_t correlated_reference_period)
+    : k_(k),
+      correlated_reference_period_(correlated_reference_period),
+      history_(new std::atomic<uint64_t>[num_pages * k]()),
+      last_access_(new std::atomic<uint64_t>[num_pages]()),
+      num_references_(new std::atomic<size_t>[num_pages]()),
+      queue_positions_(num_pages, eviction_queue_.end()) {
+  BUSTUB_ASSERT(k > 0, "LRU-K needs to remember at least one access.");
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+auto LRUKReplacer::Victim(frame_id_t *frame_id) -> bool {
+  std::scoped_lock lock(latch_);
+  uint64_t now = Tick();
+  // Frames within their correlated reference period are passed over, unless every frame is.
+  auto victim_it = eviction_queue_.end();
+  for (auto it = SkipStaleEntries(eviction_queue_.begin()); it != eviction_queue_.end();
+       it = SkipStaleEntries(std::next(it))) {
+    if (!IsCorrelated(std::get<2>(*it), now)) {
+      victim_it = it;
+      break;
+    }
+    if (victim_it == eviction_queue_.end()) {
+      victim_it = it;
+    }
+  }
+  if (victim_it == eviction_queue_.end()) {
+    *frame_id = INVALID_PAGE_ID;
+    return false;
+  }
+  *frame_id = std::get<2>(*victim_it);
+  queue_positions_[*frame_id] = eviction_queue_.end();
+  eviction_queue_.erase(victim_it);
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  if (queue_positions_[frame_id] != eviction_queue_.end()) {
+    eviction_queue_.erase(queue_positions_[frame_id]);
+    queue_positions_[frame_id] = eviction_queue_.end();
+  }
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::scoped_lock lock(latch_);
+  if (queue_positions_[frame_id] == eviction_queue_.end()) {
+    Tick();
+    Enqueue(frame_id);
+  }
+}
+
+auto LRUKReplacer::Size() -> size_t {
+  std::scoped_lock lock(latch_);
+  return eviction_queue_.size();
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  uint64_t now = current_timestamp_.load(std::memory_order_relaxed);
+  size_t num_references = num_references_[frame_id].load(std::memory_order_relaxed);
+  uint64_t last_access = last_access_[frame_id].load(std::memory_order_relaxed);
+  last_access_[frame_id].store(now, std::memory_order_relaxed);
+  if (num_references > 0) {
+    if (now - last_access < correlated_reference_period_) {
+      return;
+    }
+    // A new uncorrelated reference. The older references move forward by the length of the correlated period that
+    // just ended, so that it counts as one point in time.
+    uint64_t correlated_period = last_access - History(frame_id, 0).load(std::memory_order_relaxed);
+    for (size_t i = std::min(num_references, k_ - 1); i > 0; i--) {
+      History(frame_id, i).store(History(frame_id, i - 1).load(std::memory_order_relaxed) + correlated_period,
+                                 std::memory_order_relaxed);
+    }
+  }
+  History(frame_id, 0).store(now, std::memory_order_relaxed);
+  num_references_[frame_id].store(std::min(num_references + 1, k_), std::memory_order_relaxed);
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  Pin(frame_id);
+  num_references_[frame_id] = 0;
+}
+
+auto LRUKReplacer::SkipStaleEntries(std::set<QueueEntry>::iterator it) -> std::set<QueueEntry>::iterator {
+  while (it != eviction_queue_.end() && std::get<0>(*it) < GetEvictionKey(std::get<2>(*it))) {
+    frame_id_t frame_id = std::get<2>(*it);
+    it = eviction_queue_.erase(it);
+    // The new key is larger, so the frame is met again further on.
+    Enqueue(frame_id);
+  }
+  return it;
+}
+
+void LRUKReplacer::Enqueue(frame_id_t frame_id) {
+  queue_positions_[frame_id] = eviction_queue_.emplace(GetEvictionKey(frame_id), next_sequence_++, frame_id).first;
+}
+
+auto LRUKReplacer::IsCorrelated(frame_id_t frame_id, uint64_t now) -> bool {
+  return num_references_[frame_id].load(std::memory_order_relaxed) > 0 &&
+         last_access_[frame_id].load(std::memory_order_relaxed) + correlated_reference_period_ > now;
+}
+
+auto LRUKReplacer::Tick() -> uint64_t {
+  // A plain store rather than an increment: the latch serializes the writers, and readers only need some recent value.
+  uint64_t now = current_timestamp_.load(std::memory_order_relaxed) + 1;
+  current_timestamp_.store(now, std::memory_order_relaxed);
+  return now;
+}
+
+auto LRUKReplacer::GetEvictionKey(frame_id_t frame_id) -> std::pair<bool, uint64_t> {
+  // Frames with fewer than K references come first. Within a class, the oldest relevant reference loses.
+  size_t num_references = num_references_[frame_id].load(std::memory_order_relaxed);
+  uint64_t timestamp =
+      num_references == 0 ? 0 : History(frame_id, num_references - 1).load(std::memory_order_relaxed);
+  return {num_references >= k_, timestamp};
+}
+
+void LRUKReplacer::PeekVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) {
+  std::scoped_lock lock(latch_);
+  uint64_t now = current_timestamp_.load(std::memory_order_relaxed);
+  // Frames within their correlated reference period go last, as in Victim.
+  std::vector<frame_id_t> correlated;
+  for (auto it = SkipStaleEntries(eviction_queue_.begin());
+       it != eviction_queue_.end() && frame_ids->size() < max_frames; it = SkipStaleEntries(std::next(it))) {
+    frame_id_t frame_id = std::get<2>(*it);
+    if (IsCorrelated(frame_id, now)) {
+      correlated.push_back(frame_id);
+    } else {
+      frame_ids->push_back(frame_id);
+    }
+  }
+  for (size_t i = 0; i < correlated.size() && frame_ids->size() < max_frames; i++) {
+    frame_ids->push_back(correlated[i]);
+  }
+}
+
+}  // namespace bustub
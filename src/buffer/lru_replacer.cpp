@@ -16,48 +16,82 @@
 
 namespace bustub {
 
-LRUReplacer::LRUReplacer(size_t num_pages) {}
+LRUReplacer::LRUReplacer(size_t num_pages)
+    : last_access_(new std::atomic<uint64_t>[num_pages]()), queue_positions_(num_pages, lru_queue_.end()) {}
 
 LRUReplacer::~LRUReplacer() = default;
 
 bool LRUReplacer::Victim(frame_id_t *frame_id) {
   std::lock_guard<std::mutex> lock(mutex_);  // in case there are several threads to operate at the same time.
-  if (!lru_list_.empty()) {
-    auto tmp = lru_list_.front();
+  auto it = SkipStaleEntries(lru_queue_.begin());
+  if (it == lru_queue_.end()) {
+    *frame_id = INVALID_PAGE_ID;
+    return false;
+  }
+  *frame_id = std::get<2>(*it);
+  queue_positions_[*frame_id] = lru_queue_.end();
+  lru_queue_.erase(it);
+  return true;
+}
 
-    if (lru_hash_.find(tmp) != lru_hash_.end()) {
-      lru_hash_.erase(tmp);
-      *frame_id = tmp;
-      lru_list_.pop_front();
-    }
-    return true;
+void LRUReplacer::PeekVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto it = SkipStaleEntries(lru_queue_.begin()); it != lru_queue_.end() && frame_ids->size() < max_frames;
+       it = SkipStaleEntries(std::next(it))) {
+    frame_ids->push_back(std::get<2>(*it));
   }
-  *frame_id = INVALID_PAGE_ID;
-  return false;
 }
 
 void LRUReplacer::Pin(frame_id_t frame_id) {
   std::lock_guard<std::mutex> lock(mutex_);
-  auto it = lru_hash_.find(frame_id);
-  if (it != lru_hash_.end()) {
-    lru_list_.erase(it->second);
-    lru_hash_.erase(frame_id);
+  if (queue_positions_[frame_id] != lru_queue_.end()) {
+    lru_queue_.erase(queue_positions_[frame_id]);
+    queue_positions_[frame_id] = lru_queue_.end();
   }
 }
 
 void LRUReplacer::Unpin(frame_id_t frame_id) {
   std::lock_guard<std::mutex> lock(mutex_);
-  auto it = lru_hash_.find(frame_id);
-  if (it == lru_hash_.end()) {
-    lru_list_.push_back(frame_id);
-    lru_hash_.emplace(frame_id, std::prev(lru_list_.end(), 1));
+  if (queue_positions_[frame_id] == lru_queue_.end()) {
+    // Only this thread writes the clock, so a plain store will do.
+    uint64_t now = current_timestamp_.load(std::memory_order_relaxed) + 1;
+    current_timestamp_.store(now, std::memory_order_relaxed);
+    Enqueue(frame_id, now);
   }
 }
 
 size_t LRUReplacer::Size() {
   std::lock_guard<std::mutex> lock(mutex_);
-  return lru_list_.size();
+  return lru_queue_.size();
+}
+
+void LRUReplacer::RecordAccess(frame_id_t frame_id) {
+  // Hits on a hot frame mostly happen within one tick of the clock; only the first of them writes the frame's slot.
+  uint64_t now = current_timestamp_.load(std::memory_order_relaxed);
+  if (last_access_[frame_id].load(std::memory_order_relaxed) != now) {
+    last_access_[frame_id].store(now, std::memory_order_relaxed);
+  }
+}
+
+void LRUReplacer::Remove(frame_id_t frame_id) {
+  Pin(frame_id);
+  last_access_[frame_id] = 0;
+}
+
+auto LRUReplacer::SkipStaleEntries(std::set<QueueEntry>::iterator it) -> std::set<QueueEntry>::iterator {
+  while (it != lru_queue_.end() && std::get<0>(*it) < last_access_[std::get<2>(*it)].load(std::memory_order_relaxed)) {
+    frame_id_t frame_id = std::get<2>(*it);
+    it = lru_queue_.erase(it);
+    // The frame was accessed later than it was queued, so it is met again further on.
+    Enqueue(frame_id, last_access_[frame_id].load(std::memory_order_relaxed));
+  }
+  return it;
 }
+
+void LRUReplacer::Enqueue(frame_id_t frame_id, uint64_t timestamp) {
+  queue_positions_[frame_id] = lru_queue_.emplace(timestamp, next_sequence_++, frame_id).first;
+}
+
 // void LRUReplacer::GetTestFileContent() {
 //  static bool first_enter = true;
 //  if (first_enter) {
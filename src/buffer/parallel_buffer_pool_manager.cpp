@@ -12,15 +12,20 @@
 
 #include "buffer/parallel_buffer_pool_manager.h"
 
+#include <algorithm>
+#include <thread>  // NOLINT
+
 namespace bustub {
 
 ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
-    : bpmis_{num_instances}, pool_size_(pool_size) {
+                                                     LogManager *log_manager, ReplacerType replacer_type,
+                                                     size_t replacer_k, uint64_t correlated_reference_period)
+    : bpmis_{num_instances}, disk_manager_(disk_manager), pool_size_(pool_size) {
   // Allocate and create individual BufferPoolManagerInstances
   for (uint32_t instance_index = 0; instance_index < num_instances; instance_index++) {
-    bpmis_[instance_index] =
-        new BufferPoolManagerInstance(pool_size, num_instances, instance_index, disk_manager, log_manager);
+    bpmis_[instance_index] = new BufferPoolManagerInstance(pool_size, num_instances, instance_index, disk_manager,
+                                                           log_manager, replacer_type, replacer_k,
+                                                           correlated_reference_period);
   }
 }
 
@@ -36,6 +41,60 @@ auto ParallelBufferPoolManager::GetPoolSize() -> size_t {
   return bpmis_.size() * pool_size_;
 }
 
+void ParallelBufferPoolManager::StartBackgroundWriter(const BackgroundWriterOptions &options) {
+  for (auto &bpmi : bpmis_) {
+    bpmi->StartBackgroundWriter(options);
+  }
+}
+
+void ParallelBufferPoolManager::StopBackgroundWriter() {
+  for (auto &bpmi : bpmis_) {
+    bpmi->StopBackgroundWriter();
+  }
+}
+
+void ParallelBufferPoolManager::ShrinkFile() {
+  // Every instance owns every num_instances-th page of the file, so the file ends after the instance that ends last.
+  page_id_t num_pages = 0;
+  for (auto &bpmi : bpmis_) {
+    num_pages = std::max(num_pages, bpmi->ReleaseFreeTail());
+  }
+  disk_manager_->Truncate(num_pages);
+}
+
+auto ParallelBufferPoolManager::GetNumSyncWrites() const -> uint64_t {
+  uint64_t num_writes = 0;
+  for (const auto &bpmi : bpmis_) {
+    num_writes += bpmi->GetNumSyncWrites();
+  }
+  return num_writes;
+}
+
+auto ParallelBufferPoolManager::GetNumBackgroundWrites() const -> uint64_t {
+  uint64_t num_writes = 0;
+  for (const auto &bpmi : bpmis_) {
+    num_writes += bpmi->GetNumBackgroundWrites();
+  }
+  return num_writes;
+}
+
+auto ParallelBufferPoolManager::GetInstanceStats() const -> std::vector<BufferPoolInstanceStats> {
+  std::vector<BufferPoolInstanceStats> stats;
+  stats.reserve(bpmis_.size());
+  for (const auto &bpmi : bpmis_) {
+    stats.push_back(bpmi->GetStats());
+  }
+  return stats;
+}
+
+auto ParallelBufferPoolManager::GetStats() const -> BufferPoolInstanceStats {
+  BufferPoolInstanceStats stats;
+  for (const auto &bpmi : bpmis_) {
+    stats.Add(bpmi->GetStats());
+  }
+  return stats;
+}
+
 auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManager * {
   // Get BufferPoolManager responsible for handling given page id. You can use this method in your other methods.
   return bpmis_[page_id % bpmis_.size()];
@@ -46,6 +105,17 @@ auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) -> Page * {
   return GetBufferPoolManager(page_id)->FetchPage(page_id);
 }
 
+auto ParallelBufferPoolManager::FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+  if (strategy == nullptr) {
+    return FetchPgImp(page_id);
+  }
+  return GetBufferPoolManager(page_id)->FetchPage(page_id, *strategy);
+}
+
+auto ParallelBufferPoolManager::FetchPgIfResidentImp(page_id_t page_id) -> Page * {
+  return GetBufferPoolManager(page_id)->FetchPageIfResident(page_id);
+}
+
 auto ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
   // Unpin page_id from responsible BufferPoolManagerInstance
   return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
@@ -57,16 +127,16 @@ auto ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
 }
 
 auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
-  // create new page. We will request page allocation in a round robin manner from the underlying
-  // BufferPoolManagerInstances
-  // 1.   From a starting index of the BPMIs, call NewPageImpl until either 1) success and return 2) looped around to
-  // starting index and return nullptr
-  // 2.   Bump the starting index (mod number of instances) to start search at a different BPMI each time this function
-  // is called
-  for (auto &bpmi : bpmis_) {
-    //    BufferPoolManager *manager = *(managers_ + next_instance_);
-    Page *page = bpmi->NewPage(page_id);
-    last_alloc_index_ = (last_alloc_index_ + 1) % bpmis_.size();
+  return NewPgWithStrategyImp(page_id, nullptr);
+}
+
+auto ParallelBufferPoolManager::NewPgWithStrategyImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * {
+  // Every instance hands out the page ids of its own residue class, so whichever instance has room can take the page.
+  std::vector<size_t> order;
+  GetAllocationOrder(&order);
+  for (size_t index : order) {
+    auto *bpmi = bpmis_[index];
+    Page *page = strategy == nullptr ? bpmi->NewPage(page_id) : bpmi->NewPage(page_id, *strategy);
     if (page != nullptr) {
       return page;
     }
@@ -74,15 +144,105 @@ auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
   return nullptr;
 }
 
+void ParallelBufferPoolManager::GetAllocationOrder(std::vector<size_t> *order) {
+  size_t num_instances = bpmis_.size();
+  size_t start = next_alloc_index_.fetch_add(1, std::memory_order_relaxed) % num_instances;
+  // The free frame counts are read without any latch, so they only steer the choice; NewPage decides.
+  size_t best = start;
+  size_t best_free_frames = bpmis_[start]->GetNumFreeFrames();
+  for (size_t i = 1; i < num_instances && best_free_frames < pool_size_; i++) {
+    size_t index = (start + i) % num_instances;
+    size_t free_frames = bpmis_[index]->GetNumFreeFrames();
+    if (free_frames > best_free_frames) {
+      best = index;
+      best_free_frames = free_frames;
+    }
+  }
+  order->reserve(num_instances);
+  order->push_back(best);
+  for (size_t i = 0; i < num_instances; i++) {
+    size_t index = (start + i) % num_instances;
+    if (index != best) {
+      order->push_back(index);
+    }
+  }
+}
+
 auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
   // Delete page_id from responsible BufferPoolManagerInstance
   return GetBufferPoolManager(page_id)->DeletePage(page_id);
 }
 
 void ParallelBufferPoolManager::FlushAllPgsImp() {
-  // flush all pages from all BufferPoolManagerInstances
-  for (auto bp : bpmis_) {
-    bp->FlushAllPages();
+  std::vector<page_id_t> page_ids;
+  for (auto &bpmi : bpmis_) {
+    bpmi->CollectDirtyPages(&page_ids);
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+  // Split the pages into one contiguous slice per writer thread; the calling thread writes the first slice.
+  size_t num_threads = std::max<size_t>(1, std::min(bpmis_.size(), page_ids.size() / MIN_PAGES_PER_FLUSH_THREAD));
+  size_t slice_size = (page_ids.size() + num_threads - 1) / num_threads;
+  std::vector<std::vector<page_id_t>> slices;
+  for (size_t begin = 0; begin < page_ids.size(); begin += slice_size) {
+    slices.emplace_back(page_ids.begin() + begin, page_ids.begin() + std::min(page_ids.size(), begin + slice_size));
+  }
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < slices.size(); i++) {
+    threads.emplace_back([&, i] { FlushPages(slices[i]); });
+  }
+  if (!slices.empty()) {
+    FlushPages(slices[0]);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  disk_manager_->SyncPages();
+}
+
+void ParallelBufferPoolManager::FlushPages(const std::vector<page_id_t> &page_ids) {
+  // A batch spreads over all the instances, and there is at most one writer thread per instance, so no instance has
+  // more than its own flush batch size pinned by the flush.
+  size_t batch_size = bpmis_[0]->GetFlushBatchSize();
+  std::vector<std::vector<page_id_t>> instance_page_ids(bpmis_.size());
+  std::vector<std::vector<DiskManager::PageWrite>> instance_pages(bpmis_.size());
+  std::vector<DiskManager::PageWrite> pages;
+  for (size_t begin = 0; begin < page_ids.size(); begin += batch_size) {
+    for (auto &ids : instance_page_ids) {
+      ids.clear();
+    }
+    for (size_t i = begin; i < std::min(page_ids.size(), begin + batch_size); i++) {
+      instance_page_ids[page_ids[i] % bpmis_.size()].push_back(page_ids[i]);
+    }
+    pages.clear();
+    for (size_t i = 0; i < bpmis_.size(); i++) {
+      instance_pages[i].clear();
+      bpmis_[i]->PinDirtyPages(instance_page_ids[i], &instance_pages[i]);
+      pages.insert(pages.end(), instance_pages[i].begin(), instance_pages[i].end());
+    }
+    std::sort(pages.begin(), pages.end(), [](const auto &a, const auto &b) { return a.page_id_ < b.page_id_; });
+    disk_manager_->WritePages(pages);
+    for (size_t i = 0; i < bpmis_.size(); i++) {
+      bpmis_[i]->UnpinFlushedPages(instance_pages[i]);
+    }
+  }
+}
+
+void ParallelBufferPoolManager::PrefetchPgsImp(const std::vector<page_id_t> &page_ids,
+                                               BufferAccessStrategy *strategy) {
+  // Hand every BufferPoolManagerInstance its share of the pages in one call.
+  std::vector<std::vector<page_id_t>> instance_page_ids(bpmis_.size());
+  for (auto page_id : page_ids) {
+    instance_page_ids[page_id % bpmis_.size()].push_back(page_id);
+  }
+  for (size_t i = 0; i < bpmis_.size(); i++) {
+    if (instance_page_ids[i].empty()) {
+      continue;
+    }
+    if (strategy == nullptr) {
+      bpmis_[i]->PrefetchPages(instance_page_ids[i]);
+    } else {
+      bpmis_[i]->PrefetchPages(instance_page_ids[i], *strategy);
+    }
   }
 }
 
@@ -0,0 +1,186 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_util.cpp
+//
+// Identification: src/common/util/crc32c_util.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/crc32c_util.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+#include "common/config.h"
+
+namespace bustub {
+
+namespace {
+
+/** The CRC32C polynomial, bit-reversed. */
+constexpr uint32_t CRC32C_POLY = 0x82F63B78;
+
+/** Byte-at-a-time lookup table of the polynomial. */
+struct ByteTable {
+  ByteTable() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; bit++) {
+        crc = (crc & 1) != 0 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+      }
+      table_[i] = crc;
+    }
+  }
+  std::array<uint32_t, 256> table_;
+};
+
+const ByteTable BYTE_TABLE;
+
+/** @return a * b modulo the polynomial, both bit-reversed */
+auto MultModP(uint32_t a, uint32_t b) -> uint32_t {
+  uint32_t m = 1U << 31;
+  uint32_t p = 0;
+  while (true) {
+    if ((a & m) != 0) {
+      p ^= b;
+      if ((a & (m - 1)) == 0) {
+        break;
+      }
+    }
+    m >>= 1;
+    b = (b & 1) != 0 ? (b >> 1) ^ CRC32C_POLY : b >> 1;
+  }
+  return p;
+}
+
+/** @return x^(8 * length) modulo the polynomial, which appends length zero bytes to a CRC register */
+auto ZeroBytesOperator(size_t length) -> uint32_t {
+  // x^1, squared once per bit of 8 * length.
+  uint32_t power = 1U << 30;
+  uint32_t result = 1U << 31;
+  for (size_t n = length * 8; n != 0; n >>= 1) {
+    if ((n & 1) != 0) {
+      result = MultModP(power, result);
+    }
+    power = MultModP(power, power);
+  }
+  return result;
+}
+
+/**
+ * Appending a fixed number of zero bytes to a CRC register is linear, so it can be done with one lookup per byte of the
+ * register instead of a polynomial multiplication.
+ */
+struct ShiftTable {
+  explicit ShiftTable(size_t length) {
+    uint32_t op = ZeroBytesOperator(length);
+    for (uint32_t byte = 0; byte < 4; byte++) {
+      for (uint32_t i = 0; i < 256; i++) {
+        table_[byte][i] = MultModP(op, i << (8 * byte));
+      }
+    }
+  }
+  auto Shift(uint32_t crc) const -> uint32_t {
+    return table_[0][crc & 0xFF] ^ table_[1][(crc >> 8) & 0xFF] ^ table_[2][(crc >> 16) & 0xFF] ^ table_[3][crc >> 24];
+  }
+  std::array<std::array<uint32_t, 256>, 4> table_;
+};
+
+/** Streams shorter than this are not worth splitting. */
+constexpr size_t MIN_STREAM_LENGTH = 64;
+
+/** @return the length of each of the three streams a buffer of length bytes is split into */
+constexpr auto StreamLength(size_t length) -> size_t { return length / 3 & ~static_cast<size_t>(7); }
+
+#if defined(__x86_64__)
+
+__attribute__((target("sse4.2"))) auto HardwareExtend(uint64_t crc, const char *data, size_t length) -> uint64_t {
+  for (; length >= 8; data += 8, length -= 8) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    crc = _mm_crc32_u64(crc, word);
+  }
+  for (; length > 0; data++, length--) {
+    crc = _mm_crc32_u8(static_cast<uint32_t>(crc), static_cast<uint8_t>(*data));
+  }
+  return crc;
+}
+
+__attribute__((target("sse4.2"))) auto HardwareCrc32c(const char *data, size_t length) -> uint32_t {
+  uint64_t crc = 0xFFFFFFFF;
+  size_t stream_length = StreamLength(length);
+  if (stream_length >= MIN_STREAM_LENGTH) {
+    // The crc32 instruction has a latency of three cycles but a throughput of one per cycle, so three independent
+    // streams keep it busy. Streams 1 and 2 start from a zero register and are appended to stream 0 afterwards.
+    uint64_t crc1 = 0;
+    uint64_t crc2 = 0;
+    const char *data1 = data + stream_length;
+    const char *data2 = data1 + stream_length;
+    for (size_t i = 0; i < stream_length; i += 8) {
+      uint64_t word0;
+      uint64_t word1;
+      uint64_t word2;
+      memcpy(&word0, data + i, sizeof(word0));
+      memcpy(&word1, data1 + i, sizeof(word1));
+      memcpy(&word2, data2 + i, sizeof(word2));
+      crc = _mm_crc32_u64(crc, word0);
+      crc1 = _mm_crc32_u64(crc1, word1);
+      crc2 = _mm_crc32_u64(crc2, word2);
+    }
+    if (length == PAGE_SIZE) {
+      static const ShiftTable page_shift(StreamLength(PAGE_SIZE));
+      crc = page_shift.Shift(page_shift.Shift(static_cast<uint32_t>(crc)) ^ crc1) ^ crc2;
+    } else {
+      uint32_t op = ZeroBytesOperator(stream_length);
+      crc = MultModP(op, MultModP(op, static_cast<uint32_t>(crc)) ^ crc1) ^ crc2;
+    }
+    data += 3 * stream_length;
+    length -= 3 * stream_length;
+  }
+  return ~static_cast<uint32_t>(HardwareExtend(crc, data, length));
+}
+
+const bool HAS_SSE42 = [] {
+  // Needed when called before main.
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.2") != 0;
+}();
+
+#endif
+
+}  // namespace
+
+auto Crc32cUtil::Crc32c(const char *data, size_t length) -> uint32_t {
+#if defined(__x86_64__)
+  if (HAS_SSE42) {
+    return HardwareCrc32c(data, length);
+  }
+#endif
+  return Crc32cSoftware(data, length);
+}
+
+auto Crc32cUtil::Crc32cSoftware(const char *data, size_t length) -> uint32_t {
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc = BYTE_TABLE.table_[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+auto Crc32cUtil::IsHardwareAccelerated() -> bool {
+#if defined(__x86_64__)
+  return HAS_SSE42;
+#else
+  return false;
+#endif
+}
+
+}  // namespace bustub
@@ -11,9 +11,14 @@
 //===----------------------------------------------------------------------===//
 
 #include "container/hash/extendible_hash_table.h"
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <iterator>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
+#include "common/logger.h"
 #include "common/rid.h"
 
 namespace bustub {
@@ -23,21 +28,38 @@ HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager
                                      const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
     : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
   //  implement me!
+  // init header page, with a single directory page
+  BasicPageGuard header_guard = buffer_pool_manager_->NewPageGuarded(&header_page_id_);
+  BUSTUB_ASSERT(header_guard.IsValid(), "Couldn't create the header page of the hash table.");
+  auto header_page = header_guard.AsMut<ExtendibleHashTableHeaderPage>();
+  header_page->SetPageId(header_page_id_);
+  page_id_t directory_page_id;
+  BasicPageGuard dir_guard = buffer_pool_manager_->NewPageGuarded(&directory_page_id);
+  BUSTUB_ASSERT(dir_guard.IsValid(), "Couldn't create the directory page of the hash table.");
+  header_page->SetDirectoryPageId(0, directory_page_id);
+  header_guard.Drop();
+
   // init directory page
-  auto dir_page = buffer_pool_manager_->NewPage(&directory_page_id_);
-  auto dir_page_data = reinterpret_cast<HashTableDirectoryPage *>(dir_page->GetData());
+  auto dir_page_data = dir_guard.AsMut<HashTableDirectoryPage>();
   // dir_page_data->IncrGlobalDepth();// set global depth to 1
-  dir_page_data->SetPageId(directory_page_id_);
+  dir_page_data->SetPageId(directory_page_id);
 
   // set local depth to 1, init 2 bucket page
   page_id_t bucketpageid0;
-  buffer_pool_manager_->NewPage(&bucketpageid0);
+  BasicPageGuard bucket_guard = buffer_pool_manager_->NewPageGuarded(&bucketpageid0);
+  BUSTUB_ASSERT(bucket_guard.IsValid(), "Couldn't create the bucket page of the hash table.");
+  bucket_guard.SetDirty();
   dir_page_data->SetBucketPageId(0, bucketpageid0);
   // dir_page_data->SetLocalDepth(0, 1);
+}
 
-  // Unpin these pages
-  buffer_pool_manager_->UnpinPage(directory_page_id_, true);
-  buffer_pool_manager_->UnpinPage(bucketpageid0, true);
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HASH_TABLE_TYPE::~ExtendibleHashTable() {
+  StopCompactor();
+  DeleteFreedBucketPages();
+  for (page_id_t page_id : freed_bucket_pages_) {
+    LOG_WARN("bucket page %d is still pinned and cannot be deleted", page_id);
+  }
 }
 
 /*****************************************************************************
@@ -56,23 +78,75 @@ auto HASH_TABLE_TYPE::Hash(KeyType key) -> uint32_t {
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-inline auto HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) -> uint32_t {
+inline auto HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, const HashTableDirectoryPage *dir_page) -> uint32_t {
   return Hash(key) & dir_page->GetGlobalDepthMask();
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-inline auto HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) -> page_id_t {
-  return dir_page->GetBucketPageId(KeyToDirectoryIndex(key, dir_page));
+inline auto HASH_TABLE_TYPE::KeyToHeaderIndex(KeyType key, const ExtendibleHashTableHeaderPage *header_page)
+    -> uint32_t {
+  return (Hash(key) >> DIRECTORY_MAX_DEPTH) & header_page->GetGlobalDepthMask();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::FetchDirectoryPage(KeyType key) -> BasicPageGuard {
+  page_id_t directory_page_id;
+  {
+    BasicPageGuard header_guard = buffer_pool_manager_->FetchPageBasic(header_page_id_);
+    if (!header_guard.IsValid()) {
+      return BasicPageGuard();
+    }
+    auto header_page = header_guard.As<ExtendibleHashTableHeaderPage>();
+    directory_page_id = header_page->GetDirectoryPageId(KeyToHeaderIndex(key, header_page));
+  }
+  return buffer_pool_manager_->FetchPageBasic(directory_page_id);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::GetDirectoryPageIds() -> std::vector<page_id_t> {
+  BasicPageGuard header_guard = buffer_pool_manager_->FetchPageBasic(header_page_id_);
+  std::vector<page_id_t> directory_page_ids;
+  if (!header_guard.IsValid()) {
+    return directory_page_ids;
+  }
+  auto header_page = header_guard.As<ExtendibleHashTableHeaderPage>();
+  // The slots of a directory page with local depth ld are ld-bit suffix matches, the lowest one is its first slot.
+  for (uint32_t i = 0; i < header_page->Size(); i++) {
+    if (i < (1U << header_page->GetLocalDepth(i))) {
+      directory_page_ids.push_back(header_page->GetDirectoryPageId(i));
+    }
+  }
+  return directory_page_ids;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::FetchDirectoryPage() -> HashTableDirectoryPage * {
-  return reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->FetchPage(directory_page_id_)->GetData());
+auto HASH_TABLE_TYPE::KeyToBucketPageId(KeyType key, Page *dir_page, uint32_t *local_depth) -> page_id_t {
+  page_id_t bucket_page_id;
+  dir_page->OptimisticRead([&] {
+    auto dir_page_data = reinterpret_cast<const HashTableDirectoryPage *>(dir_page->GetData());
+    uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page_data);
+    bucket_page_id = dir_page_data->GetBucketPageId(bucket_idx);
+    if (local_depth != nullptr) {
+      *local_depth = dir_page_data->GetLocalDepth(bucket_idx);
+    }
+  });
+  return bucket_page_id;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) {
-  return reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(buffer_pool_manager_->FetchPage(bucket_page_id));
+auto HASH_TABLE_TYPE::FetchBucketPageWrite(KeyType key, uint32_t *local_depth) -> WritePageGuard {
+  BasicPageGuard dir_guard = FetchDirectoryPage(key);
+  if (!dir_guard.IsValid()) {
+    return WritePageGuard();
+  }
+  while (true) {
+    page_id_t bucket_page_id = KeyToBucketPageId(key, dir_guard.GetPage(), nullptr);
+    WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(bucket_page_id);
+    // A split may have moved the key to another bucket before we got the latch; once we hold it, it cannot anymore.
+    if (!bucket_guard.IsValid() || KeyToBucketPageId(key, dir_guard.GetPage(), local_depth) == bucket_page_id) {
+      return bucket_guard;
+    }
+  }
 }
 
 /*****************************************************************************
@@ -80,156 +154,392 @@ HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_i
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool {
-  auto dir_page_data = FetchDirectoryPage();
+  // table lock, only held in write mode by directory splits and merges
   table_latch_.RLock();
-  // table lock
-  auto bucket_page_id = KeyToPageId(key, dir_page_data);
-  HASH_TABLE_BUCKET_TYPE *bucket_page_data = FetchBucketPage(bucket_page_id);
-  Page *bucket_page = reinterpret_cast<Page *>(bucket_page_data);
-  // page latch
-  bucket_page->RLatch();
-  auto res = bucket_page_data->GetValue(key, comparator_, result);
-  // Unpin pages
-  bucket_page->RUnlatch();
+  bool res = false;
+  std::vector<ValueType> values;
+  uint8_t fingerprint = HashFingerprint(Hash(key));
+  {
+    BasicPageGuard dir_guard = FetchDirectoryPage(key);
+    while (dir_guard.IsValid()) {
+      // Both the directory and the bucket are read optimistically. If the bucket was split while we read it, the key
+      // may have moved to the split image, so the read only counts if the directory still points to the bucket.
+      page_id_t bucket_page_id = KeyToBucketPageId(key, dir_guard.GetPage(), nullptr);
+      BasicPageGuard bucket_guard = buffer_pool_manager_->FetchPageBasic(bucket_page_id);
+      if (!bucket_guard.IsValid()) {
+        values.clear();
+        res = false;
+        break;
+      }
+      auto bucket_page_data = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>();
+      bucket_guard.GetPage()->OptimisticRead([&] {
+        values.clear();
+        res = bucket_page_data->GetValue(key, comparator_, fingerprint, &values);
+      });
+      if (KeyToBucketPageId(key, dir_guard.GetPage(), nullptr) == bucket_page_id) {
+        break;
+      }
+    }
+  }
   table_latch_.RUnlock();
-  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
-  buffer_pool_manager_->UnpinPage(directory_page_id_, false);  // TODO(liyi) :?
+  result->insert(result->end(), values.begin(), values.end());
   return res;
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::GetValues(Transaction *transaction, const std::vector<KeyType> &keys,
+                                std::vector<std::vector<ValueType>> *results) -> size_t {
+  results->assign(keys.size(), {});
+  std::vector<uint32_t> hashes(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    hashes[i] = Hash(keys[i]);
+  }
+
+  // A key on its way to its bucket. Probes are sorted by directory page, then by bucket, so that each page is pinned
+  // once per batch.
+  struct Probe {
+    page_id_t directory_page_id_;
+    page_id_t bucket_page_id_;
+    uint32_t key_idx_;
+  };
+  std::vector<Probe> probes(keys.size());
+  // Keys that a concurrent split moved away from the bucket they were looked up in.
+  std::vector<uint32_t> retries;
+  table_latch_.RLock();
+  {
+    BasicPageGuard header_guard = buffer_pool_manager_->FetchPageBasic(header_page_id_);
+    if (!header_guard.IsValid()) {
+      table_latch_.RUnlock();
+      return 0;
+    }
+    auto header_page = header_guard.As<ExtendibleHashTableHeaderPage>();
+    for (uint32_t i = 0; i < keys.size(); i++) {
+      uint32_t header_idx = (hashes[i] >> DIRECTORY_MAX_DEPTH) & header_page->GetGlobalDepthMask();
+      probes[i] = {header_page->GetDirectoryPageId(header_idx), INVALID_PAGE_ID, i};
+    }
+  }
+  std::sort(probes.begin(), probes.end(),
+            [](const Probe &a, const Probe &b) { return a.directory_page_id_ < b.directory_page_id_; });
+
+  for (auto dir_begin = probes.begin(); dir_begin != probes.end();) {
+    auto dir_end = std::find_if(dir_begin, probes.end(), [&](const Probe &probe) {
+      return probe.directory_page_id_ != dir_begin->directory_page_id_;
+    });
+    BasicPageGuard dir_guard = buffer_pool_manager_->FetchPageBasic(dir_begin->directory_page_id_);
+    if (!dir_guard.IsValid()) {
+      // Out of frames; the keys are looked up one by one after the batch.
+      std::transform(dir_begin, dir_end, std::back_inserter(retries),
+                     [](const Probe &probe) { return probe.key_idx_; });
+      dir_begin = dir_end;
+      continue;
+    }
+    auto dir_page_data = dir_guard.As<HashTableDirectoryPage>();
+    dir_guard.GetPage()->OptimisticRead([&] {
+      uint32_t global_depth_mask = dir_page_data->GetGlobalDepthMask();
+      for (auto it = dir_begin; it != dir_end; ++it) {
+        if (dir_end - it > static_cast<std::ptrdiff_t>(BATCH_PREFETCH_DISTANCE)) {
+          dir_page_data->PrefetchBucketPageId(hashes[(it + BATCH_PREFETCH_DISTANCE)->key_idx_] & global_depth_mask);
+        }
+        it->bucket_page_id_ = dir_page_data->GetBucketPageId(hashes[it->key_idx_] & global_depth_mask);
+      }
+    });
+    std::sort(dir_begin, dir_end,
+              [](const Probe &a, const Probe &b) { return a.bucket_page_id_ < b.bucket_page_id_; });
+
+    BasicPageGuard next_bucket_guard;
+    for (auto bucket_begin = dir_begin; bucket_begin != dir_end;) {
+      auto bucket_end = std::find_if(bucket_begin, dir_end, [&](const Probe &probe) {
+        return probe.bucket_page_id_ != bucket_begin->bucket_page_id_;
+      });
+      BasicPageGuard bucket_guard = next_bucket_guard.IsValid()
+                                        ? std::move(next_bucket_guard)
+                                        : buffer_pool_manager_->FetchPageBasic(bucket_begin->bucket_page_id_);
+      if (!bucket_guard.IsValid()) {
+        std::transform(bucket_begin, bucket_end, std::back_inserter(retries),
+                       [](const Probe &probe) { return probe.key_idx_; });
+        bucket_begin = bucket_end;
+        continue;
+      }
+      // Bring in the next bucket while this one is probed.
+      if (bucket_end != dir_end) {
+        next_bucket_guard = buffer_pool_manager_->FetchPageBasic(bucket_end->bucket_page_id_);
+        if (next_bucket_guard.IsValid()) {
+          next_bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->Prefetch();
+        }
+      }
+      auto bucket_page_data = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>();
+      bucket_guard.GetPage()->OptimisticRead([&] {
+        for (auto it = bucket_begin; it != bucket_end; ++it) {
+          (*results)[it->key_idx_].clear();
+          bucket_page_data->GetValue(keys[it->key_idx_], comparator_, HashFingerprint(hashes[it->key_idx_]),
+                                     &(*results)[it->key_idx_]);
+        }
+      });
+      // As in GetValue, the reads only count for the keys the directory still maps to the bucket.
+      std::vector<uint32_t> moved;
+      dir_guard.GetPage()->OptimisticRead([&] {
+        moved.clear();
+        uint32_t global_depth_mask = dir_page_data->GetGlobalDepthMask();
+        for (auto it = bucket_begin; it != bucket_end; ++it) {
+          if (dir_page_data->GetBucketPageId(hashes[it->key_idx_] & global_depth_mask) != it->bucket_page_id_) {
+            moved.push_back(it->key_idx_);
+          }
+        }
+      });
+      retries.insert(retries.end(), moved.begin(), moved.end());
+      bucket_begin = bucket_end;
+    }
+    dir_begin = dir_end;
+  }
+  table_latch_.RUnlock();
+
+  for (uint32_t key_idx : retries) {
+    (*results)[key_idx].clear();
+    GetValue(transaction, keys[key_idx], &(*results)[key_idx]);
+  }
+  return std::count_if(results->begin(), results->end(),
+                       [](const std::vector<ValueType> &values) { return !values.empty(); });
+}
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  auto dir_page_data = FetchDirectoryPage();
-  table_latch_.RLock();
   // table lock
-  auto bucket_page_id = KeyToPageId(key, dir_page_data);
-  HASH_TABLE_BUCKET_TYPE *bucket_page_data = FetchBucketPage(bucket_page_id);
-  Page *bucket_page = reinterpret_cast<Page *>(bucket_page_data);
-  // page latch
-  bucket_page->WLatch();
-  // if needing splite
-  if (bucket_page_data->IsFull()) {
-    bucket_page->WUnlatch();
-    table_latch_.RUnlock();
-    buffer_pool_manager_->UnpinPage(bucket_page_id, false);
-    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
-    return SplitInsert(transaction, key, value);
+  table_latch_.RLock();
+  bool res = false;
+  bool is_full = false;
+  {
+    // page latch
+    WritePageGuard bucket_guard = FetchBucketPageWrite(key, nullptr);
+    if (bucket_guard.IsValid()) {
+      // if not needing split
+      is_full = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->IsFull();
+      if (!is_full) {
+        res = bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>()->Insert(key, value, comparator_, HashFingerprint(Hash(key)));
+      }
+    }
   }
-  // otherwise
-  bool res = bucket_page_data->Insert(key, value, comparator_);
-  bucket_page->WUnlatch();
   table_latch_.RUnlock();
-  buffer_pool_manager_->UnpinPage(bucket_page_id, res);  // is_dirty is desided
-  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
-  return res;
+  // otherwise
+  return is_full ? SplitInsert(transaction, key, value) : res;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
   /*
-   * 1. increase the gloabl depth if needed
-   * 2. create a new bucket page
-   * 3. increase the local depths for both
-   * 4. redirect the dir pointer to the new bucket
-   * 5. traverse all the existing pairs and try to split the bucket
-   * 6.1 if the bucket is still full and the insertion fails, try to split once again
-   * 6.2 if the split succeeds, then do the insertion accordingly
+   * 1. move the entries of the full bucket whose next hash bit is set to a new image bucket
+   * 2. increase the global depth if needed, then point the directory slots of the image to it
+   * 3. if the bucket is still full, try to split once again, otherwise insert
+   *
+   * Only the bucket is latched while its entries move, and the directory page only while its slots are updated.
+   * Everyone else latches buckets before the directory when they need both, so this cannot deadlock.
    */
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  table_latch_.WLock();
+  table_latch_.RLock();
+  bool ret;
   while (true) {
-    page_id_t bucket_page_id = KeyToPageId(key, dir_page);
-    uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page);
-    HASH_TABLE_BUCKET_TYPE *bucket_page_data = FetchBucketPage(bucket_page_id);
-    if (bucket_page_data->IsFull()) {
-      // if bucket is full, it needs to split
-      uint32_t global_depth = dir_page->GetGlobalDepth();
-      uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);
-      // new page
-      page_id_t new_bucket_id = 0;
-      HASH_TABLE_BUCKET_TYPE *new_bucket =
-          reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(buffer_pool_manager_->NewPage(&new_bucket_id));
-      // set globle depth++ if needed
-      if (global_depth == local_depth) {
-        // bucket splits and dir_page extands
-        // if i == ij, extand the bucket_page_data dir, and split the bucket_page_data
-        uint32_t bucket_num = 1 << global_depth;
-        // update dir_page's idx
+    uint32_t local_depth;
+    WritePageGuard bucket_guard = FetchBucketPageWrite(key, &local_depth);
+    if (!bucket_guard.IsValid()) {
+      ret = false;
+      break;
+    }
+    auto bucket_page_data = bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+    if (!bucket_page_data->IsFull()) {
+      ret = bucket_page_data->Insert(key, value, comparator_, HashFingerprint(Hash(key)));
+      break;
+    }
+    // if the directory page is full too, split it instead, then try again; that needs the whole table
+    if (local_depth == DIRECTORY_MAX_DEPTH) {
+      bucket_guard.Drop();
+      table_latch_.RUnlock();
+      table_latch_.WLock();
+      bool split = SplitDirectory(key);
+      table_latch_.WUnlock();
+      table_latch_.RLock();
+      if (!split) {
+        ret = false;
+        break;
+      }
+      continue;
+    }
+    // The image is out of reach until the directory points to it, so it needs no latch. The directory page is pinned
+    // before any entry moves, so that running out of frames cannot leave the moved entries out of reach.
+    BasicPageGuard dir_pin = FetchDirectoryPage(key);
+    if (!dir_pin.IsValid()) {
+      ret = false;
+      break;
+    }
+    uint32_t split_bit = 1U << local_depth;
+    page_id_t image_page_id;
+    {
+      BasicPageGuard image_guard = buffer_pool_manager_->NewPageGuarded(&image_page_id);
+      if (!image_guard.IsValid()) {
+        ret = false;
+        break;
+      }
+      auto image_page = image_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+      for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
+        KeyType i_key = bucket_page_data->KeyAt(i);
+        if ((Hash(i_key) & split_bit) != 0) {
+          image_page->Insert(i_key, bucket_page_data->ValueAt(i), comparator_, bucket_page_data->FingerprintAt(i));
+          bucket_page_data->RemoveAt(i);
+        }
+      }
+    }
+    {
+      // cannot fail, the page is pinned already
+      WritePageGuard dir_guard = buffer_pool_manager_->FetchPageWrite(dir_pin.PageId());
+      dir_pin.Drop();
+      auto dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
+      if (dir_page->GetGlobalDepth() == local_depth) {
+        // the bucket has a slot of its own, double the directory first
+        uint32_t bucket_num = dir_page->Size();
         for (uint32_t i = 0; i < bucket_num; i++) {
           dir_page->SetBucketPageId(i + bucket_num, dir_page->GetBucketPageId(i));
           dir_page->SetLocalDepth(i + bucket_num, dir_page->GetLocalDepth(i));
         }
         dir_page->IncrGlobalDepth();
-        dir_page->SetBucketPageId(bucket_idx + bucket_num, new_bucket_id);
-        dir_page->IncrLocalDepth(bucket_idx);
-        dir_page->IncrLocalDepth(bucket_idx + bucket_num);
-        // global_depth++;
-      } else {
-        // if i > ij, split the bucket_page_data
-        // more than one records point to the bucket_page_data
-        // the records' low ij bits are same
-        // and the high (i - ij) bits are index of the records point to the same bucket_page_data
-        /*
-        uint32_t mask = (1 << local_depth) - 1;
-        uint32_t base_idx = mask & bucket_idx;
-        uint32_t records_num = 1 << (global_depth - local_depth - 1);// + high bits
-        uint32_t step = (1 << local_depth);
-        uint32_t idx = base_idx;
-        // divide base_idex which has the same key into two parts
-
-        for (uint32_t i = 0; i < records_num; i++) {
-          dir_page->IncrLocalDepth(idx);
-          idx += step * 2;
-        }
-        idx = base_idx + step;
-        for (uint32_t i = 0; i < records_num; i++) {
-          dir_page->SetBucketPageId(idx, new_bucket_id);
-          dir_page->IncrLocalDepth(idx);
-          idx += step * 2;
-        }*/
-        uint32_t mask = (1 << (local_depth + 1)) - 1;  // merge mask
-        uint32_t new_idx = mask & bucket_idx;
-        uint32_t high_bite = dir_page->GetLocalHighBit(bucket_idx);
-        for (uint32_t i = 0; i < dir_page->Size(); i++) {
-          if ((i & mask) == new_idx) {
-            dir_page->IncrLocalDepth(i);
-          } else if ((i & mask) == (high_bite ^ new_idx)) {
-            dir_page->SetBucketPageId(i, new_bucket_id);
-            dir_page->IncrLocalDepth(i);
+      }
+      // the slots of the bucket are those matching the low local_depth bits of the key's hash
+      uint32_t mask = split_bit - 1;
+      uint32_t bucket_bits = Hash(key) & mask;
+      for (uint32_t i = 0; i < dir_page->Size(); i++) {
+        if ((i & mask) == bucket_bits) {
+          if ((i & split_bit) != 0) {
+            dir_page->SetBucketPageId(i, image_page_id);
           }
+          dir_page->SetLocalDepth(i, local_depth + 1);
         }
       }
-      // dir_page->PrintDirectory();
-      // because dir page idx changed before, so move buckets with idx
-      // rehash all records in bucket_page_data j
-      for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
-        KeyType j_key = bucket_page_data->KeyAt(i);
-        ValueType j_value = bucket_page_data->ValueAt(i);
-        bucket_page_data->RemoveAt(i);
-        if (KeyToPageId(j_key, dir_page) == bucket_page_id) {
-          // in the same bucket
-          bucket_page_data->Insert(j_key, j_value, comparator_);
-        } else {
-          // move to new bucket
-          new_bucket->Insert(j_key, j_value, comparator_);
-        }
+    }
+  }
+  table_latch_.RUnlock();
+  return ret;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::SplitDirectory(const KeyType &key) -> bool {
+  // The header page stays pinned, so that the split cannot fail once the image pages are filled in.
+  BasicPageGuard header_guard = buffer_pool_manager_->FetchPageBasic(header_page_id_);
+  if (!header_guard.IsValid()) {
+    return false;
+  }
+  uint32_t header_idx = KeyToHeaderIndex(key, header_guard.As<ExtendibleHashTableHeaderPage>());
+  uint32_t local_depth = header_guard.As<ExtendibleHashTableHeaderPage>()->GetLocalDepth(header_idx);
+  if (local_depth == HEADER_MAX_DEPTH) {
+    return false;
+  }
+  page_id_t directory_page_id = header_guard.As<ExtendibleHashTableHeaderPage>()->GetDirectoryPageId(header_idx);
+  // The hash bit that tells the entries of the two halves apart.
+  uint32_t split_bit = 1U << (DIRECTORY_MAX_DEPTH + local_depth);
+
+  // Work on a copy of the directory page, so that only the bucket being split and its image are pinned at a time.
+  uint32_t global_depth;
+  std::vector<page_id_t> bucket_page_ids;
+  std::vector<uint32_t> local_depths;
+  {
+    BasicPageGuard dir_guard = buffer_pool_manager_->FetchPageBasic(directory_page_id);
+    if (!dir_guard.IsValid()) {
+      return false;
+    }
+    auto dir_page = dir_guard.As<HashTableDirectoryPage>();
+    global_depth = dir_page->GetGlobalDepth();
+    for (uint32_t i = 0; i < dir_page->Size(); i++) {
+      bucket_page_ids.push_back(dir_page->GetBucketPageId(i));
+      local_depths.push_back(dir_page->GetLocalDepth(i));
+    }
+  }
+
+  // Copy the entries with the split bit set from each bucket to a new image bucket. The buckets are left as they are
+  // until the header points to the images, so running out of frames before then only costs the images.
+  std::unordered_map<page_id_t, page_id_t> image_page_ids;
+  auto discard_images = [&] {
+    for (const auto &[bucket_page_id, image_page_id] : image_page_ids) {
+      if (!buffer_pool_manager_->DeletePage(image_page_id)) {
+        freed_bucket_pages_.push_back(image_page_id);
+      }
+    }
+  };
+  for (page_id_t bucket_page_id : bucket_page_ids) {
+    if (image_page_ids.count(bucket_page_id) > 0) {
+      continue;
+    }
+    page_id_t image_page_id;
+    BasicPageGuard image_guard = buffer_pool_manager_->NewPageGuarded(&image_page_id);
+    if (!image_guard.IsValid()) {
+      discard_images();
+      return false;
+    }
+    image_page_ids[bucket_page_id] = image_page_id;
+    BasicPageGuard bucket_guard = buffer_pool_manager_->FetchPageBasic(bucket_page_id);
+    if (!bucket_guard.IsValid()) {
+      image_guard.Drop();
+      discard_images();
+      return false;
+    }
+    auto image_page = image_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+    auto bucket_page = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>();
+    for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
+      if (bucket_page->IsReadable(i) && (Hash(bucket_page->KeyAt(i)) & split_bit) != 0) {
+        image_page->Insert(bucket_page->KeyAt(i), bucket_page->ValueAt(i), comparator_, bucket_page->FingerprintAt(i));
+      }
+    }
+  }
+
+  // The image directory page has the same layout, over the image buckets.
+  page_id_t image_directory_page_id;
+  {
+    BasicPageGuard image_dir_guard = buffer_pool_manager_->NewPageGuarded(&image_directory_page_id);
+    if (!image_dir_guard.IsValid()) {
+      discard_images();
+      return false;
+    }
+    auto image_dir_page = image_dir_guard.AsMut<HashTableDirectoryPage>();
+    image_dir_page->SetPageId(image_directory_page_id);
+    for (uint32_t i = 0; i < global_depth; i++) {
+      image_dir_page->IncrGlobalDepth();
+    }
+    for (uint32_t i = 0; i < bucket_page_ids.size(); i++) {
+      image_dir_page->SetBucketPageId(i, image_page_ids[bucket_page_ids[i]]);
+      image_dir_page->SetLocalDepth(i, local_depths[i]);
+    }
+  }
+
+  // Point the header slots of the directory page that have the split bit set to the image, growing the header first
+  // if the directory page has a slot of its own.
+  auto header_page = header_guard.AsMut<ExtendibleHashTableHeaderPage>();
+  if (header_page->GetGlobalDepth() == local_depth) {
+    header_page->IncrGlobalDepth();
+  }
+  uint32_t local_mask = (1U << local_depth) - 1;
+  for (uint32_t i = 0; i < header_page->Size(); i++) {
+    if ((i & local_mask) == (header_idx & local_mask)) {
+      header_page->SetLocalDepth(i, local_depth + 1);
+      if ((i & (1U << local_depth)) != 0) {
+        header_page->SetDirectoryPageId(i, image_directory_page_id);
+      }
+    }
+  }
+  header_guard.Drop();
+
+  // The copies left in the buckets are out of reach now, lookups of their keys go to the images. A bucket that cannot
+  // be fetched keeps them as dead entries, which only cost space.
+  for (const auto &[bucket_page_id, image_page_id] : image_page_ids) {
+    BasicPageGuard bucket_guard = buffer_pool_manager_->FetchPageBasic(bucket_page_id);
+    if (!bucket_guard.IsValid()) {
+      LOG_WARN("bucket page %d keeps the entries moved by a directory split", bucket_page_id);
+      continue;
+    }
+    auto bucket_page = bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+    for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
+      if (bucket_page->IsReadable(i) && (Hash(bucket_page->KeyAt(i)) & split_bit) != 0) {
+        bucket_page->RemoveAt(i);
       }
-      // std::cout<<"original bucket_page_data size = "<<bucket_page_data->NumReadable()<<std::endl;
-      // std::cout<<"new bucket_page_data size = "<<new_bucket->NumReadable()<<std::endl;
-      buffer_pool_manager_->UnpinPage(bucket_page_id, true);
-      buffer_pool_manager_->UnpinPage(new_bucket_id, true);
-    } else {
-      bool ret = bucket_page_data->Insert(key, value, comparator_);
-      table_latch_.WUnlock();
-      // std::cout<<"find the unfull bucket_page_data"<<std::endl;
-      buffer_pool_manager_->UnpinPage(directory_page_id_, true);
-      buffer_pool_manager_->UnpinPage(bucket_page_id, true);
-      return ret;
     }
   }
+  return true;
 }
 
 /*****************************************************************************
@@ -237,28 +547,35 @@ auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  auto dir_page_data = FetchDirectoryPage();
-  table_latch_.RLock();
   // table lock
-  auto bucket_page_id = KeyToPageId(key, dir_page_data);
-  auto bucket_idx = KeyToDirectoryIndex(key, dir_page_data);
-  HASH_TABLE_BUCKET_TYPE *bucket_page_data = FetchBucketPage(bucket_page_id);
-  Page *bucket_page = reinterpret_cast<Page *>(bucket_page_data);
-  // page latch
-  bucket_page->WLatch();
-  // remove first
-  bool res = bucket_page_data->Remove(key, value, comparator_);
-  bucket_page->WUnlatch();
-  // if it turned into empty, merge is needed
-  if (bucket_page_data->IsEmpty() && dir_page_data->GetLocalDepth(bucket_idx) != 0) {
-    table_latch_.RUnlock();
-    Merge(transaction, key, value);
-  } else {
-    // if it doesn't need to merge
-    table_latch_.RUnlock();
-  }
-  buffer_pool_manager_->UnpinPage(bucket_page_id, true);  // is_dirty is decided
-  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RLock();
+  bool res = false;
+  bool needs_merge = false;
+  {
+    // page latch
+    uint32_t local_depth;
+    WritePageGuard bucket_guard = FetchBucketPageWrite(key, &local_depth);
+    if (bucket_guard.IsValid()) {
+      auto bucket_page_data = bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+      // remove first
+      res = bucket_page_data->Remove(key, value, comparator_, HashFingerprint(Hash(key)));
+      // if it turned empty or underfull, try to merge it; only on the remove that crosses the threshold, so that the
+      // removes from a bucket whose split image is too full to merge with do not all take the table latch
+      uint32_t num_readable = bucket_page_data->NumReadable();
+      needs_merge = res && (num_readable == 0 || num_readable == UNDERFULL_THRESHOLD) && local_depth != 0;
+    }
+  }
+  table_latch_.RUnlock();
+  if (needs_merge) {
+    std::unique_lock<std::mutex> lock(compactor_latch_);
+    if (compactor_.joinable() && !compactor_stop_) {
+      // leave the merge to the compactor
+      merge_candidates_.push_back(key);
+    } else {
+      lock.unlock();
+      Merge(transaction, key, value);
+    }
+  }
   return res;
 }
 
@@ -267,104 +584,191 @@ auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
   table_latch_.WLock();
-  // bool is_glowing = false;
-  uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page);
-  page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
-  HASH_TABLE_BUCKET_TYPE *bucket = FetchBucketPage(bucket_page_id);
-  if (bucket->IsEmpty() && dir_page->GetLocalDepth(bucket_idx) != 0) {
+  BasicPageGuard dir_guard = FetchDirectoryPage(key);
+  if (dir_guard.IsValid()) {
+    auto dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
+    MergeBucket(dir_page, KeyToDirectoryIndex(key, dir_page));
+    dir_page->Shrink();
+    dir_guard.Drop();
+  }
+  DeleteFreedBucketPages();
+  table_latch_.WUnlock();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::MergeBucket(HashTableDirectoryPage *dir_page, uint32_t bucket_idx) {
+  while (dir_page->GetLocalDepth(bucket_idx) != 0) {
     uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);
-    // uint32_t global_depth = dir_page->GetGlobalDepth();
-    // How to find the bucket to Merge?
-    // Answer: After Merge, the records, which pointed to the Merged Bucket,
-    // have low (local_depth - 1) bits same
-    // therefore, reverse the low local_depth can get the idx point to the bucket to Merge
-    uint32_t merged_bucket_idx = bucket_idx ^ (1 << (local_depth - 1));
-    page_id_t merged_page_id = dir_page->GetBucketPageId(merged_bucket_idx);
-    // HASH_TABLE_BUCKET_TYPE *merged_bucket = FetchBucketPage(merged_page_id);
-    if (dir_page->GetLocalDepth(merged_bucket_idx) == local_depth) {
-      // check merge page's merge page is empty or not.
-      // if it is empty, let merge page merge in loop , then merge with this page last
-      // because the first merge page must be not empty
-      dir_page->DecrLocalDepth(merged_bucket_idx);
-      uint32_t merged_depth = dir_page->GetLocalDepth(merged_bucket_idx);
-      uint32_t merge2_bucket_idx = merged_bucket_idx ^ (0x1 << merged_depth);
-      while (dir_page->GetLocalDepth(merged_bucket_idx) == dir_page->GetLocalDepth(merge2_bucket_idx) &&
-             dir_page->GetLocalDepth(merged_bucket_idx) > 0) {
-        page_id_t merge2_bucket_id = dir_page->GetBucketPageId(merge2_bucket_idx);
-        HASH_TABLE_BUCKET_TYPE *merge_bucket = FetchBucketPage(merge2_bucket_id);
-        if (merge_bucket->IsEmpty()) {
-          dir_page->DecrLocalDepth(merged_bucket_idx);
-          merge2_bucket_idx = merge2_bucket_idx ^ (0x1 << (dir_page->GetLocalDepth(merged_bucket_idx)));
-          buffer_pool_manager_->DeletePage(merge2_bucket_id);
-        } else {
-          buffer_pool_manager_->UnpinPage(merge2_bucket_id, false);
-        }
+    uint32_t image_idx = dir_page->GetSplitImageIndex(bucket_idx);
+    if (dir_page->GetLocalDepth(image_idx) != local_depth) {
+      // the split image is split further, it has to merge first
+      return;
+    }
+    page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+    page_id_t image_page_id = dir_page->GetBucketPageId(image_idx);
+    BasicPageGuard bucket_guard = buffer_pool_manager_->FetchPageBasic(bucket_page_id);
+    BasicPageGuard image_guard = buffer_pool_manager_->FetchPageBasic(image_page_id);
+    if (!bucket_guard.IsValid() || !image_guard.IsValid()) {
+      return;
+    }
+    auto bucket_page = bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+    auto image_page = image_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+    uint32_t num_readable = bucket_page->NumReadable();
+    uint32_t image_num_readable = image_page->NumReadable();
+    // Merge an empty bucket in any case, underfull ones only if the merged bucket is at most half full, so that it
+    // does not split again right away.
+    if (num_readable != 0 && image_num_readable != 0 && num_readable + image_num_readable > BUCKET_ARRAY_SIZE / 2) {
+      return;
+    }
+    // Move the entries of the emptier bucket to the other one, which takes the place of both.
+    if (num_readable > image_num_readable) {
+      std::swap(bucket_page, image_page);
+      std::swap(bucket_page_id, image_page_id);
+    }
+    for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
+      if (bucket_page->IsReadable(i)) {
+        image_page->Insert(bucket_page->KeyAt(i), bucket_page->ValueAt(i), comparator_, bucket_page->FingerprintAt(i));
       }
-
-      // if(merged_bucket->IsEmpty()) is_glowing =true;
-      /*
-      local_depth--;
-      uint32_t mask = (1 << local_depth) - 1;
-      uint32_t idx = mask & bucket_idx;
-      uint32_t records_num = 1 << (global_depth - local_depth);
-      uint32_t step = (1 << local_depth);
-      // basic_index lead to same merge_page
-      for (uint32_t i = 0; i < records_num; i++) {
-        dir_page->SetBucketPageId(idx, merged_page_id);
-        dir_page->DecrLocalDepth(idx);
-        idx += step;
+    }
+    uint32_t mask = (1U << (local_depth - 1)) - 1;
+    for (uint32_t i = 0; i < dir_page->Size(); i++) {
+      if ((i & mask) == (bucket_idx & mask)) {
+        dir_page->SetBucketPageId(i, image_page_id);
+        dir_page->SetLocalDepth(i, local_depth - 1);
       }
-       */
-      local_depth = dir_page->GetLocalDepth(merged_bucket_idx);
-      uint32_t mask = (1 << (local_depth)) - 1;  // merge mask
-      uint32_t old_idx = mask & bucket_idx;
-      // uint32_t high_bite = dir_page->GetLocalHighBit(bucket_idx);
-      for (uint32_t i = 0; i < dir_page->Size(); i++) {
-        if ((i & mask) == old_idx) {
-          dir_page->SetBucketPageId(i, merged_page_id);
-          dir_page->SetLocalDepth(i, dir_page->GetLocalDepth(merged_bucket_idx));
+    }
+    // The freed bucket page goes back to the buffer pool. The flush path or the background writer may have it pinned
+    // for a moment, then it is deleted by a later merge.
+    bucket_guard.Drop();
+    image_guard.Drop();
+    if (!buffer_pool_manager_->DeletePage(bucket_page_id)) {
+      freed_bucket_pages_.push_back(bucket_page_id);
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::DeleteFreedBucketPages() {
+  auto it = std::remove_if(freed_bucket_pages_.begin(), freed_bucket_pages_.end(),
+                           [&](page_id_t page_id) { return buffer_pool_manager_->DeletePage(page_id); });
+  freed_bucket_pages_.erase(it, freed_bucket_pages_.end());
+}
+
+/*****************************************************************************
+ * COMPACTION
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::Compact() {
+  table_latch_.WLock();
+  for (page_id_t directory_page_id : GetDirectoryPageIds()) {
+    BasicPageGuard dir_guard = buffer_pool_manager_->FetchPageBasic(directory_page_id);
+    if (!dir_guard.IsValid()) {
+      continue;
+    }
+    auto dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
+    // A merge goes on with the merged bucket's own split image, so one pass over the slots reaches all pairs.
+    for (uint32_t i = 0; i < dir_page->Size(); i++) {
+      MergeBucket(dir_page, i);
+    }
+    dir_page->Shrink();
+  }
+  DeleteFreedBucketPages();
+  table_latch_.WUnlock();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::StartCompactor(std::chrono::milliseconds interval) {
+  std::scoped_lock lock(compactor_latch_);
+  if (compactor_.joinable()) {
+    return;
+  }
+  compactor_stop_ = false;
+  compactor_ = std::thread(&HASH_TABLE_TYPE::RunCompactor, this, interval);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::StopCompactor() {
+  std::unique_lock<std::mutex> lock(compactor_latch_);
+  if (!compactor_.joinable()) {
+    return;
+  }
+  compactor_stop_ = true;
+  lock.unlock();
+  compactor_cv_.notify_all();
+  compactor_.join();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::RunCompactor(std::chrono::milliseconds interval) {
+  std::unique_lock<std::mutex> lock(compactor_latch_);
+  // The candidates left when the compactor is stopped are merged before it exits.
+  while (true) {
+    bool stop = compactor_cv_.wait_for(lock, interval, [&] { return compactor_stop_; });
+    std::vector<KeyType> candidates;
+    candidates.swap(merge_candidates_);
+    lock.unlock();
+    if (!candidates.empty()) {
+      table_latch_.WLock();
+      for (const auto &key : candidates) {
+        BasicPageGuard dir_guard = FetchDirectoryPage(key);
+        if (!dir_guard.IsValid()) {
+          continue;
         }
+        auto dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
+        MergeBucket(dir_page, KeyToDirectoryIndex(key, dir_page));
+        dir_page->Shrink();
       }
-      buffer_pool_manager_->DeletePage(bucket_page_id);
-      buffer_pool_manager_->UnpinPage(merged_page_id, true);
+      DeleteFreedBucketPages();
+      table_latch_.WUnlock();
     }
-    if (dir_page->CanShrink()) {
-      dir_page->DecrGlobalDepth();
+    if (stop) {
+      return;
     }
-    buffer_pool_manager_->UnpinPage(bucket_page_id, true);
-    buffer_pool_manager_->UnpinPage(merged_page_id, true);
+    lock.lock();
   }
-  table_latch_.WUnlock();
-  buffer_pool_manager_->UnpinPage(directory_page_id_, true);
-  // buffer_pool_manager_->UnpinPage(bucket_page_id, true);
-  // if(is_glowing) Merge(transaction, key, value);
 }
 
 /*****************************************************************************
- * GETGLOBALDEPTH - DO NOT TOUCH
+ * GETGLOBALDEPTH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetGlobalDepth() -> uint32_t {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  uint32_t global_depth = dir_page->GetGlobalDepth();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  uint32_t global_depth = 0;
+  for (page_id_t directory_page_id : GetDirectoryPageIds()) {
+    // latched, bucket splits update directory pages under a read table lock
+    ReadPageGuard dir_guard = buffer_pool_manager_->FetchPageRead(directory_page_id);
+    BUSTUB_ASSERT(dir_guard.IsValid(), "Couldn't fetch a directory page of the hash table.");
+    global_depth = std::max(global_depth, dir_guard.As<HashTableDirectoryPage>()->GetGlobalDepth());
+  }
+  {
+    BasicPageGuard header_guard = buffer_pool_manager_->FetchPageBasic(header_page_id_);
+    BUSTUB_ASSERT(header_guard.IsValid(), "Couldn't fetch the header page of the hash table.");
+    global_depth += header_guard.As<ExtendibleHashTableHeaderPage>()->GetGlobalDepth();
+  }
   table_latch_.RUnlock();
   return global_depth;
 }
 
 /*****************************************************************************
- * VERIFY INTEGRITY - DO NOT TOUCH
+ * VERIFY INTEGRITY
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::VerifyIntegrity() {
-  table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  dir_page->VerifyIntegrity();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
-  table_latch_.RUnlock();
+  // exclusive, so that no bucket split is halfway through
+  table_latch_.WLock();
+  {
+    BasicPageGuard header_guard = buffer_pool_manager_->FetchPageBasic(header_page_id_);
+    BUSTUB_ASSERT(header_guard.IsValid(), "Couldn't fetch the header page of the hash table.");
+    header_guard.As<ExtendibleHashTableHeaderPage>()->VerifyIntegrity();
+  }
+  for (page_id_t directory_page_id : GetDirectoryPageIds()) {
+    BasicPageGuard dir_guard = buffer_pool_manager_->FetchPageBasic(directory_page_id);
+    BUSTUB_ASSERT(dir_guard.IsValid(), "Couldn't fetch a directory page of the hash table.");
+    dir_guard.As<HashTableDirectoryPage>()->VerifyIntegrity();
+  }
+  table_latch_.WUnlock();
 }
 
 /*****************************************************************************
@@ -38,11 +38,13 @@ auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
   Tuple tuple_insert;
   RID rid_insert;
   Transaction *txn = exec_ctx_->GetTransaction();
+  // Inserting more than a single row is a bulk write.
+  BufferAccessStrategy *strategy = (!from_insert_ || size_ > 1) ? &bulk_write_strategy_ : nullptr;
   if (from_insert_) {
     for (uint32_t idx = 0; idx < size_; idx++) {
       std::vector<Value> value = plan_->RawValuesAt(idx);
       tuple_insert = Tuple(value, &table_info_->schema_);
-      if (table_info_->table_->InsertTuple(tuple_insert, &rid_insert, txn)) {
+      if (table_info_->table_->InsertTuple(tuple_insert, &rid_insert, txn, strategy)) {
         for (auto index : indexes_) {
           index->index_->InsertEntry(
               tuple_insert.KeyFromTuple(table_info_->schema_, index->key_schema_, index->index_->GetKeyAttrs()),
@@ -53,7 +55,7 @@ auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
     return false;
   }
   while (child_executor_->Next(&tuple_insert, &rid_insert)) {
-    if (table_info_->table_->InsertTuple(tuple_insert, &rid_insert, txn)) {
+    if (table_info_->table_->InsertTuple(tuple_insert, &rid_insert, txn, strategy)) {
       for (auto index : indexes_) {
         index->index_->InsertEntry(tuple_insert.KeyFromTuple(*child_executor_->GetOutputSchema(), index->key_schema_,
                                                              index->index_->GetKeyAttrs()),
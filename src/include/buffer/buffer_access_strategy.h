@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** How an operation is going to access the pages it fetches. */
+enum class AccessStrategyType {
+  /** Random access, pages compete for the whole buffer pool. */
+  NORMAL,
+  /** A large sequential read, each page is read once. */
+  SEQUENTIAL_SCAN,
+  /** A large sequential write, e.g. a bulk insert. */
+  BULK_WRITE
+};
+
+/**
+ * BufferAccessStrategy is a hint passed to FetchPage and NewPage by an operation that touches many pages once, so that
+ * it does not flush the pages other operations keep using out of the buffer pool.
+ *
+ * A SEQUENTIAL_SCAN or BULK_WRITE strategy owns a small ring of frames in every buffer pool instance. When a page has
+ * to be read in, the frame of the ring that was filled longest ago is recycled if it still holds the page this
+ * strategy put there and nobody has it pinned. Otherwise a victim is picked as usual and joins the ring. The operation
+ * therefore only ever evicts the pages of its ring once the ring is full.
+ *
+ * A strategy holds the state of one operation and is not thread-safe.
+ */
+class BufferAccessStrategy {
+ public:
+  /**
+   * Creates a new BufferAccessStrategy.
+   * @param type the access strategy type
+   */
+  explicit BufferAccessStrategy(AccessStrategyType type) : type_(type) {}
+
+  /** @return the access strategy type */
+  auto GetType() const -> AccessStrategyType { return type_; }
+
+  /** @return the number of frames in the ring of every buffer pool instance, 0 for no ring */
+  auto GetRingSize() const -> size_t {
+    switch (type_) {
+      case AccessStrategyType::SEQUENTIAL_SCAN:
+        return SEQUENTIAL_SCAN_RING_SIZE;
+      case AccessStrategyType::BULK_WRITE:
+        return BULK_WRITE_RING_SIZE;
+      default:
+        return 0;
+    }
+  }
+
+  /**
+   * @return the size of the smallest ring set up in a buffer pool instance so far, GetRingSize() if none. Buffer pool
+   * instances cap the ring to a share of their frames, so it can be smaller than GetRingSize().
+   */
+  auto GetMinRingSize() const -> size_t {
+    size_t ring_size = GetRingSize();
+    for (const auto &ring : rings_) {
+      if (!ring.slots_.empty()) {
+        ring_size = std::min(ring_size, ring.slots_.size());
+      }
+    }
+    return ring_size;
+  }
+
+ private:
+  friend class BufferPoolManagerInstance;
+
+  /** A frame of the ring, along with the page this strategy last put into it. */
+  struct RingSlot {
+    frame_id_t frame_id_{INVALID_PAGE_ID};
+    page_id_t page_id_{INVALID_PAGE_ID};
+  };
+
+  /** The ring of a buffer pool instance. */
+  struct Ring {
+    std::vector<RingSlot> slots_;
+    size_t next_slot_{0};
+  };
+
+  /**
+   * Advance the ring of a buffer pool instance to its next slot.
+   * @param instance_index index of the buffer pool instance
+   * @param ring_size size of the ring in that instance
+   * @return the slot to recycle
+   */
+  auto NextRingSlot(uint32_t instance_index, size_t ring_size) -> RingSlot & {
+    if (rings_.size() <= instance_index) {
+      rings_.resize(instance_index + 1);
+    }
+    Ring &ring = rings_[instance_index];
+    if (ring.slots_.size() != ring_size) {
+      ring.slots_.resize(ring_size);
+    }
+    RingSlot &slot = ring.slots_[ring.next_slot_ % ring_size];
+    ring.next_slot_ = (ring.next_slot_ + 1) % ring_size;
+    return slot;
+  }
+
+  const AccessStrategyType type_;
+  /** Rings, indexed by buffer pool instance. */
+  std::vector<Ring> rings_;
+};
+
+}  // namespace bustub
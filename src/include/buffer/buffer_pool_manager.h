@@ -15,11 +15,14 @@
 #include <list>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_access_strategy.h"
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -45,6 +48,49 @@ class BufferPoolManager {
     return result;
   }
 
+  /**
+   * Fetch a page, following an access strategy.
+   * @param page_id id of page to be fetched
+   * @param strategy how the caller is going to access the pages it fetches
+   * @return the requested page
+   */
+  auto FetchPage(page_id_t page_id, BufferAccessStrategy &strategy) -> Page * {
+    return FetchPgWithStrategyImp(page_id, &strategy);
+  }
+
+  /**
+   * Fetch a page, pinned until the returned guard is dropped.
+   * @param page_id id of page to be fetched
+   * @return a guard of the requested page, empty if the page could not be fetched
+   */
+  auto FetchPageBasic(page_id_t page_id) -> BasicPageGuard { return {this, FetchPgImp(page_id)}; }
+
+  /**
+   * Fetch a page and read latch it, pinned and latched until the returned guard is dropped.
+   * @param page_id id of page to be fetched
+   * @return a guard of the requested page, empty if the page could not be fetched
+   */
+  auto FetchPageRead(page_id_t page_id) -> ReadPageGuard {
+    Page *page = FetchPgImp(page_id);
+    if (page != nullptr) {
+      page->RLatch();
+    }
+    return {this, page};
+  }
+
+  /**
+   * Fetch a page and write latch it, pinned and latched until the returned guard is dropped.
+   * @param page_id id of page to be fetched
+   * @return a guard of the requested page, empty if the page could not be fetched
+   */
+  auto FetchPageWrite(page_id_t page_id) -> WritePageGuard {
+    Page *page = FetchPgImp(page_id);
+    if (page != nullptr) {
+      page->WLatch();
+    }
+    return {this, page};
+  }
+
   /** Grading function. Do not modify! */
   auto UnpinPage(page_id_t page_id, bool is_dirty, bufferpool_callback_fn callback = nullptr) -> bool {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
@@ -69,6 +115,48 @@ class BufferPoolManager {
     return result;
   }
 
+  /**
+   * Create a new page, following an access strategy.
+   * @param[out] page_id id of created page
+   * @param strategy how the caller is going to access the pages it creates
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPage(page_id_t *page_id, BufferAccessStrategy &strategy) -> Page * {
+    return NewPgWithStrategyImp(page_id, &strategy);
+  }
+
+  /**
+   * Pin a page only if it is already in the buffer pool, without doing or waiting for any I/O. Unpin it like a fetched
+   * page.
+   * @param page_id id of the page
+   * @return the page, or nullptr if it is not resident or is still being read in
+   */
+  auto FetchPageIfResident(page_id_t page_id) -> Page * { return FetchPgIfResidentImp(page_id); }
+
+  /**
+   * Start reading pages into the buffer pool without waiting for them, so that a later FetchPage finds them resident.
+   * Prefetched pages are left unpinned. This is only a hint: pages already resident or without a free frame to go to
+   * are skipped.
+   * @param page_ids ids of the pages to prefetch
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids) { PrefetchPgsImp(page_ids, nullptr); }
+
+  /**
+   * Start reading pages into the buffer pool without waiting for them, following an access strategy.
+   * @param page_ids ids of the pages to prefetch
+   * @param strategy how the caller is going to access the pages it prefetches
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids, BufferAccessStrategy &strategy) {
+    PrefetchPgsImp(page_ids, &strategy);
+  }
+
+  /**
+   * Create a new page, pinned until the returned guard is dropped.
+   * @param[out] page_id id of created page
+   * @return a guard of the new page, empty if no new pages could be created
+   */
+  auto NewPageGuarded(page_id_t *page_id) -> BasicPageGuard { return {this, NewPgImp(page_id)}; }
+
   /** Grading function. Do not modify! */
   auto DeletePage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) -> bool {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
@@ -108,6 +196,18 @@ class BufferPoolManager {
    */
   virtual auto FetchPgImp(page_id_t page_id) -> Page * = 0;
 
+  /**
+   * Fetch the requested page from the buffer pool, following an access strategy. Buffer pools without ring support
+   * ignore the strategy.
+   * @param page_id id of page to be fetched
+   * @param strategy how the caller is going to access the pages it fetches
+   * @return the requested page
+   */
+  virtual auto FetchPgWithStrategyImp(page_id_t page_id, __attribute__((unused)) BufferAccessStrategy *strategy)
+      -> Page * {
+    return FetchPgImp(page_id);
+  }
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -130,6 +230,35 @@ class BufferPoolManager {
    */
   virtual auto NewPgImp(page_id_t *page_id) -> Page * = 0;
 
+  /**
+   * Creates a new page in the buffer pool, following an access strategy. Buffer pools without ring support ignore the
+   * strategy.
+   * @param[out] page_id id of created page
+   * @param strategy how the caller is going to access the pages it creates
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual auto NewPgWithStrategyImp(page_id_t *page_id, __attribute__((unused)) BufferAccessStrategy *strategy)
+      -> Page * {
+    return NewPgImp(page_id);
+  }
+
+  /**
+   * Pin a page only if it is already in the buffer pool, without doing or waiting for any I/O. Buffer pools that cannot
+   * tell without blocking report every page as absent.
+   * @param page_id id of the page
+   * @return the page, or nullptr if it is not resident or is still being read in
+   */
+  virtual auto FetchPgIfResidentImp(__attribute__((unused)) page_id_t page_id) -> Page * { return nullptr; }
+
+  /**
+   * Start reading pages into the buffer pool without waiting for them. Buffer pools without asynchronous reads ignore
+   * the hint.
+   * @param page_ids ids of the pages to prefetch
+   * @param strategy how the caller is going to access the pages it prefetches, nullptr for NORMAL
+   */
+  virtual void PrefetchPgsImp(__attribute__((unused)) const std::vector<page_id_t> &page_ids,
+                              __attribute__((unused)) BufferAccessStrategy *strategy) {}
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -12,18 +12,90 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <list>
-#include <mutex>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <set>
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/frame_arena.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
+#include "storage/disk/async_disk_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
 
 namespace bustub {
 
+/** Knobs of the background writer of a buffer pool instance. */
+struct BackgroundWriterOptions {
+  /** Percentage of the pool, taken in eviction order, that the writer tries to keep clean. */
+  size_t clean_target_percent_{BACKGROUND_WRITER_CLEAN_TARGET_PERCENT};
+  /** The most pages written per round, which caps the I/O rate of the writer. */
+  size_t max_pages_per_round_{BACKGROUND_WRITER_MAX_PAGES_PER_ROUND};
+  /** Time between two rounds. */
+  std::chrono::milliseconds interval_{BACKGROUND_WRITER_INTERVAL_MS};
+};
+
+/** Occupancy, caching and contention counters of a buffer pool instance, or the sum of those of several. */
+struct BufferPoolInstanceStats {
+  /** Number of frames in the pool. */
+  size_t pool_size_{0};
+  /** Frames in the free list, which new pages get without evicting anything. */
+  size_t num_free_frames_{0};
+  /** Pages created in this instance. */
+  uint64_t num_new_pages_{0};
+  /** Calls to fetch a page. */
+  uint64_t num_fetches_{0};
+  /** Fetches that found the page in the pool, or being read in by another thread. */
+  uint64_t num_hits_{0};
+  /** Fetches that read the page from disk. */
+  uint64_t num_misses_{0};
+  /** Pages evicted that were clean, so that their frame could be reused right away. */
+  uint64_t num_clean_evictions_{0};
+  /** Pages evicted that were dirty and had to be written back first. */
+  uint64_t num_dirty_evictions_{0};
+  /** Fetches and new pages that returned nullptr because all frames were pinned. */
+  uint64_t num_pin_failures_{0};
+  /** Dirty victims written out by the fetch or new page call that evicted them. */
+  uint64_t num_sync_writes_{0};
+  /** Dirty pages written out ahead of their eviction by the background writer. */
+  uint64_t num_background_writes_{0};
+  /** Times the instance latch was taken, by misses, new pages, prefetches and deletes. */
+  uint64_t num_latch_acquisitions_{0};
+  /** Times the instance latch was held by another thread and had to be waited for. */
+  uint64_t num_latch_waits_{0};
+
+  /** @return the share of the fetches that were hits, 0 if there were none */
+  auto HitRatio() const -> double { return num_fetches_ == 0 ? 0 : static_cast<double>(num_hits_) / num_fetches_; }
+
+  /** Add the counters of other to these. */
+  void Add(const BufferPoolInstanceStats &other) {
+    pool_size_ += other.pool_size_;
+    num_free_frames_ += other.num_free_frames_;
+    num_new_pages_ += other.num_new_pages_;
+    num_fetches_ += other.num_fetches_;
+    num_hits_ += other.num_hits_;
+    num_misses_ += other.num_misses_;
+    num_clean_evictions_ += other.num_clean_evictions_;
+    num_dirty_evictions_ += other.num_dirty_evictions_;
+    num_pin_failures_ += other.num_pin_failures_;
+    num_sync_writes_ += other.num_sync_writes_;
+    num_background_writes_ += other.num_background_writes_;
+    num_latch_acquisitions_ += other.num_latch_acquisitions_;
+    num_latch_waits_ += other.num_latch_waits_;
+  }
+};
+
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
@@ -34,8 +106,13 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy
+   * @param replacer_k the K of an LRU-K replacer
+   * @param correlated_reference_period the correlated reference period of an LRU-K replacer, in clock ticks
    */
-  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU, size_t replacer_k = LRUK_REPLACER_K,
+                            uint64_t correlated_reference_period = LRUK_CORRELATED_REFERENCE_PERIOD);
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
@@ -43,9 +120,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param instance_index index of this BPI in the parallel BPM
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy
+   * @param replacer_k the K of an LRU-K replacer
+   * @param correlated_reference_period the correlated reference period of an LRU-K replacer, in clock ticks
    */
   BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                            DiskManager *disk_manager, LogManager *log_manager = nullptr);
+                            DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU, size_t replacer_k = LRUK_REPLACER_K,
+                            uint64_t correlated_reference_period = LRUK_CORRELATED_REFERENCE_PERIOD);
 
   /**
    * Destroys an existing BufferPoolManagerInstance.
@@ -58,6 +140,81 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @return pointer to all the pages in the buffer pool */
   auto GetPages() -> Page * { return pages_; }
 
+  /**
+   * Start a background thread that writes out cold dirty pages ahead of their eviction, so that foreground fetches
+   * find clean victims and do not pay for the write. Every round, it writes the dirty pages among the next frames
+   * the replacer would victimize, up to the clean target. Does nothing if the writer is already running.
+   * @param options the knobs of the writer
+   */
+  void StartBackgroundWriter(const BackgroundWriterOptions &options = {});
+
+  /** Stop the background writer and wait for it to exit. Does nothing if it is not running. */
+  void StopBackgroundWriter();
+
+  /** @return the number of dirty victims written out by the fetch or new page call that evicted them */
+  auto GetNumSyncWrites() const -> uint64_t { return num_sync_writes_; }
+
+  /** @return the number of dirty pages written out ahead of their eviction by the background writer */
+  auto GetNumBackgroundWrites() const -> uint64_t { return num_background_writes_; }
+
+  /**
+   * First step of a batched flush: list the dirty pages, without pinning them.
+   * @param[out] page_ids the ids of the dirty pages are appended to it, in no particular order
+   */
+  void CollectDirtyPages(std::vector<page_id_t> *page_ids);
+
+  /**
+   * Second step of a batched flush, for one batch of the pages listed by CollectDirtyPages: pin the pages, so that
+   * they stay in their frames, and mark them clean, so that modifications made while they are written are not lost.
+   * Pages that have been evicted or written out since, or whose frame is still being read in or filled, are skipped.
+   * @param page_ids the pages to pin
+   * @param[out] pages the pinned pages are appended to it, in the order of page_ids
+   */
+  void PinDirtyPages(const std::vector<page_id_t> &page_ids, std::vector<DiskManager::PageWrite> *pages);
+
+  /**
+   * Last step of a batched flush, once a batch is written: unpin the pages pinned by PinDirtyPages.
+   * @param pages the pages to unpin
+   */
+  void UnpinFlushedPages(const std::vector<DiskManager::PageWrite> &pages);
+
+  /**
+   * @return how many pages a flush pins at once: FLUSH_BATCH_SIZE, but no more than a quarter of the pool, so that
+   * fetches and new pages still find victims while the flush runs
+   */
+  auto GetFlushBatchSize() const -> size_t {
+    return std::max<size_t>(std::min<size_t>(FLUSH_BATCH_SIZE, pool_size_ / 4), 1);
+  }
+
+  /**
+   * Give up the deallocated pages at the end of this instance's share of the database file, so that later pages are
+   * allocated below them. Must not run concurrently with page creation.
+   * @return the number of pages the database file needs to hold the pages still allocated by this instance
+   */
+  auto ReleaseFreeTail() -> page_id_t;
+
+  /**
+   * Shrink the database file past the last allocated page. Only for a buffer pool instance that is not part of a
+   * parallel BPM, whose instances share the file; see ParallelBufferPoolManager::ShrinkFile. Must not run concurrently
+   * with page creation.
+   */
+  void ShrinkFile();
+
+  /** @return the number of deallocated pages waiting to be reused */
+  auto GetNumFreePages() -> size_t;
+
+  /** @return the number of frames in the free list; it may change as soon as it is read */
+  auto GetNumFreeFrames() const -> size_t { return num_free_frames_; }
+
+  /**
+   * @return a snapshot of the occupancy, caching and contention counters. The counters are relaxed atomics bumped as
+   * the pool is used, so the snapshot may be off by the operations racing with it.
+   */
+  auto GetStats() const -> BufferPoolInstanceStats;
+
+  /** Number of stripes the page table is split into. */
+  static constexpr size_t NUM_PAGE_TABLE_STRIPES = 16;
+
  protected:
   /**
    * Fetch the requested page from the buffer pool.
@@ -66,6 +223,24 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto FetchPgImp(page_id_t page_id) -> Page * override;
 
+  /**
+   * Fetch the requested page from the buffer pool. With a SEQUENTIAL_SCAN or BULK_WRITE strategy, a page that has to
+   * be read in recycles a frame of the strategy's ring.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy, nullptr for NORMAL
+   * @return the requested page, or nullptr if all frames are pinned or the page failed checksum verification in
+   * PageChecksumMode::STRICT
+   */
+  auto FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * Pin a page if it is resident and not being read in. Only the latch of the page's stripe is taken, and the access
+   * is not recorded in the replacer, as the caller is only peeking at the page.
+   * @param page_id id of the page
+   * @return the page, or nullptr if it is not resident or is still being read in
+   */
+  auto FetchPgIfResidentImp(page_id_t page_id) -> Page * override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -88,6 +263,15 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto NewPgImp(page_id_t *page_id) -> Page * override;
 
+  /**
+   * Creates a new page in the buffer pool. With a SEQUENTIAL_SCAN or BULK_WRITE strategy, it recycles a frame of the
+   * strategy's ring.
+   * @param[out] page_id id of created page
+   * @param strategy the access strategy, nullptr for NORMAL
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPgWithStrategyImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -96,23 +280,161 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   auto DeletePgImp(page_id_t page_id) -> bool override;
 
   /**
-   * Flushes all the pages in the buffer pool to disk.
+   * Flushes all the dirty pages in the buffer pool to disk, in page id order, coalescing consecutive pages into one
+   * write, and syncs the file once at the end. Only a batch of pages is pinned at a time, see GetFlushBatchSize.
    */
   void FlushAllPgsImp() override;
 
   /**
-   * Allocate a page on disk.∂
+   * Start reading pages into the buffer pool through the asynchronous disk manager. Each page is installed in its
+   * frame right away, so that a fetch arriving before the read completes waits for it instead of reading the page
+   * again. With a SEQUENTIAL_SCAN or BULK_WRITE strategy, the pages go to the strategy's ring.
+   * @param page_ids ids of the pages to prefetch
+   * @param strategy the access strategy, nullptr for NORMAL
+   */
+  void PrefetchPgsImp(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy) override;
+
+  /** A shard of the page table, with its own latch so that hits on different stripes never contend. */
+  struct alignas(64) PageTableStripe {
+    /** Protects the maps below and the metadata of the pages they map. */
+    std::mutex latch_;
+    /** Resident pages of this stripe, mapped to their frame. */
+    std::unordered_map<page_id_t, frame_id_t> page_table_;
+    /** Dirty pages that were evicted but are still being written back, mapped to the frame they are written from. */
+    std::unordered_map<page_id_t, frame_id_t> write_back_table_;
+    /** Fetches of the pages of this stripe, counted per stripe so that hits on different stripes never share a line. */
+    std::atomic<uint64_t> num_fetches_{0};
+    /** Fetches of the pages of this stripe that were hits. */
+    std::atomic<uint64_t> num_hits_{0};
+  };
+
+  /** @return the page table stripe that page_id belongs to */
+  auto GetStripe(page_id_t page_id) -> PageTableStripe & {
+    // Page ids of an instance are all congruent modulo num_instances_, divide that out to spread them evenly.
+    return stripes_[(page_id / num_instances_) % NUM_PAGE_TABLE_STRIPES];
+  }
+
+  /**
+   * Pin page_id if it is resident, waiting for I/O in progress on it or for it to be written back after an eviction.
+   * Must be called with the latch of the page's stripe held; it is released while waiting.
+   * @param page_id id of the page
+   * @param stripe_lock lock held on the latch of the page's stripe
+   * @return the pinned page, or nullptr if page_id is not in the buffer pool
+   */
+  auto PinResidentPage(page_id_t page_id, std::unique_lock<std::mutex> *stripe_lock) -> Page *;
+
+  /** @return a lock on latch_, counting the acquisition and whether it had to wait */
+  auto LockLatch() -> std::unique_lock<std::mutex>;
+
+  /**
+   * Drop a pin of a frame, handing it to the replacer when it becomes unpinned. Must be called with the latch of the
+   * stripe of the frame's page held.
+   * @param frame_id id of the frame
+   */
+  void UnpinFrame(frame_id_t frame_id);
+
+  /**
+   * Pick a frame to hold a new page: the frame of a ring slot if it can be recycled, else one from the free list, else
+   * one from the replacer. The old page of the picked frame is detached, see DetachPage. Must be called with latch_
+   * held.
+   * @param[out] frame_id id of the picked frame
+   * @param[out] write_back true if the old page of the frame has to be written back
+   * @param slot the ring slot to recycle, nullptr if the access strategy has no ring
+   * @return false if all frames are pinned
+   */
+  auto PickVictim(frame_id_t *frame_id, bool *write_back, BufferAccessStrategy::RingSlot *slot) -> bool;
+
+  /**
+   * Remove the unpinned page of a frame from the page table. If it is dirty, it is registered in the write back table
+   * until it has been written out. Must be called with latch_ and the latch of the page's stripe held.
+   * @param frame_id id of the frame
+   * @param stripe the stripe of the frame's page
+   * @return true if the page has to be written back
+   */
+  auto DetachPage(frame_id_t frame_id, PageTableStripe *stripe) -> bool;
+
+  /**
+   * @param strategy the access strategy, nullptr for NORMAL
+   * @return the next slot of the strategy's ring in this instance, or nullptr if the strategy has no ring
+   */
+  auto NextRingSlot(BufferAccessStrategy *strategy) -> BufferAccessStrategy::RingSlot *;
+
+  /**
+   * Install page_id in a frame picked by PickVictim, pinned once and with I/O in progress. Must be called with latch_
+   * held.
+   * @param frame_id id of the frame
+   * @param page_id id of the page to install
+   */
+  void InstallPage(frame_id_t frame_id, page_id_t page_id);
+
+  /**
+   * Mark the I/O of a frame as complete and wake up the threads waiting for it.
+   * @param frame_id id of the frame
+   * @param page_id id of the page installed in the frame
+   * @param old_page_id id of the page that was written back from the frame, INVALID_PAGE_ID if none
+   * @param unpin true to also drop the pin taken by InstallPage, for a page nobody is waiting to use
+   */
+  void FinishIo(frame_id_t frame_id, page_id_t page_id, page_id_t old_page_id, bool unpin = false);
+
+  /**
+   * Give up on a page whose read failed, e.g. its checksum verification in PageChecksumMode::STRICT: remove it from
+   * the page table and return its frame to the free list, once the threads waiting for the read have dropped their
+   * pins. Must be called without latch_ held.
+   * @param frame_id id of the frame
+   * @param page_id id of the page installed in the frame
+   * @param old_page_id id of the page that was written back from the frame, INVALID_PAGE_ID if none
+   */
+  void AbortIo(frame_id_t frame_id, page_id_t page_id, page_id_t old_page_id);
+
+  /**
+   * Mark the write-back of a page evicted from a frame as complete.
+   * @param frame_id id of the frame
+   * @param old_page_id id of the page that was written back from the frame, INVALID_PAGE_ID if none
+   */
+  void FinishWriteBack(frame_id_t frame_id, page_id_t old_page_id);
+
+  /**
+   * Write a resident page out. It is pinned during the write, so that it cannot be evicted, and marked clean first,
+   * so that a modification made during the write is not lost.
+   * @param page_id id of the page
+   * @param only_if_dirty true to skip pages that are clean or pinned, as the background writer does
+   * @return false if the page could not be found in the page table or was skipped, true otherwise
+   */
+  auto WritePageOut(page_id_t page_id, bool only_if_dirty) -> bool;
+
+  /**
+   * Start reading a page into a victim frame, see PrefetchPgsImp.
+   * @param page_id id of the page
+   * @param strategy the access strategy, nullptr for NORMAL
+   * @return false if all frames are pinned
+   */
+  auto PrefetchPage(page_id_t page_id, BufferAccessStrategy *strategy) -> bool;
+
+  /** Main loop of the background writer. */
+  void RunBackgroundWriter(BackgroundWriterOptions options);
+
+  /** Run one round of the background writer. */
+  void WriteColdPages(const BackgroundWriterOptions &options);
+
+  /**
+   * Allocate a page on disk, reusing the lowest deallocated page if there is one. Must be called with latch_ held.
    * @return the id of the allocated page
    */
   auto AllocatePage() -> page_id_t;
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk: mark it free in the disk manager's free page bitmap and keep it for reuse. Must be
+   * called without latch_ held, the page is marked free on disk before it can be allocated again.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id);
+
+  /**
+   * Rebuild the free page list of this instance from the disk manager's free page bitmap, and resume page allocation
+   * after the last page of this instance in the file. Called when the instance is created, so that an existing
+   * database file is picked up where it was left; no page is read.
+   */
+  void LoadFreePages();
 
   /**
    * Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
@@ -130,19 +452,68 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** Each BPI maintains its own counter for page_ids to hand out, must ensure they mod back to its instance_index_ */
   std::atomic<page_id_t> next_page_id_ = instance_index_;
 
-  /** Array of buffer pool pages. */
+  /** Data of the buffer pool pages. */
+  FrameArena frame_arena_;
+  /** Array of buffer pool pages, which hold the metadata of the frames. */
   Page *pages_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  /** Page table for keeping track of buffer pool pages, split into stripes. */
+  std::vector<PageTableStripe> stripes_;
   /** Replacer to find unpinned pages for replacement. */
   Replacer *replacer_;
   /** List of free pages. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /** Deallocated pages of this instance, reused lowest first so that the file stays dense. Protected by latch_. */
+  std::set<page_id_t> free_pages_;
+  /**
+   * True while a frame is being written back or read in. Such a frame is pinned and in the page table, but its content
+   * must not be used until the I/O has finished. Protected by the stripe latch of the page installed in the frame.
+   */
+  std::unique_ptr<bool[]> io_in_progress_;
+  /** Signalled when the I/O of a frame finishes; waited on with the stripe latch of the installed page. */
+  std::vector<std::condition_variable> io_cvs_;
+  /** Signalled when the write back of a frame finishes; waited on with the stripe latch of the written page. */
+  std::vector<std::condition_variable> write_back_cvs_;
+  /**
+   * True while a frame is in the replacer. Pins do not remove frames from the replacer, so that hits only record an
+   * access; PickVictim skips pinned frames instead, and they are handed back to the replacer once unpinned.
+   */
+  std::unique_ptr<std::atomic<bool>[]> in_replacer_;
+  /** Dirty victims written out synchronously by fetch or new page calls. */
+  std::atomic<uint64_t> num_sync_writes_{0};
+  /** Dirty pages written out by the background writer. */
+  std::atomic<uint64_t> num_background_writes_{0};
+  /** Size of free_list_, readable without latch_. */
+  std::atomic<size_t> num_free_frames_{0};
+  /** Pages created by NewPgImp. */
+  std::atomic<uint64_t> num_new_pages_{0};
+  /** Fetches that read their page from disk. */
+  std::atomic<uint64_t> num_misses_{0};
+  /** Clean and dirty pages evicted by PickVictim. */
+  std::atomic<uint64_t> num_clean_evictions_{0};
+  std::atomic<uint64_t> num_dirty_evictions_{0};
+  /** Fetches and new pages that found all frames pinned. */
+  std::atomic<uint64_t> num_pin_failures_{0};
+  /** Acquisitions of latch_ through LockLatch. */
+  std::atomic<uint64_t> num_latch_acquisitions_{0};
+  /** Acquisitions of latch_ through LockLatch that found it held. */
+  std::atomic<uint64_t> num_latch_waits_{0};
+  /** The background writer thread, joinable while it runs. */
+  std::thread background_writer_;
+  /** Protects background_writer_stop_ and the starting and stopping of the background writer. */
+  std::mutex background_writer_latch_;
+  /** Wakes up the background writer to stop it. */
+  std::condition_variable background_writer_cv_;
+  bool background_writer_stop_{false};
+  /** Issues the reads of prefetched pages, created by the first prefetch. Protected by latch_. */
+  std::unique_ptr<AsyncDiskManager> async_disk_manager_;
+  /**
+   * This latch protects the free list and serializes the installation of pages into frames. It is never held across
+   * disk I/O, and hits do not take it. Lock order: latch_, then stripe latches, then the replacer's latch.
+   */
   std::mutex latch_;
 };
 }  // namespace bustub
@@ -12,9 +12,8 @@
 
 #pragma once
 
-#include <list>
-#include <mutex>  // NOLINT
-#include <vector>
+#include <atomic>
+#include <memory>
 
 #include "buffer/replacer.h"
 #include "common/config.h"
@@ -23,6 +22,10 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * Every frame has a slot in two flat arrays, one for whether it is in the replacer and one for its reference bit. Pin,
+ * Unpin and RecordAccess only flip these flags, so they take O(1) time without locking or allocating. Victim sweeps the
+ * clock hand over the frames, clearing reference bits, until it finds an unreferenced frame in the replacer.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -45,8 +48,22 @@ class ClockReplacer : public Replacer {
 
   auto Size() -> size_t override;
 
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  void PeekVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) override;
+
  private:
-  // TODO(student): implement me!
+  const size_t num_pages_;
+  /** True for the frames that are in the replacer. */
+  std::unique_ptr<std::atomic<bool>[]> in_clock_;
+  /** Reference bit of every frame, set on unpin and on access, cleared as the clock hand passes. */
+  std::unique_ptr<std::atomic<bool>[]> referenced_;
+  /** Number of frames in the replacer. */
+  std::atomic<size_t> size_{0};
+  /** Position of the clock hand, taken modulo num_pages_. */
+  std::atomic<size_t> hand_{0};
 };
 
 }  // namespace bustub
@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FrameArena holds the data of all the frames of a buffer pool instance in one contiguous, page-aligned region, so
+ * that frame data is never interleaved with frame metadata and can be handed to the disk as is.
+ *
+ * The region is backed by huge pages if the pool is big enough: explicit ones (MAP_HUGETLB) if the OS has some
+ * reserved, otherwise transparent huge pages are requested with madvise. Either way, far fewer TLB entries cover the
+ * pool than with 4 KiB pages.
+ */
+class FrameArena {
+ public:
+  /**
+   * Map the region of the frames.
+   * @param num_frames the number of frames
+   */
+  explicit FrameArena(size_t num_frames);
+
+  /** Unmap the region of the frames. */
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the data of frame frame_id, PAGE_SIZE bytes aligned to PAGE_SIZE */
+  auto GetFrameData(frame_id_t frame_id) -> char * { return data_ + static_cast<size_t>(frame_id) * PAGE_SIZE; }
+
+  /** @return true if the region is backed by explicit huge pages */
+  auto IsHugeTlb() const -> bool { return huge_tlb_; }
+
+ private:
+  /** Start of the region. */
+  char *data_{nullptr};
+  /** Size of the region, rounded up to a whole number of huge pages if it is backed by them. */
+  size_t size_{0};
+  bool huge_tlb_{false};
+};
+
+}  // namespace bustub
@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy. It victimizes the frame whose K-th most recent access is the
+ * oldest, i.e. whose backward K-distance is the largest. Frames with fewer than K recorded accesses have an infinite
+ * backward K-distance and are victimized first, oldest access first. A page read once by a sequential scan therefore
+ * leaves the pool before the pages that are accessed over and over.
+ *
+ * Accesses less than the correlated reference period after the previous access to the same frame are correlated with
+ * it, e.g. the accesses of one operation to a page: they count as a single reference, and a frame is not victimized
+ * during that period unless every frame is.
+ *
+ * Time is measured by a logical clock that ticks whenever a frame is unpinned into the replacer or victimized, under
+ * the latch. RecordAccess only reads it, so buffer pool hits never write a shared counter; accesses between two ticks
+ * happen at the same time, and frames whose references tie are victimized in the order they became evictable.
+ *
+ * The evictable frames are kept ordered by their eviction key. Hits update the history of a frame without the latch,
+ * which only ever makes its key larger; Victim and PeekVictims queue such a frame again when they come across it.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of most recent accesses remembered per frame
+   * @param correlated_reference_period accesses closer than this to the previous access of a frame are correlated
+   */
+  LRUKReplacer(size_t num_pages, size_t k, uint64_t correlated_reference_period = 0);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  auto Victim(frame_id_t *frame_id) -> bool override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  void PeekVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) override;
+
+ private:
+  /** @return the i-th most recent uncorrelated reference to a frame, 0 being the most recent */
+  auto History(frame_id_t frame_id, size_t i) -> std::atomic<uint64_t> & { return history_[frame_id * k_ + i]; }
+
+  /** Position of a frame in the eviction queue: its eviction key, then the order in which it was queued. */
+  using QueueEntry = std::tuple<std::pair<bool, uint64_t>, uint64_t, frame_id_t>;
+
+  /**
+   * Find the first frame at or after it in the eviction queue whose key is up to date, queueing again every frame
+   * passed on the way whose key grew since it was queued.
+   * @param it the position to start at
+   * @return the position of the frame found, or the end of the queue
+   */
+  auto SkipStaleEntries(std::set<QueueEntry>::iterator it) -> std::set<QueueEntry>::iterator;
+
+  /** Insert an evictable frame into the eviction queue with its current key. */
+  void Enqueue(frame_id_t frame_id);
+
+  /** @return true if the last access to a frame is less than the correlated reference period before now */
+  auto IsCorrelated(frame_id_t frame_id, uint64_t now) -> bool;
+
+  /** Advance the clock by one tick. Needs latch_, so that the clock is only ever written by one thread. */
+  auto Tick() -> uint64_t;
+
+  /** @return the eviction order key of a frame, the smallest key is victimized first */
+  auto GetEvictionKey(frame_id_t frame_id) -> std::pair<bool, uint64_t>;
+
+  const size_t k_;
+  const uint64_t correlated_reference_period_;
+
+  /** Logical clock, advanced under latch_ by Unpin and Victim and read without it by RecordAccess. */
+  std::atomic<uint64_t> current_timestamp_{0};
+  /** The K most recent uncorrelated references of every frame. */
+  std::unique_ptr<std::atomic<uint64_t>[]> history_;
+  /** The most recent access of every frame, correlated or not. */
+  std::unique_ptr<std::atomic<uint64_t>[]> last_access_;
+  /** Number of valid entries in the history of every frame, at most K. */
+  std::unique_ptr<std::atomic<size_t>[]> num_references_;
+
+  /** Protects the eviction queue. Accesses are recorded without it. */
+  std::mutex latch_;
+  /** The evictable frames, the first one is victimized next unless it is within its correlated reference period. */
+  std::set<QueueEntry> eviction_queue_;
+  /** Position of every frame in eviction_queue_, or its end if the frame is not evictable. */
+  std::vector<std::set<QueueEntry>::iterator> queue_positions_;
+  /** Queueing order of the next frame to be queued, to break ties between equal keys. */
+  uint64_t next_sequence_{0};
+};
+
+}  // namespace bustub
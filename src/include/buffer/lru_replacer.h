@@ -12,9 +12,11 @@
 
 #pragma once
 
-#include <list>
+#include <atomic>
+#include <memory>
 #include <mutex>  // NOLINT
-#include <unordered_map>
+#include <set>
+#include <tuple>
 #include <vector>
 #include "buffer/replacer.h"
 #include "common/config.h"
@@ -22,7 +24,13 @@
 namespace bustub {
 
 /**
- * LRUReplacer implements the Least Recently Used replacement policy.
+ * LRUReplacer implements the Least Recently Used replacement policy: it victimizes the frame whose last access, or
+ * whose unpin if it was not accessed since, is the oldest.
+ *
+ * Buffer pool hits leave the frame where it is and only record the time of the access, without taking the mutex.
+ * Time is a logical clock that ticks whenever a frame is unpinned into the replacer, so hits only read it. A frame that
+ * was accessed since it was queued is queued again by its access time when Victim or PeekVictims reaches it, which
+ * keeps the order exact up to the resolution of the clock.
  */
 class LRUReplacer : public Replacer {
  public:
@@ -45,11 +53,38 @@ class LRUReplacer : public Replacer {
 
   auto Size() -> size_t override;
 
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  void PeekVictims(size_t max_frames, std::vector<frame_id_t> *frame_ids) override;
+
  private:
-  // TODO(student): implement me!
-  std::list<frame_id_t> lru_list_;
+  /** Position of a frame in lru_queue_: the time of its last access, then the order in which it was queued. */
+  using QueueEntry = std::tuple<uint64_t, uint64_t, frame_id_t>;
+
+  /**
+   * Find the first frame at or after it in lru_queue_ that was not accessed since it was queued, queueing again every
+   * frame passed on the way that was.
+   * @param it the position to start at
+   * @return the position of the frame found, or the end of lru_queue_
+   */
+  auto SkipStaleEntries(std::set<QueueEntry>::iterator it) -> std::set<QueueEntry>::iterator;
+
+  /** Insert a frame into lru_queue_ as accessed at timestamp. */
+  void Enqueue(frame_id_t frame_id, uint64_t timestamp);
+
+  /** Logical clock, advanced under mutex_ by Unpin and read without it by RecordAccess. */
+  std::atomic<uint64_t> current_timestamp_{0};
+  /** Time of the last access of every frame, set by RecordAccess. */
+  std::unique_ptr<std::atomic<uint64_t>[]> last_access_;
   std::mutex mutex_;
-  std::unordered_map<frame_id_t, std::list<frame_id_t>::iterator> lru_hash_;
+  /** The unpinned frames, least recently used first. */
+  std::set<QueueEntry> lru_queue_;
+  /** Position of every frame in lru_queue_, or its end if the frame is not in the replacer. */
+  std::vector<std::set<QueueEntry>::iterator> queue_positions_;
+  /** Queueing order of the next frame to be queued, to break ties between equal access times. */
+  uint64_t next_sequence_{0};
 };
 
 }  // namespace bustub
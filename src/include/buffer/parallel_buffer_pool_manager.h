@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "buffer/buffer_pool_manager_instance.h"
@@ -29,9 +30,14 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    * @param pool_size the pool size of each BufferPoolManagerInstance
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy of every BufferPoolManagerInstance
+   * @param replacer_k the K of an LRU-K replacer
+   * @param correlated_reference_period the correlated reference period of an LRU-K replacer, in clock ticks
    */
   ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::LRU,
+                            size_t replacer_k = LRUK_REPLACER_K,
+                            uint64_t correlated_reference_period = LRUK_CORRELATED_REFERENCE_PERIOD);
 
   /**
    * Destroys an existing ParallelBufferPoolManager.
@@ -41,6 +47,33 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   /** @return size of the buffer pool */
   auto GetPoolSize() -> size_t override;
 
+  /**
+   * Start the background writer of every BufferPoolManagerInstance.
+   * @param options the knobs of every writer
+   */
+  void StartBackgroundWriter(const BackgroundWriterOptions &options = {});
+
+  /** Stop the background writer of every BufferPoolManagerInstance. */
+  void StopBackgroundWriter();
+
+  /**
+   * Shrink the database file past the last page allocated by any BufferPoolManagerInstance, giving up the deallocated
+   * pages behind it. Must not run concurrently with page creation.
+   */
+  void ShrinkFile();
+
+  /** @return the number of dirty victims written out by a fetch or new page call, summed over all instances */
+  auto GetNumSyncWrites() const -> uint64_t;
+
+  /** @return the number of dirty pages written out by the background writers, summed over all instances */
+  auto GetNumBackgroundWrites() const -> uint64_t;
+
+  /** @return a snapshot of the occupancy, caching and contention counters of every instance, by index */
+  auto GetInstanceStats() const -> std::vector<BufferPoolInstanceStats>;
+
+  /** @return a snapshot of the occupancy, caching and contention counters, summed over all instances */
+  auto GetStats() const -> BufferPoolInstanceStats;
+
  protected:
   /**
    * @param page_id id of page
@@ -55,6 +88,21 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   auto FetchPgImp(page_id_t page_id) -> Page * override;
 
+  /**
+   * Fetch the requested page from the buffer pool, following an access strategy.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy, nullptr for NORMAL
+   * @return the requested page
+   */
+  auto FetchPgWithStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * Pin a page if it is resident in its BufferPoolManagerInstance and not being read in.
+   * @param page_id id of the page
+   * @return the page, or nullptr if it is not resident or is still being read in
+   */
+  auto FetchPgIfResidentImp(page_id_t page_id) -> Page * override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -77,6 +125,14 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   auto NewPgImp(page_id_t *page_id) -> Page * override;
 
+  /**
+   * Creates a new page in the buffer pool, following an access strategy.
+   * @param[out] page_id id of created page
+   * @param strategy the access strategy, nullptr for NORMAL
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPgWithStrategyImp(page_id_t *page_id, BufferAccessStrategy *strategy) -> Page * override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -85,13 +141,44 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   auto DeletePgImp(page_id_t page_id) -> bool override;
 
   /**
-   * Flushes all the pages in the buffer pool to disk.
+   * Flushes all the dirty pages of all the BufferPoolManagerInstances to disk. The pages of all the instances are
+   * written in page id order, so that consecutive pages are coalesced into one write even though they belong to
+   * different instances, by up to one thread per instance, and the file is synced once at the end. A thread only pins
+   * a batch of pages at a time, see BufferPoolManagerInstance::GetFlushBatchSize.
    */
   void FlushAllPgsImp() override;
 
+  /**
+   * Start reading pages into the buffer pool without waiting for them.
+   * @param page_ids ids of the pages to prefetch
+   * @param strategy the access strategy, nullptr for NORMAL
+   */
+  void PrefetchPgsImp(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy) override;
+
  private:
+  /**
+   * Order in which NewPgImp tries the instances: the one with the most free frames first, starting the search at a
+   * rotating index so that ties, e.g. once every free list is empty, are spread round robin; then the others in
+   * rotating order.
+   * @param[out] order indexes of all the instances
+   */
+  void GetAllocationOrder(std::vector<size_t> *order);
+
+  /**
+   * Write out the dirty pages among page_ids, one batch at a time: pin a batch in its instances, write it with
+   * consecutive pages coalesced, and unpin it. Does not sync the file.
+   * @param page_ids the pages to write, sorted by page id
+   */
+  void FlushPages(const std::vector<page_id_t> &page_ids);
+
+  /** A batched flush only uses another writer thread for every this many pages. */
+  static constexpr size_t MIN_PAGES_PER_FLUSH_THREAD = 256;
+
   std::vector<BufferPoolManagerInstance *> bpmis_;
-  uint32_t last_alloc_index_{0};
+  /** The disk manager shared by all the instances. */
+  DiskManager *disk_manager_;
+  /** Where the next allocation starts looking, bumped by every NewPgImp call. */
+  std::atomic<uint32_t> next_alloc_index_{0};
   size_t pool_size_;
 };
 }  // namespace bustub
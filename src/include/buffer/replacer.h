@@ -12,10 +12,15 @@
 
 #pragma once
 
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** The replacement policies a buffer pool can be built with. */
+enum class ReplacerType { LRU, CLOCK, LRU_K };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -45,6 +50,28 @@ class Replacer {
 
   /** @return the number of elements in the replacer that can be victimized */
   virtual auto Size() -> size_t = 0;
+
+  /**
+   * Records an access to the page held by a frame, whether or not the frame is in the replacer. This is called on every
+   * buffer pool hit, so it must not take a replacer-wide lock. Calls for the same frame are serialized by the caller.
+   * @param frame_id the id of the accessed frame
+   */
+  virtual void RecordAccess(__attribute__((unused)) frame_id_t frame_id) {}
+
+  /**
+   * Lists the frames that would be victimized next, in order, without removing them. Replacers that cannot tell list
+   * nothing.
+   * @param max_frames the maximum number of frames to list
+   * @param[out] frame_ids the frames that would be victimized next
+   */
+  virtual void PeekVictims(__attribute__((unused)) size_t max_frames,
+                           __attribute__((unused)) std::vector<frame_id_t> *frame_ids) {}
+
+  /**
+   * Removes a frame and forgets its access history, because the frame now holds another page or none at all.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
 };
 
 }  // namespace bustub
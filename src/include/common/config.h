@@ -35,6 +35,19 @@ static constexpr int PAGE_SIZE = 4096;                                        //
 static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int LRUK_REPLACER_K = 2;                                     // k of lru-k replacer
+static constexpr int LRUK_CORRELATED_REFERENCE_PERIOD = 0;                    // correlated period of lru-k, in clock ticks
+static constexpr int SEQUENTIAL_SCAN_RING_SIZE = 32;                          // ring of a sequential scan
+static constexpr int BULK_WRITE_RING_SIZE = 128;                              // frames recycled by a bulk write
+static constexpr int BACKGROUND_WRITER_CLEAN_TARGET_PERCENT = 10;             // % kept clean by bg writer
+static constexpr int BACKGROUND_WRITER_MAX_PAGES_PER_ROUND = 100;             // bg writer pages per round
+static constexpr int BACKGROUND_WRITER_INTERVAL_MS = 200;                     // bg writer round interval
+static constexpr int PREFETCH_QUEUE_DEPTH = 8;                                // prefetch reads in flight
+static constexpr int FLUSH_BATCH_SIZE = 64;                                   // pages pinned at once by a flush
+static constexpr int TABLE_SCAN_PREFETCH_DISTANCE = 8;                        // pages read ahead by a scan
+static constexpr int OPTIMISTIC_READ_ATTEMPTS = 4;                            // before taking the read latch
+static constexpr int CACHE_LINE_SIZE = 64;                                    // size of a cache line in byte
+static constexpr int HUGE_PAGE_SIZE = 2 * 1024 * 1024;                        // size of an OS huge page in byte
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
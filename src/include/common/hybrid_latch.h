@@ -0,0 +1,152 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hybrid_latch.h
+//
+// Identification: src/include/common/hybrid_latch.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * Reader-writer latch packed into a single 32-bit word. Uncontended acquisitions and releases are one atomic
+ * instruction. A thread that cannot get the latch spins for a bounded number of rounds, then parks on a futex until a
+ * release wakes it up.
+ *
+ * A waiting writer keeps new readers out, so that a steady stream of readers cannot starve it.
+ */
+class HybridLatch {
+  /** Set while a writer holds the latch. */
+  static constexpr uint32_t WRITER = 1U << 31;
+  /** Set while a writer waits for the readers to leave; new readers wait too. */
+  static constexpr uint32_t WRITER_WAITING = 1U << 30;
+  /** Set while a thread is parked on the futex, so that releases know to wake it up. */
+  static constexpr uint32_t PARKED = 1U << 29;
+  /** The number of readers holding the latch. */
+  static constexpr uint32_t READER_MASK = PARKED - 1;
+  /** Rounds a thread spins before it parks. */
+  static constexpr int MAX_SPINS = 64;
+
+ public:
+  HybridLatch() = default;
+  ~HybridLatch() = default;
+
+  DISALLOW_COPY(HybridLatch);
+
+  /**
+   * Acquire a write latch.
+   */
+  void WLock() {
+    int spins = 0;
+    while (true) {
+      uint32_t state = state_.load(std::memory_order_relaxed);
+      if ((state & (WRITER | READER_MASK)) == 0) {
+        // Taking the latch also clears WRITER_WAITING; other waiting writers set it again when they retry.
+        if (state_.compare_exchange_weak(state, (state & PARKED) | WRITER, std::memory_order_acquire)) {
+          return;
+        }
+        continue;
+      }
+      if ((state & WRITER_WAITING) == 0) {
+        state_.compare_exchange_weak(state, state | WRITER_WAITING, std::memory_order_relaxed);
+        continue;
+      }
+      Wait(state, &spins);
+    }
+  }
+
+  /**
+   * Release a write latch.
+   */
+  void WUnlock() {
+    uint32_t state = state_.fetch_and(~WRITER, std::memory_order_release);
+    if ((state & PARKED) != 0) {
+      WakeAll();
+    }
+  }
+
+  /**
+   * Acquire a read latch.
+   */
+  void RLock() {
+    int spins = 0;
+    while (true) {
+      uint32_t state = state_.load(std::memory_order_relaxed);
+      if ((state & (WRITER | WRITER_WAITING)) == 0 && (state & READER_MASK) != READER_MASK) {
+        if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire)) {
+          return;
+        }
+        continue;
+      }
+      Wait(state, &spins);
+    }
+  }
+
+  /**
+   * Release a read latch.
+   */
+  void RUnlock() {
+    uint32_t state = state_.fetch_sub(1, std::memory_order_release);
+    // Only a writer can be waiting for the readers to leave, and it only needs waking once the last one has left.
+    if ((state & READER_MASK) == 1 && (state & PARKED) != 0) {
+      WakeAll();
+    }
+  }
+
+ private:
+  /**
+   * Wait for the latch to change from state: spin at first, then park.
+   * @param state the state seen last
+   * @param[in,out] spins rounds spun so far
+   */
+  void Wait(uint32_t state, int *spins) {
+    if (*spins < MAX_SPINS) {
+      (*spins)++;
+      CpuRelax();
+      return;
+    }
+    if ((state & PARKED) == 0 &&
+        !state_.compare_exchange_weak(state, state | PARKED, std::memory_order_relaxed)) {
+      return;
+    }
+    // Returns right away if the state changed since we looked, e.g. because the latch was released.
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&state_), FUTEX_WAIT_PRIVATE, state | PARKED, nullptr, nullptr, 0);
+    *spins = 0;
+  }
+
+  /** Wake up all the parked threads, they race for the latch again. */
+  void WakeAll() {
+    state_.fetch_and(~PARKED, std::memory_order_relaxed);
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&state_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+  }
+
+  static void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+  }
+
+  std::atomic<uint32_t> state_{0};
+};
+
+static_assert(sizeof(HybridLatch) == sizeof(uint32_t), "HybridLatch should fit in a 32-bit word");
+
+}  // namespace bustub
@@ -0,0 +1,108 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// latency_histogram.h
+//
+// Identification: src/include/common/latency_histogram.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * Histogram of latencies with power-of-two buckets: bucket i counts the latencies in [2^i, 2^(i+1)) nanoseconds, the
+ * last bucket also everything above. Recording is a relaxed atomic increment of two counters, so it is cheap enough to
+ * stay on for every disk I/O; a snapshot may be off by the recordings racing with it.
+ */
+class LatencyHistogram {
+ public:
+  /** Number of buckets; the last one starts at about 2 seconds. */
+  static constexpr size_t NUM_BUCKETS = 32;
+
+  /** A copy of the counters of a histogram at one point in time. */
+  struct Snapshot {
+    /** Recordings per bucket. */
+    std::array<uint64_t, NUM_BUCKETS> buckets_{};
+    /** Total number of recordings. */
+    uint64_t count_{0};
+    /** Sum of the recorded latencies, in nanoseconds. */
+    uint64_t sum_ns_{0};
+
+    /** @return the mean latency in nanoseconds, 0 if nothing was recorded */
+    auto MeanNs() const -> double { return count_ == 0 ? 0 : static_cast<double>(sum_ns_) / count_; }
+
+    /**
+     * @param percentile the percentile, in [0, 100]
+     * @return an upper bound of the latency below which percentile percent of the recordings fall, in nanoseconds: the
+     * end of the bucket the percentile falls in; 0 if nothing was recorded, UINT64_MAX if it falls in the last bucket
+     */
+    auto PercentileNs(double percentile) const -> uint64_t {
+      if (count_ == 0) {
+        return 0;
+      }
+      // The rank of the recording at the percentile, counting from 0.
+      auto rank = std::min(static_cast<uint64_t>(percentile / 100 * count_), count_ - 1);
+      uint64_t seen = 0;
+      for (size_t i = 0; i < NUM_BUCKETS - 1; i++) {
+        seen += buckets_[i];
+        if (seen > rank) {
+          return (uint64_t{2} << i) - 1;
+        }
+      }
+      return UINT64_MAX;
+    }
+  };
+
+  LatencyHistogram() = default;
+  DISALLOW_COPY_AND_MOVE(LatencyHistogram);
+
+  /**
+   * Record a latency.
+   * @param latency_ns the latency in nanoseconds
+   */
+  void Record(uint64_t latency_ns) {
+    size_t bucket = 63 - __builtin_clzll(latency_ns | 1);
+    buckets_[bucket < NUM_BUCKETS ? bucket : NUM_BUCKETS - 1].fetch_add(1, std::memory_order_relaxed);
+    sum_ns_.fetch_add(latency_ns, std::memory_order_relaxed);
+  }
+
+  /**
+   * Record the time elapsed since start.
+   * @param start when the operation started
+   */
+  void RecordSince(std::chrono::steady_clock::time_point start) {
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    Record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  }
+
+  /** @return a copy of the counters */
+  auto GetSnapshot() const -> Snapshot {
+    Snapshot snapshot;
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+      snapshot.buckets_[i] = buckets_[i].load(std::memory_order_relaxed);
+      snapshot.count_ += snapshot.buckets_[i];
+    }
+    snapshot.sum_ns_ = sum_ns_.load(std::memory_order_relaxed);
+    return snapshot;
+  }
+
+ private:
+  std::array<std::atomic<uint64_t>, NUM_BUCKETS> buckets_{};
+  std::atomic<uint64_t> sum_ns_{0};
+};
+
+}  // namespace bustub
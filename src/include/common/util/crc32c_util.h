@@ -0,0 +1,41 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_util.h
+//
+// Identification: src/include/common/util/crc32c_util.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * CRC32C (Castagnoli) checksums, as used for pages on disk. On x86-64 CPUs with SSE4.2, the checksum is computed with
+ * the crc32 instruction over three interleaved streams, which are combined at the end; elsewhere a table-driven
+ * implementation is used.
+ */
+class Crc32cUtil {
+ public:
+  /**
+   * @param data the bytes to checksum
+   * @param length the number of bytes
+   * @return the CRC32C of the bytes
+   */
+  static auto Crc32c(const char *data, size_t length) -> uint32_t;
+
+  /** Table-driven CRC32C, for CPUs without SSE4.2. Returns the same checksums as Crc32c. */
+  static auto Crc32cSoftware(const char *data, size_t length) -> uint32_t;
+
+  /** @return true if Crc32c uses the crc32 instruction */
+  static auto IsHardwareAccelerated() -> bool;
+};
+
+}  // namespace bustub
@@ -12,13 +12,19 @@
 
 #pragma once
 
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
 #include <queue>
 #include <string>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "common/hybrid_latch.h"
 #include "concurrency/transaction.h"
 #include "container/hash/hash_function.h"
+#include "storage/page/extendible_hash_table_header_page.h"
 #include "storage/page/hash_table_bucket_page.h"
 #include "storage/page/hash_table_directory_page.h"
 
@@ -30,6 +36,19 @@ namespace bustub {
  * Implementation of extendible hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table grows/shrinks dynamically as buckets become full/empty.
+ *
+ * The directory has two levels: a header page maps a hash to one of up to HEADER_ARRAY_SIZE directory pages, which
+ * map it to one of up to DIRECTORY_ARRAY_SIZE buckets each. A table starts with one directory page; once it is full,
+ * it is split in two instead of its buckets. Finding the bucket of a key reads two pages, however large the table.
+ *
+ * A bucket that a remove leaves empty or underfull is merged with its split image if they fit in half a bucket
+ * together, and the directory page shrinks once no bucket needs its full global depth. The merges are done right away
+ * by the remove, or later by a background compactor if one is running, so that removes do not wait for them.
+ *
+ * Lookups read the directory page and the bucket optimistically, without latches. Inserts and removes latch only
+ * their bucket, and a bucket split only the bucket, plus the directory page while it points the split image's slots
+ * to it. The table latch is only taken in write mode, excluding all the other operations, by directory page splits
+ * and by merges, which delete pages.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class ExtendibleHashTable {
@@ -44,6 +63,11 @@ class ExtendibleHashTable {
   explicit ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                const KeyComparator &comparator, HashFunction<KeyType> hash_fn);
 
+  /**
+   * Stops the compactor, if it is running.
+   */
+  ~ExtendibleHashTable();
+
   /**
    * Inserts a key-value pair into the hash table.
    *
@@ -75,12 +99,46 @@ class ExtendibleHashTable {
   auto GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool;
 
   /**
-   * Returns the global depth.  Do not touch.
+   * Performs point queries of a batch of keys, overlapping their cache misses: all the keys are hashed first, then
+   * mapped to their buckets with the directory slots prefetched a few keys ahead, and the keys of a bucket are probed
+   * together, while the next bucket is fetched and its flags and fingerprints prefetched. Batches of 64 to 1024 keys
+   * amortize this best.
+   *
+   * @param transaction the current transaction
+   * @param keys the keys to look up
+   * @param[out] results resized to the number of keys, (*results)[i] gets the values of keys[i]
+   * @return the number of keys found
+   */
+  auto GetValues(Transaction *transaction, const std::vector<KeyType> &keys,
+                 std::vector<std::vector<ValueType>> *results) -> size_t;
+
+  /**
+   * Merges all the empty and underfull buckets that can be merged with their split image, and shrinks the directory
+   * pages. Useful after a bulk delete, whose removes only merge the buckets they empty or make underfull.
+   */
+  void Compact();
+
+  /**
+   * Start a background thread that does the merges of removes, so that removes do not wait for the table latch to do
+   * them. Does nothing if the compactor is already running.
+   *
+   * @param interval time between two rounds of merges
+   */
+  void StartCompactor(std::chrono::milliseconds interval = std::chrono::milliseconds(100));
+
+  /**
+   * Stop the compactor, after it has done the merges left, and wait for it to exit. Does nothing if it is not running.
+   */
+  void StopCompactor();
+
+  /**
+   * Returns the global depth: the number of hash bits used to find the deepest bucket, that is the global depth of the
+   * header plus the largest global depth of a directory page.
    */
   auto GetGlobalDepth() -> uint32_t;
 
   /**
-   * Helper function to verify the integrity of the extendible hash table's directory.  Do not touch.
+   * Helper function to verify the integrity of the extendible hash table's header and directory pages.
    */
   void VerifyIntegrity();
 
@@ -94,6 +152,16 @@ class ExtendibleHashTable {
    */
   inline auto Hash(KeyType key) -> uint32_t;
 
+  /**
+   * @param hash the hash of a key
+   * @return the fingerprint of the key in its bucket page, the top byte of its hash. The directory and header pages
+   * index by the low bits, so the top byte still tells apart the keys of a bucket.
+   */
+  static inline auto HashFingerprint(uint32_t hash) -> uint8_t {
+    static_assert(DIRECTORY_MAX_DEPTH + HEADER_MAX_DEPTH <= 24, "fingerprints must not overlap the indexed bits");
+    return static_cast<uint8_t>(hash >> 24);
+  }
+
   /**
    * KeyToDirectoryIndex - maps a key to a directory index
    *
@@ -110,32 +178,52 @@ class ExtendibleHashTable {
    * @param dir_page to use for lookup of global depth
    * @return the directory index
    */
-  inline auto KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) -> uint32_t;
+  inline auto KeyToDirectoryIndex(KeyType key, const HashTableDirectoryPage *dir_page) -> uint32_t;
 
   /**
-   * Get the bucket page_id corresponding to a key.
+   * Get the bucket page_id corresponding to a key, reading the directory page optimistically. The result may be
+   * outdated by a concurrent split as soon as it is returned, unless the caller latches the bucket it returns and
+   * then checks it again.
    *
    * @param key the key for lookup
-   * @param dir_page a pointer to the hash table's directory page
+   * @param dir_page the directory page of the key, pinned
+   * @param[out] local_depth if not null, set to the local depth of the bucket
    * @return the bucket page_id corresponding to the input key
    */
-  inline auto KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) -> page_id_t;
+  auto KeyToBucketPageId(KeyType key, Page *dir_page, uint32_t *local_depth) -> page_id_t;
 
   /**
-   * Fetches the directory page from the buffer pool manager.
+   * Fetch and write latch the bucket page of a key. Must be called with table_latch_ held in read mode.
    *
-   * @return a pointer to the directory page
+   * @param key the key for lookup
+   * @param[out] local_depth if not null, set to the local depth of the bucket; it holds as long as the latch does
+   * @return a guard of the bucket page, not valid if the buffer pool is out of frames
    */
-  auto FetchDirectoryPage() -> HashTableDirectoryPage *;
+  auto FetchBucketPageWrite(KeyType key, uint32_t *local_depth) -> WritePageGuard;
 
   /**
-   * Fetches the a bucket page from the buffer pool manager using the bucket's page_id.
+   * KeyToHeaderIndex - maps a key to a header index, using the hash bits above those used by the directory pages.
    *
-   * @param bucket_page_id the page_id to fetch
-   * @return a pointer to a bucket page
+   * HeaderIndex = (Hash(key) >> DIRECTORY_MAX_DEPTH) & HEADER_GLOBAL_DEPTH_MASK
    *
+   * @param key the key to use for lookup
+   * @param header_page the header page
+   * @return the header index
+   */
+  inline auto KeyToHeaderIndex(KeyType key, const ExtendibleHashTableHeaderPage *header_page) -> uint32_t;
+
+  /**
+   * Fetch the directory page corresponding to a key, unlatched. The header page is only pinned while it is read.
+   *
+   * @param key the key for lookup
+   * @return a guard of the directory page, not valid if the buffer pool is out of frames
    */
-  HASH_TABLE_BUCKET_TYPE *FetchBucketPage(page_id_t bucket_page_id);
+  auto FetchDirectoryPage(KeyType key) -> BasicPageGuard;
+
+  /**
+   * @return the page ids of the directory pages, each once; none if the header page cannot be fetched
+   */
+  auto GetDirectoryPageIds() -> std::vector<page_id_t>;
 
   /**
    * Performs insertion with an optional bucket splitting.
@@ -147,6 +235,17 @@ class ExtendibleHashTable {
    */
   auto SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool;
 
+  /**
+   * Splits the full directory page of a key in two, on the lowest hash bit the header does not use for it yet. Each
+   * bucket of the directory page is split the same way, so the two halves keep the same layout with about half the
+   * entries each. Must be called with table_latch_ held in write mode.
+   *
+   * @param key the key whose directory page is full
+   * @return false if the header page is full too, so the table cannot grow any more, or if the buffer pool ran out of
+   * frames before the split took effect
+   */
+  auto SplitDirectory(const KeyType &key) -> bool;
+
   /**
    * Optionally merges an empty bucket into it's pair.  This is called by Remove,
    * if Remove makes a bucket empty.
@@ -162,14 +261,48 @@ class ExtendibleHashTable {
    */
   void Merge(Transaction *transaction, const KeyType &key, const ValueType &value);
 
+  /**
+   * Merges the bucket at bucket_idx with its split image, as long as the two have the same local depth and one of
+   * them is empty or they fit in half a bucket together; the emptier page is deleted. Must be called with table_latch_
+   * held in write mode.
+   *
+   * @param dir_page the directory page of the bucket
+   * @param bucket_idx the directory index of the bucket
+   */
+  void MergeBucket(HashTableDirectoryPage *dir_page, uint32_t bucket_idx);
+
+  /** Deletes the bucket pages MergeBucket could not delete. Must be called with table_latch_ held in write mode. */
+  void DeleteFreedBucketPages();
+
+  /** Main loop of the compactor. */
+  void RunCompactor(std::chrono::milliseconds interval);
+
+  /** How many keys ahead GetValues prefetches the directory slots. */
+  static constexpr size_t BATCH_PREFETCH_DISTANCE = 8;
+
+  /** A remove that leaves this few entries in a bucket tries to merge it. */
+  static constexpr uint32_t UNDERFULL_THRESHOLD = BUCKET_ARRAY_SIZE / 4;
+
   // member variables
-  page_id_t directory_page_id_;
+  page_id_t header_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writers are splits and merges
-  ReaderWriterLatch table_latch_;
+  // Readers includes lookups, inserts, removes and bucket splits, writers are directory page splits and merges
+  HybridLatch table_latch_;
   HashFunction<KeyType> hash_fn_;
+
+  /** The compactor thread, joinable while it runs. */
+  std::thread compactor_;
+  /** Protects merge_candidates_, compactor_stop_ and the starting and stopping of the compactor. */
+  std::mutex compactor_latch_;
+  /** Wakes up the compactor to stop it. */
+  std::condition_variable compactor_cv_;
+  bool compactor_stop_{false};
+  /** Keys of the buckets the compactor should try to merge. */
+  std::vector<KeyType> merge_candidates_;
+  /** Merged bucket pages that no directory points to anymore but were pinned when they were deleted. */
+  std::vector<page_id_t> freed_bucket_pages_;
 };
 
 }  // namespace bustub
@@ -16,6 +16,7 @@
 #include <utility>
 #include <vector>
 
+#include "buffer/buffer_access_strategy.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/insert_plan.h"
@@ -70,6 +71,9 @@ class InsertExecutor : public AbstractExecutor {
   uint32_t size_;
 
   std::vector<IndexInfo *> indexes_;
+
+  /** Recycles a ring of frames for the table pages of a bulk insert, so that it does not flush the buffer pool. */
+  BufferAccessStrategy bulk_write_strategy_{AccessStrategyType::BULK_WRITE};
 };
 
 }  // namespace bustub
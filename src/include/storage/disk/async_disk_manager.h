@@ -0,0 +1,182 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_manager.h
+//
+// Identification: src/include/storage/disk/async_disk_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * AsyncDiskManager reads and writes the pages of a DiskManager's database file asynchronously. A request returns
+ * immediately; its completion is reported through a callback or a future, so the caller does not have to block for
+ * the full disk latency.
+ *
+ * Requests are submitted through io_uring when the kernel supports it. Otherwise they are served by a pool of worker
+ * threads issuing the synchronous DiskManager calls, which behaves the same, only with more context switches.
+ */
+class AsyncDiskManager {
+ public:
+  /**
+   * Called when a request has completed. Callbacks run on an internal I/O thread, so they should be short and must
+   * not wait for other requests to complete.
+   * @param success false if an I/O error occurred, or a page read failed checksum verification in STRICT mode
+   */
+  using Callback = std::function<void(bool success)>;
+
+  /**
+   * Creates a new AsyncDiskManager.
+   * @param disk_manager the disk manager whose database file is read and written
+   * @param queue_depth the maximum number of requests in flight; also the number of worker threads (capped at 16)
+   * used when io_uring is not available
+   * @param use_io_uring false to always use the worker threads
+   */
+  explicit AsyncDiskManager(DiskManager *disk_manager, uint32_t queue_depth = 64, bool use_io_uring = true);
+
+  /**
+   * Waits for all requests in flight, then destroys the AsyncDiskManager.
+   */
+  ~AsyncDiskManager();
+
+  DISALLOW_COPY_AND_MOVE(AsyncDiskManager);
+
+  /**
+   * Read a page from the database file. Reading past the end of the file returns a zeroed page.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, must stay valid until the callback has run
+   * @param callback called once the page is read
+   */
+  void ReadPage(page_id_t page_id, char *page_data, Callback callback);
+
+  /**
+   * Write a page to the database file.
+   * @param page_id id of the page
+   * @param page_data raw page data, must stay valid until the callback has run
+   * @param callback called once the page is written
+   */
+  void WritePage(page_id_t page_id, const char *page_data, Callback callback);
+
+  /**
+   * Read a page from the database file.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, must stay valid until the future is ready
+   * @return a future that becomes true once the page is read, false on I/O error or checksum mismatch
+   */
+  auto ReadPage(page_id_t page_id, char *page_data) -> std::future<bool>;
+
+  /**
+   * Write a page to the database file.
+   * @param page_id id of the page
+   * @param page_data raw page data, must stay valid until the future is ready
+   * @return a future that becomes true once the page is written, false on I/O error
+   */
+  auto WritePage(page_id_t page_id, const char *page_data) -> std::future<bool>;
+
+  /** @return true if requests are submitted through io_uring, false if worker threads serve them */
+  auto IsIoUringEnabled() const -> bool { return ring_fd_ >= 0; }
+
+ private:
+  /** A page read or write in flight. */
+  struct Request {
+    bool is_write_;
+    page_id_t page_id_;
+    char *page_data_;
+    Callback callback_;
+    /** Bytes transferred so far; short transfers are resubmitted for the remainder, except under direct I/O. */
+    size_t done_{0};
+    struct iovec iov_ {};
+    /** When the request was handed to io_uring. */
+    std::chrono::steady_clock::time_point start_{};
+    /** With checksums, the copy of the page that a write hands to io_uring, and its checksum. */
+    std::unique_ptr<char, decltype(&free)> snapshot_{nullptr, &free};
+    uint32_t checksum_{0};
+  };
+
+  /** Submit a request to io_uring or the worker threads. */
+  void Submit(Request *request);
+
+  /** Complete a request and release its slot in the queue. */
+  void Complete(Request *request, bool success);
+
+  /**
+   * Set up the io_uring submission and completion queues.
+   * @return false if the kernel does not support io_uring
+   */
+  auto SetUpIoUring(uint32_t queue_depth) -> bool;
+
+  /** Unmap the io_uring queues and close the ring. */
+  void TearDownIoUring();
+
+  /** Place the unfinished part of a request in the submission queue. Must be called with sq_latch_ held. */
+  void PushSubmission(Request *request);
+
+  /** Reap io_uring completions until shut down. */
+  void RunCompletionThread();
+
+  /** Serve requests synchronously until shut down. */
+  void RunWorkerThread();
+
+  /**
+   * Serve a request with the synchronous DiskManager calls.
+   * @return false if the page read failed checksum verification in PageChecksumMode::STRICT
+   */
+  auto ServeSynchronously(Request *request) -> bool;
+
+  DiskManager *disk_manager_;
+  const uint32_t queue_depth_;
+
+  /** Number of requests in flight, protected by sq_latch_. */
+  uint32_t num_in_flight_{0};
+  /** Protects the submission queue, or the worker queue if io_uring is not used. */
+  std::mutex sq_latch_;
+  /** Signalled when a request completes. */
+  std::condition_variable sq_cv_;
+  bool shut_down_{false};
+
+  /** io_uring state, ring_fd_ is -1 if io_uring is not used. */
+  int ring_fd_{-1};
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  void *sqes_{nullptr};
+  size_t sqes_size_{0};
+  uint32_t *sq_tail_{nullptr};
+  uint32_t *sq_mask_{nullptr};
+  uint32_t *sq_array_{nullptr};
+  uint32_t *cq_head_{nullptr};
+  uint32_t *cq_tail_{nullptr};
+  uint32_t *cq_mask_{nullptr};
+  void *cqes_{nullptr};
+
+  /** Requests waiting for a worker thread, if io_uring is not used. */
+  std::deque<Request *> worker_queue_;
+  /** The io_uring completion thread, or the worker threads. */
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace bustub
@@ -13,28 +13,89 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <future>  // NOLINT
 #include <mutex>   // NOLINT
 #include <string>
+#include <vector>
 
 #include "common/config.h"
+#include "common/latency_histogram.h"
 
 namespace bustub {
 
+/** What DiskManager does about page checksums. */
+enum class PageChecksumMode {
+  /** Pages are neither checksummed nor verified. */
+  DISABLED,
+  /** Pages are checksummed on write; a page that fails verification on read is logged and counted. */
+  LOG,
+  /**
+   * Like LOG, but ReadPage also throws on a page that fails verification, e.g. one torn by a crash mid-write. After a
+   * crash, this also rejects a page written since the last sync whose checksum did not make it to disk.
+   */
+  STRICT
+};
+
+/** I/O counters and latencies of a DiskManager. */
+struct DiskManagerStats {
+  /** Pages written. */
+  uint64_t num_writes_{0};
+  /** Log flushes. */
+  uint64_t num_flushes_{0};
+  /** Pages read that failed checksum verification. */
+  uint64_t num_checksum_failures_{0};
+  /** Latencies of page reads. */
+  LatencyHistogram::Snapshot read_latency_;
+  /** Latencies of page writes; a vectored write of a run of pages counts as one. */
+  LatencyHistogram::Snapshot write_latency_;
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages are read and written with positional I/O (pread/pwrite) on a single file descriptor, so page I/O does not
+ * need a latch and concurrent buffer pool instances can have many page reads and writes in flight at once.
+ *
+ * With direct I/O, the database file is opened with O_DIRECT, so pages are not cached a second time by the OS and
+ * writes go straight to the device instead of being written back at the OS's discretion. O_DIRECT needs page buffers
+ * aligned to PAGE_SIZE, like the frames of a buffer pool; other buffers are bounced through an aligned one.
+ *
+ * With page checksums, the CRC32C of every page written is kept in a sidecar file next to the database file (".crc",
+ * 4 bytes per page), since the page formats have no room to spare for it. ReadPage verifies the pages against it, so
+ * that a page that was torn or corrupted on disk is caught instead of being handed to the buffer pool. A page written
+ * before checksums were enabled has no checksum and is not verified. Since the frames are not latched while they are
+ * written back, a page is copied before it is written and checksummed, and the copy is what goes to disk.
+ *
+ * The checksum file is not updated atomically with the database file: a checksum is written right after its page, and
+ * SyncPages syncs both files. A crash can thus leave a page written since the last SyncPages with a stale checksum,
+ * and such a page fails verification even though it is whole.
+ *
+ * The deallocated pages are kept in a bitmap in another sidecar file (".free", 1 bit per page), so that a buffer pool
+ * over a reopened database file finds them by reading the bitmap instead of every page of the file. A page leaves the
+ * bitmap before its next write goes out, so a page that is reused is not mistaken for a free one.
  */
 class DiskManager {
+  // AsyncDiskManager issues page I/O on the db file descriptor directly.
+  friend class AsyncDiskManager;
+
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param sync_interval fdatasync the database file after every sync_interval page writes (0 = leave it to the OS)
+   * @param direct_io open the database file with O_DIRECT; falls back to buffered I/O if the file system refuses it
+   * @param checksum_mode whether pages are checksummed, and what a failed verification does
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, uint32_t sync_interval = 0, bool direct_io = false,
+                       PageChecksumMode checksum_mode = PageChecksumMode::DISABLED);
 
-  ~DiskManager() = default;
+  /**
+   * Closes the database file if ShutDown was not called.
+   */
+  ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
@@ -48,13 +109,70 @@ class DiskManager {
    */
   void WritePage(page_id_t page_id, const char *page_data);
 
+  /** A page to write with WritePages. */
+  struct PageWrite {
+    page_id_t page_id_;
+    const char *page_data_;
+  };
+
+  /**
+   * Write many pages to the database file, coalescing the runs of consecutive pages into one pwritev call each. Like
+   * WritePage, it does not sync the file.
+   * @param pages the pages to write, sorted by page id
+   */
+  void WritePages(const std::vector<PageWrite> &pages);
+
   /**
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
+   * @throws Exception if the page fails checksum verification in PageChecksumMode::STRICT
    */
   void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Force all page writes made so far to disk.
+   */
+  void SyncPages();
+
+  /** @return true if the database file was opened with O_DIRECT */
+  auto IsDirectIo() const -> bool { return direct_io_; }
+
+  /** @return the page checksum mode */
+  auto GetChecksumMode() const -> PageChecksumMode { return checksum_mode_; }
+
+  /** @return the number of pages read that failed checksum verification */
+  auto GetNumChecksumFailures() const -> int { return num_checksum_failures_; }
+
+  /** @return a snapshot of the I/O counters and latencies */
+  auto GetStats() const -> DiskManagerStats;
+
+  /** @return true if page_data can be handed to the database file as is under O_DIRECT */
+  static auto IsAligned(const char *page_data) -> bool {
+    return reinterpret_cast<uintptr_t>(page_data) % PAGE_SIZE == 0;
+  }
+
+  /** @return the number of pages in the database file, counting a partially written last page */
+  auto GetNumPages() const -> page_id_t {
+    return static_cast<page_id_t>((db_file_size_.load() + PAGE_SIZE - 1) / PAGE_SIZE);
+  }
+
+  /**
+   * Cut the database file down to its first num_pages pages. Does nothing if the file is not longer than that.
+   * @param num_pages the number of pages to keep
+   */
+  void Truncate(page_id_t num_pages);
+
+  /**
+   * Mark a deallocated page free in the free page bitmap, so that it is found again when the database file is
+   * reopened. The page's next write takes it off the bitmap.
+   * @param page_id id of the page
+   */
+  void MarkPageFree(page_id_t page_id);
+
+  /** @return the pages of the database file marked free and not written since, lowest first */
+  auto GetFreePages() -> std::vector<page_id_t>;
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -91,18 +209,60 @@ class DiskManager {
 
  private:
   auto GetFileSize(const std::string &file_name) -> int;
+  /** Write the page_data of count consecutive pages, starting at page_id, from buffers aligned if direct_io_ is set. */
+  void WriteAlignedPages(page_id_t page_id, const char *const *page_data, size_t count);
+  /** Write a page from a buffer that is aligned if direct_io_ is set, and not modified during the write. */
+  void WriteAlignedPage(page_id_t page_id, const char *page_data);
+  /** Read a page into a buffer that is aligned if direct_io_ is set. */
+  void ReadAlignedPage(page_id_t page_id, char *page_data);
+  /** @return the checksum stored for a page; never 0, which marks a page without a checksum */
+  static auto PageChecksum(const char *page_data) -> uint32_t;
+  /** Store the checksums of count consecutive pages, starting at page_id, in the checksum file. */
+  void StoreChecksums(page_id_t page_id, const uint32_t *checksums, size_t count);
+  /**
+   * Verify a page read against its stored checksum, logging and counting a mismatch.
+   * @return false if the page failed verification and the checksum mode is STRICT
+   */
+  auto VerifyChecksum(page_id_t page_id, const char *page_data) -> bool;
+  /** Grow the cached db file size to file_size, if it is smaller. */
+  void ExtendFileSize(size_t file_size);
+  /** Take count consecutive pages, starting at page_id, off the free page bitmap before they are written. */
+  void MarkPagesUsed(page_id_t page_id, size_t count);
+  /** Write the byte of the free page bitmap that holds the bit of page_id to the free page file. Needs free_latch_. */
+  void StoreFreeBits(page_id_t page_id);
+  /** Clear the free page bits of the pages from num_pages on, in memory and on disk. Needs free_latch_. */
+  void TrimFreeBits(page_id_t num_pages);
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // file descriptor of the db file
+  int db_fd_{-1};
+  // true if db_fd_ was opened with O_DIRECT
+  bool direct_io_{false};
   std::string file_name_;
+  // size of the db file, kept up to date by WritePage so that ReadPage does not need to stat the file
+  std::atomic<size_t> db_file_size_{0};
   int num_flushes_{0};
-  int num_writes_{0};
+  std::atomic<int> num_writes_{0};
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
-  // With multiple buffer pool instances, need to protect file access
-  std::mutex db_io_latch_;
+  // page writes between two fdatasync calls, 0 if WritePage never syncs
+  const uint32_t sync_interval_;
+  std::atomic<uint32_t> writes_since_sync_{0};
+  const PageChecksumMode checksum_mode_;
+  // file descriptor of the checksum file, -1 if checksums are disabled
+  int crc_fd_{-1};
+  std::string crc_name_;
+  std::atomic<int> num_checksum_failures_{0};
+  // the free page bitmap, 1 bit per page, and its file, created by the first MarkPageFree
+  std::mutex free_latch_;
+  std::vector<uint8_t> free_bitmap_;
+  std::atomic<size_t> num_free_pages_{0};
+  int free_fd_{-1};
+  std::string free_name_;
+  // latencies of the page reads and writes, including those of AsyncDiskManager
+  LatencyHistogram read_latency_;
+  LatencyHistogram write_latency_;
 };
 
 }  // namespace bustub
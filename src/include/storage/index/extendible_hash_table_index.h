@@ -39,7 +39,16 @@ class ExtendibleHashTableIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                Transaction *transaction) override;
+
  protected:
+  /**
+   * @return the index key of a key tuple. The hash table hashes the bytes of its keys, so only the bytes of the key
+   * columns are copied: a tuple that compares equal to a key with more bytes after the key columns has the same key.
+   */
+  auto MakeIndexKey(const Tuple &key) const -> KeyType;
+
   // comparator for key
   KeyComparator comparator_;
   // container
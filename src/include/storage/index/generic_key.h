@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
 
 #include "storage/table/tuple.h"
@@ -35,6 +36,15 @@ class GenericKey {
     memcpy(data_, tuple.GetData(), tuple.GetLength());
   }
 
+  /**
+   * Set from the first length bytes of a tuple, so that bytes after the key columns, e.g. the other columns of a
+   * table tuple, are not part of the key.
+   */
+  inline void SetFromKey(const Tuple &tuple, uint32_t length) {
+    memset(data_, 0, KeySize);
+    memcpy(data_, tuple.GetData(), std::min({length, tuple.GetLength(), static_cast<uint32_t>(KeySize)}));
+  }
+
   // NOTE: for test purpose only
   inline void SetFromInteger(int64_t key) {
     memset(data_, 0, KeySize);
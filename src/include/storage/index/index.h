@@ -175,6 +175,21 @@ class Index {
    */
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  /**
+   * Search the index for a batch of keys, e.g. the outer tuples of an index join. Indexes that can overlap the
+   * lookups of a batch override this; by default the keys are searched one at a time.
+   * @param keys The index keys, best in batches of 64 to 1024
+   * @param results Resized to the number of keys, (*results)[i] is populated with the RIDs of keys[i]
+   * @param transaction The transaction context
+   */
+  virtual void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                        Transaction *transaction) {
+    results->assign(keys.size(), {});
+    for (size_t i = 0; i < keys.size(); i++) {
+      ScanKey(keys[i], &(*results)[i], transaction);
+    }
+  }
+
  private:
   /** The Index structure owns its metadata */
   std::unique_ptr<IndexMetadata> metadata_;
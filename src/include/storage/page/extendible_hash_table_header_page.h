@@ -0,0 +1,137 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table_header_page.h
+//
+// Identification: src/include/storage/page/extendible_hash_table_header_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cassert>
+#include <climits>
+#include <cstdlib>
+#include <string>
+
+#include "common/config.h"
+#include "storage/page/hash_table_page_defs.h"
+
+namespace bustub {
+
+/**
+ *
+ * Header Page for extendible hash table.
+ *
+ * The header is the first level of an extendible hash table: an extendible directory of directory pages. A directory
+ * page maps the low DIRECTORY_MAX_DEPTH bits of a hash to a bucket; the header maps the next bits of the hash to a
+ * directory page, so that the table can have up to HEADER_ARRAY_SIZE directory pages of DIRECTORY_ARRAY_SIZE buckets,
+ * and a lookup still reads only two pages before the bucket.
+ *
+ * Like buckets in a directory page, a directory page is shared by 2^(GlobalDepth - LocalDepth) header slots. When it
+ * is full and one of its buckets needs to split again, it is split in two on the next hash bit, see
+ * ExtendibleHashTable::SplitDirectory.
+ *
+ * Header format (size in byte):
+ * ---------------------------------------------------------------------------------------------------
+ * | PageId(4) | LSN(4) | GlobalDepth(4) | LocalDepths(512) | DirectoryPageIds(2048) | Free(1524)
+ * ---------------------------------------------------------------------------------------------------
+ */
+class ExtendibleHashTableHeaderPage {
+ public:
+  /**
+   * @return the page ID of this page
+   */
+  auto GetPageId() const -> page_id_t;
+
+  /**
+   * Sets the page ID of this page
+   *
+   * @param page_id the page id to which to set the page_id_ field
+   */
+  void SetPageId(page_id_t page_id);
+
+  /**
+   * @return the lsn of this page
+   */
+  auto GetLSN() const -> lsn_t;
+
+  /**
+   * Sets the LSN of this page
+   *
+   * @param lsn the log sequence number to which to set the lsn field
+   */
+  void SetLSN(lsn_t lsn);
+
+  /**
+   * Lookup a directory page using a header index
+   *
+   * @param header_idx the index in the header to lookup
+   * @return directory page_id corresponding to header_idx
+   */
+  auto GetDirectoryPageId(uint32_t header_idx) const -> page_id_t;
+
+  /**
+   * Updates the header index using a header index and page_id
+   *
+   * @param header_idx header index at which to insert page_id
+   * @param directory_page_id page_id to insert
+   */
+  void SetDirectoryPageId(uint32_t header_idx, page_id_t directory_page_id);
+
+  /**
+   * @return mask of global_depth 1's and the rest 0's (with 1's from LSB upwards)
+   */
+  auto GetGlobalDepthMask() const -> uint32_t;
+
+  /**
+   * @return the global depth of the header
+   */
+  auto GetGlobalDepth() const -> uint32_t;
+
+  /**
+   * Double the header: the new upper half of the slots points to the same directory pages as the lower half.
+   */
+  void IncrGlobalDepth();
+
+  /**
+   * @return the current header size
+   */
+  auto Size() const -> uint32_t;
+
+  /**
+   * Gets the local depth of the directory page at header_idx
+   *
+   * @param header_idx the header index to lookup
+   * @return the local depth of the directory page at header_idx
+   */
+  auto GetLocalDepth(uint32_t header_idx) const -> uint32_t;
+
+  /**
+   * Set the local depth of the directory page at header_idx to local_depth
+   *
+   * @param header_idx header index to update
+   * @param local_depth new local depth
+   */
+  void SetLocalDepth(uint32_t header_idx, uint8_t local_depth);
+
+  /**
+   * Verify the following invariants:
+   * (1) All LD <= GD.
+   * (2) Each directory page has precisely 2^(GD - LD) slots pointing to it.
+   * (3) The LD is the same at each index with the same directory_page_id
+   */
+  void VerifyIntegrity() const;
+
+ private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  uint32_t global_depth_{0};
+  uint8_t local_depths_[HEADER_ARRAY_SIZE];
+  page_id_t directory_page_ids_[HEADER_ARRAY_SIZE];
+};
+
+}  // namespace bustub
@@ -0,0 +1,110 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_page.h
+//
+// Identification: src/include/storage/page/free_space_map_page.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * A free space map (FSM) page records how many bytes are free in each page of a TableHeap, so that inserts can jump
+ * straight to a page with enough room instead of walking the whole page chain. The FSM of a table is a singly-linked
+ * list of these pages; entries are appended in the same order as the table pages are linked.
+ *
+ * The recorded values are only hints. They are refreshed whenever the table page is modified through the TableHeap,
+ * and a stale value is corrected as soon as an insert finds that the page does not have the advertised room.
+ *
+ *  Format (size in bytes):
+ *  ------------------------------------------------------------------------------------------------------
+ *  | PageId (4) | LSN (4) | NextPageId (4) | EntryCount (4) | TablePageId_1 (4) | FreeSpace_1 (4) | ... |
+ *  ------------------------------------------------------------------------------------------------------
+ */
+class FreeSpaceMapPage : public Page {
+ public:
+  /** Maximum number of table pages a single FSM page can track. */
+  static constexpr uint32_t CAPACITY = (PAGE_SIZE - 16) / 8;
+
+  /**
+   * Initialize the FreeSpaceMapPage header.
+   * @param page_id the page ID of this FSM page
+   */
+  void Init(page_id_t page_id);
+
+  /** @return the page ID of this FSM page, as stored in the page itself */
+  auto GetFreeSpaceMapPageId() -> page_id_t { return *reinterpret_cast<page_id_t *>(GetData()); }
+
+  /** @return the page ID of the next FSM page of the table */
+  auto GetNextPageId() -> page_id_t { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
+
+  /** Set the page ID of the next FSM page of the table. */
+  void SetNextPageId(page_id_t next_page_id) {
+    memcpy(GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
+  }
+
+  /** @return the number of table pages tracked by this FSM page */
+  auto GetEntryCount() -> uint32_t { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_ENTRY_COUNT); }
+
+  /** @return true if no more table pages can be tracked by this FSM page */
+  auto IsFull() -> bool { return GetEntryCount() >= CAPACITY; }
+
+  /** @return the table page ID tracked at slot slot_num */
+  auto GetTablePageId(uint32_t slot_num) -> page_id_t {
+    return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_ENTRIES + SIZE_ENTRY * slot_num);
+  }
+
+  /** @return the free space recorded at slot slot_num */
+  auto GetFreeSpace(uint32_t slot_num) -> uint32_t {
+    return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_ENTRIES + SIZE_ENTRY * slot_num + sizeof(page_id_t));
+  }
+
+  /** Record free_space as the free space of the table page tracked at slot slot_num. */
+  void SetFreeSpace(uint32_t slot_num, uint32_t free_space) {
+    memcpy(GetData() + OFFSET_ENTRIES + SIZE_ENTRY * slot_num + sizeof(page_id_t), &free_space, sizeof(uint32_t));
+  }
+
+  /**
+   * Start tracking a new table page.
+   * @param table_page_id the page ID of the table page
+   * @param free_space the free space of the table page
+   * @return the slot the table page is tracked at, or CAPACITY if this FSM page is full
+   */
+  auto AppendEntry(page_id_t table_page_id, uint32_t free_space) -> uint32_t;
+
+  /**
+   * Find a table page with at least the requested amount of free space.
+   * @param required the number of bytes required
+   * @param[out] slot_num the slot of the first table page with enough free space
+   * @return true if such a table page is tracked by this FSM page
+   */
+  auto FindEntry(uint32_t required, uint32_t *slot_num) -> bool;
+
+  /** @return the largest free space recorded on this FSM page */
+  auto GetMaxFreeSpace() -> uint32_t;
+
+ private:
+  static_assert(sizeof(page_id_t) == 4);
+
+  static constexpr size_t SIZE_FSM_PAGE_HEADER = 16;
+  static constexpr size_t SIZE_ENTRY = 8;
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = 8;
+  static constexpr size_t OFFSET_ENTRY_COUNT = 12;
+  static constexpr size_t OFFSET_ENTRIES = 16;
+  static_assert(CAPACITY == (PAGE_SIZE - SIZE_FSM_PAGE_HEADER) / SIZE_ENTRY);
+
+  /** Set the number of table pages tracked by this FSM page. */
+  void SetEntryCount(uint32_t entry_count) { memcpy(GetData() + OFFSET_ENTRY_COUNT, &entry_count, sizeof(uint32_t)); }
+};
+
+}  // namespace bustub
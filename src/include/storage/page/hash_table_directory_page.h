@@ -63,7 +63,14 @@ class HashTableDirectoryPage {
    * @param bucket_idx the index in the directory to lookup
    * @return bucket page_id corresponding to bucket_idx
    */
-  auto GetBucketPageId(uint32_t bucket_idx) -> page_id_t;
+  auto GetBucketPageId(uint32_t bucket_idx) const -> page_id_t;
+
+  /**
+   * Prefetch a directory slot into the CPU caches, ahead of its GetBucketPageId.
+   *
+   * @param bucket_idx the index in the directory to prefetch
+   */
+  void PrefetchBucketPageId(uint32_t bucket_idx) const { __builtin_prefetch(&bucket_page_ids_[bucket_idx]); }
 
   /**
    * Updates the directory index using a bucket index and page_id
@@ -74,12 +81,13 @@ class HashTableDirectoryPage {
   void SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id);
 
   /**
-   * Gets the split image of an index
+   * Gets the split image of an index: the index of the bucket that the bucket at bucket_idx was split from, or into,
+   * when it got its local depth, which it merges with. Its local depth must not be 0.
    *
    * @param bucket_idx the directory index for which to find the split image
    * @return the directory index of the split image
    **/
-  auto GetSplitImageIndex(uint32_t bucket_idx) -> uint32_t;
+  auto GetSplitImageIndex(uint32_t bucket_idx) const -> uint32_t;
 
   /**
    * GetGlobalDepthMask - returns a mask of global_depth 1's and the rest 0's.
@@ -95,7 +103,7 @@ class HashTableDirectoryPage {
    *
    * @return mask of global_depth 1's and the rest 0's (with 1's from LSB upwards)
    */
-  auto GetGlobalDepthMask() -> uint32_t;
+  auto GetGlobalDepthMask() const -> uint32_t;
 
   /**
    * GetLocalDepthMask - same as global depth mask, except it
@@ -104,14 +112,14 @@ class HashTableDirectoryPage {
    * @param bucket_idx the index to use for looking up local depth
    * @return mask of local 1's and the rest 0's (with 1's from LSB upwards)
    */
-  auto GetLocalDepthMask(uint32_t bucket_idx) -> uint32_t;
+  auto GetLocalDepthMask(uint32_t bucket_idx) const -> uint32_t;
 
   /**
    * Get the global depth of the hash table directory
    *
    * @return the global depth of the directory
    */
-  auto GetGlobalDepth() -> uint32_t;
+  auto GetGlobalDepth() const -> uint32_t;
 
   /**
    * Increment the global depth of the directory
@@ -126,12 +134,18 @@ class HashTableDirectoryPage {
   /**
    * @return true if the directory can be shrunk
    */
-  auto CanShrink() -> bool;
+  auto CanShrink() const -> bool;
+
+  /**
+   * Shrink the directory to the smallest global depth that its buckets allow, halving it as long as no bucket has a
+   * local depth equal to the global depth.
+   */
+  void Shrink();
 
   /**
    * @return the current directory size
    */
-  auto Size() -> uint32_t;
+  auto Size() const -> uint32_t;
 
   /**
    * Gets the local depth of the bucket at bucket_idx
@@ -139,7 +153,7 @@ class HashTableDirectoryPage {
    * @param bucket_idx the bucket index to lookup
    * @return the local depth of the bucket at bucket_idx
    */
-  auto GetLocalDepth(uint32_t bucket_idx) -> uint32_t;
+  auto GetLocalDepth(uint32_t bucket_idx) const -> uint32_t;
 
   /**
    * Set the local depth of the bucket at bucket_idx to local_depth
@@ -169,7 +183,7 @@ class HashTableDirectoryPage {
    * @param bucket_idx bucket index to lookup
    * @return the high bit corresponding to the bucket's local depth
    */
-  auto GetLocalHighBit(uint32_t bucket_idx) -> uint32_t;
+  auto GetLocalHighBit(uint32_t bucket_idx) const -> uint32_t;
 
   /**
    * VerifyIntegrity
@@ -179,12 +193,12 @@ class HashTableDirectoryPage {
    * (2) Each bucket has precisely 2^(GD - LD) pointers pointing to it.
    * (3) The LD is the same at each index with the same bucket_page_id
    */
-  void VerifyIntegrity();
+  void VerifyIntegrity() const;
 
   /**
    * Prints the current directory
    */
-  void PrintDirectory();
+  void PrintDirectory() const;
 
  private:
   page_id_t page_id_;
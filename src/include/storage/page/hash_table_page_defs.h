@@ -33,12 +33,19 @@
  */
 #define HASH_TABLE_BUCKET_TYPE HashTableBucketPage<KeyType, ValueType, KeyComparator>
 #define DIRECTORY_ARRAY_SIZE 512
+/** The global depth at which a directory page is full, log2(DIRECTORY_ARRAY_SIZE). */
+#define DIRECTORY_MAX_DEPTH 9
+/** HEADER_ARRAY_SIZE is the number of directory page slots in the header page of an extendible hash table. */
+#define HEADER_ARRAY_SIZE 512
+/** The global depth at which the header page is full, log2(HEADER_ARRAY_SIZE). */
+#define HEADER_MAX_DEPTH 9
 
 /**
  * BUCKET_ARRAY_SIZE is the number of (key, value) pairs that can be stored in an extendible hashing bucket page.
  * It is an approximate calculation based on the size of MappingType (which is a std::pair of KeyType and ValueType).
- * For each key/value pair, we need two additional bits for occupied_ and readable_. 4 * (PAGE_SIZE - 4) / (4 * sizeof
- * (MappingType) + 1) = (PAGE_SIZE - 4)/(sizeof (MappingType) + 0.25) because 0.25 bytes = 2 bits is the space required
- * to maintain the occupied and readable flags for a key value pair.
+ * For each key/value pair, we need two additional bits for occupied_ and readable_, and a byte for its fingerprint.
+ * 4 * (PAGE_SIZE - 16) / (4 * sizeof (MappingType) + 5) = (PAGE_SIZE - 16)/(sizeof (MappingType) + 1.25) because 1.25
+ * bytes = 1 byte + 2 bits is the space required to maintain the fingerprint and the occupied and readable flags for a
+ * key value pair. The 16 bytes left over cover the rounding up of the flag arrays and the alignment of the pairs.
  */
-#define BUCKET_ARRAY_SIZE (4 * PAGE_SIZE / (4 * sizeof(MappingType) + 1))
+#define BUCKET_ARRAY_SIZE (4 * (PAGE_SIZE - 16) / (4 * sizeof(MappingType) + 5))
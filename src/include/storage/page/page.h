@@ -12,10 +12,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <memory>
 
 #include "common/config.h"
+#include "common/hybrid_latch.h"
 #include "common/rwlatch.h"
 
 namespace bustub {
@@ -25,13 +28,13 @@ namespace bustub {
  * held in main memory. Page also contains book-keeping information that is used by the buffer pool manager, e.g.
  * pin count, dirty flag, page id, etc.
  */
-class Page {
+class alignas(CACHE_LINE_SIZE) Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManagerInstance;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor of a page outside of a buffer pool, which owns its data. Zeros out the page data. */
+  Page() : data_(new char[PAGE_SIZE]), owned_data_(data_) { ResetMemory(); }
 
   /** Default destructor. */
   ~Page() = default;
@@ -39,6 +42,9 @@ class Page {
   /** @return the actual data contained within this page */
   inline auto GetData() -> char * { return data_; }
 
+  /** @return the actual data contained within this page, read-only */
+  inline auto GetData() const -> const char * { return data_; }
+
   /** @return the page id of this page */
   inline auto GetPageId() -> page_id_t { return page_id_; }
 
@@ -49,10 +55,18 @@ class Page {
   inline auto IsDirty() -> bool { return is_dirty_; }
 
   /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    // An odd version tells optimistic readers that the page is being modified.
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -60,6 +74,46 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Start an optimistic read of the page, which takes no latch and writes nothing shared.
+   * @return the version to validate the read against; odd if a writer holds the page, so that it never validates
+   */
+  inline auto GetVersion() const -> uint64_t { return version_.load(std::memory_order_acquire); }
+
+  /**
+   * Finish an optimistic read of the page.
+   * @param version the version returned by GetVersion when the read started
+   * @return true if no writer held the page during the read, so that what was read is consistent
+   */
+  inline auto ValidateVersion(uint64_t version) const -> bool {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (version & 1) == 0 && version_.load(std::memory_order_relaxed) == version;
+  }
+
+  /**
+   * Read the page optimistically, retrying a few times if a writer gets in the way, then under the read latch. The
+   * page must be pinned. As read may see the page in the middle of a write, it must start over from a clean state on
+   * every call, must not follow offsets or pointers read from the page outside of the page, and must only publish its
+   * result once it returns.
+   * @param read reads the page
+   */
+  template <class ReadFn>
+  void OptimisticRead(ReadFn &&read) {
+    for (int attempt = 0; attempt < OPTIMISTIC_READ_ATTEMPTS; attempt++) {
+      uint64_t version = GetVersion();
+      if ((version & 1) != 0) {
+        continue;
+      }
+      read();
+      if (ValidateVersion(version)) {
+        return;
+      }
+    }
+    RLatch();
+    read();
+    RUnlatch();
+  }
+
   /** @return the page LSN. */
   inline auto GetLSN() -> lsn_t { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -75,19 +129,31 @@ class Page {
   static constexpr size_t OFFSET_LSN = 4;
 
  private:
+  /**
+   * Constructor of a buffer pool frame, whose data lives in the frame arena of the buffer pool.
+   * @param data the zeroed out data of the frame
+   */
+  explicit Page(char *data) : data_(data) {}
+
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
   /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  char *data_;
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  /** The pin count of this page. Atomic, so that buffer pool hits on different pages do not share a lock. */
+  std::atomic<int> pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
   bool is_dirty_ = false;
-  /** Page latch. */
-  ReaderWriterLatch rwlatch_;
+  /** Page latch. A single word, so that it does not bloat every frame. */
+  HybridLatch rwlatch_;
+  /** Bumped when the write latch is taken and when it is released, odd while a writer holds the page. */
+  std::atomic<uint64_t> version_{0};
+  /** The data of a page outside of a buffer pool, nullptr for a buffer pool frame. */
+  std::unique_ptr<char[]> owned_data_;
 };
 
+static_assert(sizeof(Page) == CACHE_LINE_SIZE, "The metadata of a frame should fit in a cache line");
+
 }  // namespace bustub
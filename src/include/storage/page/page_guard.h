@@ -0,0 +1,208 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <type_traits>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+
+/**
+ * BasicPageGuard holds the pin of a buffer pool page and unpins it when it is dropped or destroyed, so that no return
+ * path can leak the pin. The page is unpinned as dirty if it was accessed through AsMut or marked with SetDirty.
+ *
+ * Guards are move-only; a moved-from guard, like a guard of a page that could not be fetched, holds nothing.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  /**
+   * Take over the pin of a page.
+   * @param bpm the buffer pool manager the page was pinned in
+   * @param page the pinned page, nullptr for an empty guard
+   */
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  auto operator=(const BasicPageGuard &) -> BasicPageGuard & = delete;
+
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** Drop the page held so far, then take over the page of that. */
+  auto operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard &;
+
+  ~BasicPageGuard() { Drop(); }
+
+  /** Unpin the page, after which the guard is empty. Does nothing if the guard is empty. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  auto IsValid() const -> bool { return page_ != nullptr; }
+
+  /** @return the id of the page held */
+  auto PageId() const -> page_id_t { return page_->GetPageId(); }
+
+  /** @return the page held */
+  auto GetPage() const -> Page * { return page_; }
+
+  /** @return the data of the page held */
+  auto GetData() const -> char * { return page_->GetData(); }
+
+  /**
+   * @return the data of the page held, viewed as a T; or, if T is a Page subclass like TablePage, which reaches its
+   * data through GetData, the page held itself
+   */
+  template <class T>
+  auto As() const -> const T * {
+    return Cast<T>();
+  }
+
+  /** @return the page held viewed as a T, see As, which is going to be modified */
+  template <class T>
+  auto AsMut() -> T * {
+    is_dirty_ = true;
+    return Cast<T>();
+  }
+
+  /** Unpin the page as dirty. */
+  void SetDirty() { is_dirty_ = true; }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  /** @return the page held viewed as a T, see As */
+  template <class T>
+  auto Cast() const -> T * {
+    if constexpr (std::is_base_of_v<Page, T>) {
+      return static_cast<T *>(page_);
+    } else {
+      return reinterpret_cast<T *>(page_->GetData());
+    }
+  }
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard holds the pin and the read latch of a page, and releases both when it is dropped or destroyed.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /**
+   * Take over the pin and the read latch of a page.
+   * @param bpm the buffer pool manager the page was pinned in
+   * @param page the pinned and read latched page, nullptr for an empty guard
+   */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  auto operator=(const ReadPageGuard &) -> ReadPageGuard & = delete;
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  /** Drop the page held so far, then take over the page of that. */
+  auto operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard &;
+
+  ~ReadPageGuard() { Drop(); }
+
+  /** Release the read latch and unpin the page, after which the guard is empty. Does nothing if the guard is empty. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+
+  /** @return the id of the page held */
+  auto PageId() const -> page_id_t { return guard_.PageId(); }
+
+  /** @return the page held */
+  auto GetPage() const -> Page * { return guard_.GetPage(); }
+
+  /** @return the data of the page held */
+  auto GetData() const -> const char * { return guard_.GetData(); }
+
+  /** @return the data of the page held, viewed as a T */
+  template <class T>
+  auto As() const -> const T * {
+    return guard_.As<T>();
+  }
+
+ private:
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard holds the pin and the write latch of a page, and releases both when it is dropped or destroyed.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /**
+   * Take over the pin and the write latch of a page.
+   * @param bpm the buffer pool manager the page was pinned in
+   * @param page the pinned and write latched page, nullptr for an empty guard
+   */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  auto operator=(const WritePageGuard &) -> WritePageGuard & = delete;
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  /** Drop the page held so far, then take over the page of that. */
+  auto operator=(WritePageGuard &&that) noexcept -> WritePageGuard &;
+
+  ~WritePageGuard() { Drop(); }
+
+  /** Release the write latch and unpin the page, after which the guard is empty. Does nothing if the guard is empty. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+
+  /** @return the id of the page held */
+  auto PageId() const -> page_id_t { return guard_.PageId(); }
+
+  /** @return the page held */
+  auto GetPage() const -> Page * { return guard_.GetPage(); }
+
+  /** @return the data of the page held */
+  auto GetData() const -> const char * { return guard_.GetData(); }
+
+  /** @return the data of the page held, viewed as a T */
+  template <class T>
+  auto As() const -> const T * {
+    return guard_.As<T>();
+  }
+
+  /** @return the data of the page held, viewed as a T, which is going to be modified */
+  template <class T>
+  auto AsMut() -> T * {
+    return guard_.AsMut<T>();
+  }
+
+  /** Unpin the page as dirty. */
+  void SetDirty() { guard_.SetDirty(); }
+
+ private:
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
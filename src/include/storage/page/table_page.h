@@ -36,10 +36,12 @@ namespace bustub {
  *  ----------------------------------------------------------------------------
  *  | PageId (4)| LSN (4)| PrevPageId (4)| NextPageId (4)| FreeSpacePointer(4) |
  *  ----------------------------------------------------------------------------
- *  ----------------------------------------------------------------
- *  | TupleCount (4) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
- *  ----------------------------------------------------------------
+ *  -------------------------------------------------------------------------------------------
+ *  | TupleCount (4) | FreeSpaceMapPageId (4) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
+ *  -------------------------------------------------------------------------------------------
  *
+ *  FreeSpaceMapPageId is only meaningful in the first page of a table, where it points at the first page of the
+ *  table's free space map (see FreeSpaceMapPage).
  */
 class TablePage : public Page {
  public:
@@ -54,13 +56,17 @@ class TablePage : public Page {
   void Init(page_id_t page_id, uint32_t page_size, page_id_t prev_page_id, LogManager *log_manager, Transaction *txn);
 
   /** @return the page ID of this table page */
-  auto GetTablePageId() -> page_id_t { return *reinterpret_cast<page_id_t *>(GetData()); }
+  auto GetTablePageId() const -> page_id_t { return *reinterpret_cast<const page_id_t *>(GetData()); }
 
   /** @return the page ID of the previous table page */
-  auto GetPrevPageId() -> page_id_t { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_PREV_PAGE_ID); }
+  auto GetPrevPageId() const -> page_id_t {
+    return *reinterpret_cast<const page_id_t *>(GetData() + OFFSET_PREV_PAGE_ID);
+  }
 
   /** @return the page ID of the next table page */
-  auto GetNextPageId() -> page_id_t { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
+  auto GetNextPageId() const -> page_id_t {
+    return *reinterpret_cast<const page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID);
+  }
 
   /** Set the page id of the previous page in the table. */
   void SetPrevPageId(page_id_t prev_page_id) {
@@ -72,6 +78,27 @@ class TablePage : public Page {
     memcpy(GetData() + OFFSET_NEXT_PAGE_ID, &next_page_id, sizeof(page_id_t));
   }
 
+  /** @return the page ID of the first free space map page of the table */
+  auto GetFreeSpaceMapPageId() const -> page_id_t {
+    return *reinterpret_cast<const page_id_t *>(GetData() + OFFSET_FREE_SPACE_MAP_PAGE_ID);
+  }
+
+  /** Set the page id of the first free space map page of the table. */
+  void SetFreeSpaceMapPageId(page_id_t fsm_page_id) {
+    memcpy(GetData() + OFFSET_FREE_SPACE_MAP_PAGE_ID, &fsm_page_id, sizeof(page_id_t));
+  }
+
+  /** @return the number of bytes left between the slot array and the tuple data */
+  auto GetFreeSpaceRemaining() const -> uint32_t {
+    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
+  }
+
+  /** @return the free space a page must have for a tuple of tuple_size bytes to be inserted into it */
+  static auto GetRequiredFreeSpace(uint32_t tuple_size) -> uint32_t { return tuple_size + SIZE_TUPLE; }
+
+  /** @return the size of the largest tuple that fits in an empty page */
+  static auto GetMaxTupleSize() -> uint32_t { return PAGE_SIZE - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE; }
+
   /**
    * Insert a tuple into the table.
    * @param tuple tuple to insert
@@ -121,7 +148,7 @@ class TablePage : public Page {
    * @param lock_manager the lock manager
    * @return true if the read is successful (i.e. the tuple exists)
    */
-  auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager) -> bool;
+  auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager) const -> bool;
 
   /** @return the rid of the first tuple in this page */
 
@@ -129,29 +156,32 @@ class TablePage : public Page {
    * @param[out] first_rid the RID of the first tuple in this page
    * @return true if the first tuple exists, false otherwise
    */
-  auto GetFirstTupleRid(RID *first_rid) -> bool;
+  auto GetFirstTupleRid(RID *first_rid) const -> bool;
 
   /**
    * @param cur_rid the RID of the current tuple
    * @param[out] next_rid the RID of the tuple following the current tuple
    * @return true if the next tuple exists, false otherwise
    */
-  auto GetNextTupleRid(const RID &cur_rid, RID *next_rid) -> bool;
+  auto GetNextTupleRid(const RID &cur_rid, RID *next_rid) const -> bool;
 
  private:
   static_assert(sizeof(page_id_t) == 4);
 
-  static constexpr size_t SIZE_TABLE_PAGE_HEADER = 24;
+  static constexpr size_t SIZE_TABLE_PAGE_HEADER = 28;
   static constexpr size_t SIZE_TUPLE = 8;
   static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
   static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
   static constexpr size_t OFFSET_FREE_SPACE = 16;
   static constexpr size_t OFFSET_TUPLE_COUNT = 20;
-  static constexpr size_t OFFSET_TUPLE_OFFSET = 24;  // Naming things is hard.
-  static constexpr size_t OFFSET_TUPLE_SIZE = 28;
+  static constexpr size_t OFFSET_FREE_SPACE_MAP_PAGE_ID = 24;
+  static constexpr size_t OFFSET_TUPLE_OFFSET = 28;  // Naming things is hard.
+  static constexpr size_t OFFSET_TUPLE_SIZE = 32;
 
   /** @return pointer to the end of the current free space, see header comment */
-  auto GetFreeSpacePointer() -> uint32_t { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
+  auto GetFreeSpacePointer() const -> uint32_t {
+    return *reinterpret_cast<const uint32_t *>(GetData() + OFFSET_FREE_SPACE);
+  }
 
   /** Sets the pointer, this should be the end of the current free space. */
   void SetFreeSpacePointer(uint32_t free_space_pointer) {
@@ -162,18 +192,16 @@ class TablePage : public Page {
    * @note returned tuple count may be an overestimate because some slots may be empty
    * @return at least the number of tuples in this page
    */
-  auto GetTupleCount() -> uint32_t { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_COUNT); }
+  auto GetTupleCount() const -> uint32_t {
+    return *reinterpret_cast<const uint32_t *>(GetData() + OFFSET_TUPLE_COUNT);
+  }
 
   /** Set the number of tuples in this page. */
   void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
 
-  auto GetFreeSpaceRemaining() -> uint32_t {
-    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
-  }
-
   /** @return tuple offset at slot slot_num */
-  auto GetTupleOffsetAtSlot(uint32_t slot_num) -> uint32_t {
-    return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
+  auto GetTupleOffsetAtSlot(uint32_t slot_num) const -> uint32_t {
+    return *reinterpret_cast<const uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
   }
 
   /** Set tuple offset at slot slot_num. */
@@ -182,8 +210,8 @@ class TablePage : public Page {
   }
 
   /** @return tuple size at slot slot_num */
-  auto GetTupleSize(uint32_t slot_num) -> uint32_t {
-    return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num);
+  auto GetTupleSize(uint32_t slot_num) const -> uint32_t {
+    return *reinterpret_cast<const uint32_t *>(GetData() + OFFSET_TUPLE_SIZE + SIZE_TUPLE * slot_num);
   }
 
   /** Set tuple size at slot slot_num. */
@@ -12,8 +12,13 @@
 
 #pragma once
 
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
+#include "storage/page/free_space_map_page.h"
 #include "storage/page/table_page.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
@@ -22,7 +27,8 @@ namespace bustub {
 
 /**
  * TableHeap represents a physical table on disk.
- * This is just a doubly-linked list of pages.
+ * This is just a doubly-linked list of pages, plus a free space map (see FreeSpaceMapPage) that lets inserts find a
+ * page with enough room without walking the list.
  */
 class TableHeap {
   friend class TableIterator;
@@ -55,9 +61,11 @@ class TableHeap {
    * @param tuple tuple to insert
    * @param[out] rid the rid of the inserted tuple
    * @param txn the transaction performing the insert
+   * @param strategy the buffer access strategy for the table pages, nullptr for NORMAL; bulk inserts should use a
+   * BULK_WRITE strategy
    * @return true iff the insert is successful
    */
-  auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> bool;
+  auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, BufferAccessStrategy *strategy = nullptr) -> bool;
 
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
@@ -99,7 +107,7 @@ class TableHeap {
    */
   auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) -> bool;
 
-  /** @return the begin iterator of this table */
+  /** @return the begin iterator of this table; it reads the table through a SEQUENTIAL_SCAN strategy */
   auto Begin(Transaction *txn) -> TableIterator;
 
   /** @return the end iterator of this table */
@@ -109,10 +117,75 @@ class TableHeap {
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
  private:
+  /**
+   * Load the free space map into memory, unless that has already happened. Pages that were linked into the table
+   * after the free space map was last persisted are tracked again, and a missing free space map is rebuilt.
+   * Must be called with fsm_latch_ held.
+   */
+  void LoadFreeSpaceMap();
+
+  /**
+   * Must be called with fsm_latch_ held.
+   * @param required the number of bytes of free space required
+   * @return the id of a page which has at least that much free space according to the FSM, INVALID_PAGE_ID otherwise
+   */
+  auto FindPageWithFreeSpace(uint32_t required) -> page_id_t;
+
+  /**
+   * Record the free space of a page in the FSM. Must be called with fsm_latch_ held.
+   * @param page_id the id of the table page
+   * @param free_space the free space of the table page
+   */
+  void UpdateFreeSpace(page_id_t page_id, uint32_t free_space);
+
+  /**
+   * Start tracking a page that was linked at the end of the table. Must be called with fsm_latch_ held.
+   * @param page_id the id of the table page
+   * @param free_space the free space of the table page
+   * @return false if a new FSM page was needed but could not be created
+   */
+  auto TrackPage(page_id_t page_id, uint32_t free_space) -> bool;
+
+  /** Fetch a table page, following an access strategy unless it is nullptr. */
+  auto FetchTablePage(page_id_t page_id, BufferAccessStrategy *strategy) -> TablePage * {
+    return static_cast<TablePage *>(strategy == nullptr ? buffer_pool_manager_->FetchPage(page_id)
+                                                        : buffer_pool_manager_->FetchPage(page_id, *strategy));
+  }
+
+  /** Create a table page, following an access strategy unless it is nullptr. */
+  auto NewTablePage(page_id_t *page_id, BufferAccessStrategy *strategy) -> TablePage * {
+    return static_cast<TablePage *>(strategy == nullptr ? buffer_pool_manager_->NewPage(page_id)
+                                                        : buffer_pool_manager_->NewPage(page_id, *strategy));
+  }
+
+  /** Start reading table pages into the buffer pool, following an access strategy unless it is nullptr. */
+  void PrefetchTablePages(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy) {
+    if (strategy == nullptr) {
+      buffer_pool_manager_->PrefetchPages(page_ids);
+    } else {
+      buffer_pool_manager_->PrefetchPages(page_ids, *strategy);
+    }
+  }
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+
+  /** Protects the members below, the FSM pages and the end of the page list. */
+  std::mutex fsm_latch_;
+  /** True once the FSM has been loaded by LoadFreeSpaceMap. */
+  bool fsm_loaded_{false};
+  /** The FSM pages, in list order. */
+  std::vector<page_id_t> fsm_page_ids_;
+  /** Upper bound on the free space recorded on each FSM page, used to skip pages while searching. */
+  std::vector<uint32_t> fsm_max_free_space_;
+  /** Maps a table page id to its FSM entry, which is at slot (entry % CAPACITY) of FSM page (entry / CAPACITY). */
+  std::unordered_map<page_id_t, uint32_t> fsm_entries_;
+  /** The FSM page at which the next search starts. */
+  size_t fsm_search_hint_{0};
+  /** The id of the last page in the list. */
+  page_id_t last_page_id_{INVALID_PAGE_ID};
 };
 
 }  // namespace bustub
@@ -13,7 +13,10 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
+#include <utility>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -21,6 +24,7 @@
 namespace bustub {
 
 class TableHeap;
+class TablePage;
 
 /**
  * TableIterator enables the sequential scan of a TableHeap.
@@ -29,10 +33,16 @@ class TableIterator {
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_),
+        prefetch_frontier_(other.prefetch_frontier_),
+        num_prefetched_ahead_(other.num_prefetched_ahead_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -54,13 +64,29 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
+    prefetch_frontier_ = other.prefetch_frontier_;
+    num_prefetched_ahead_ = other.num_prefetched_ahead_;
     return *this;
   }
 
  private:
+  /**
+   * Keep the next pages of the chain being read in the background, so that the scan does not wait for one page read
+   * after another. Called whenever the iterator moves to a new page.
+   * @param cur_page the page the iterator moved to, read latched
+   */
+  void PrefetchAhead(TablePage *cur_page);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** The buffer access strategy of the scan, shared by the copies of the iterator; nullptr for NORMAL. */
+  std::shared_ptr<BufferAccessStrategy> strategy_;
+  /** The last page of the chain whose prefetch was started, INVALID_PAGE_ID before the first one. */
+  page_id_t prefetch_frontier_{INVALID_PAGE_ID};
+  /** Number of pages between the current page and the prefetch frontier. */
+  size_t num_prefetched_ahead_{0};
 };
 
 }  // namespace bustub
@@ -0,0 +1,317 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_manager.cpp
+//
+// Identification: src/storage/disk/async_disk_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/async_disk_manager.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+static constexpr uint32_t MAX_WORKER_THREADS = 16;
+
+AsyncDiskManager::AsyncDiskManager(DiskManager *disk_manager, uint32_t queue_depth, bool use_io_uring)
+    : disk_manager_(disk_manager), queue_depth_(queue_depth) {
+  BUSTUB_ASSERT(queue_depth > 0, "The queue must hold at least one request.");
+  if (use_io_uring && SetUpIoUring(queue_depth)) {
+    threads_.emplace_back(&AsyncDiskManager::RunCompletionThread, this);
+    return;
+  }
+  // Fall back to worker threads issuing synchronous I/O.
+  for (uint32_t i = 0; i < std::min(queue_depth, MAX_WORKER_THREADS); i++) {
+    threads_.emplace_back(&AsyncDiskManager::RunWorkerThread, this);
+  }
+}
+
+AsyncDiskManager::~AsyncDiskManager() {
+  {
+    std::unique_lock<std::mutex> lock(sq_latch_);
+    sq_cv_.wait(lock, [&] { return num_in_flight_ == 0; });
+    shut_down_ = true;
+    if (IsIoUringEnabled()) {
+      // A NOP without a request wakes up the completion thread and tells it to exit.
+      PushSubmission(nullptr);
+    }
+  }
+  sq_cv_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+  TearDownIoUring();
+}
+
+void AsyncDiskManager::ReadPage(page_id_t page_id, char *page_data, Callback callback) {
+  Submit(new Request{false, page_id, page_data, std::move(callback)});
+}
+
+void AsyncDiskManager::WritePage(page_id_t page_id, const char *page_data, Callback callback) {
+  // The buffer is only ever read from for a write.
+  Submit(new Request{true, page_id, const_cast<char *>(page_data), std::move(callback)});
+}
+
+auto AsyncDiskManager::ReadPage(page_id_t page_id, char *page_data) -> std::future<bool> {
+  auto promise = std::make_shared<std::promise<bool>>();
+  auto future = promise->get_future();
+  ReadPage(page_id, page_data, [promise](bool success) { promise->set_value(success); });
+  return future;
+}
+
+auto AsyncDiskManager::WritePage(page_id_t page_id, const char *page_data) -> std::future<bool> {
+  auto promise = std::make_shared<std::promise<bool>>();
+  auto future = promise->get_future();
+  WritePage(page_id, page_data, [promise](bool success) { promise->set_value(success); });
+  return future;
+}
+
+void AsyncDiskManager::Submit(Request *request) {
+  if (IsIoUringEnabled() && disk_manager_->IsDirectIo() && !DiskManager::IsAligned(request->page_data_)) {
+    // io_uring would hand the buffer to O_DIRECT as is; DiskManager bounces it through an aligned one.
+    bool success = ServeSynchronously(request);
+    Callback callback = std::move(request->callback_);
+    delete request;
+    callback(success);
+    return;
+  }
+  if (IsIoUringEnabled() && request->is_write_ && disk_manager_->crc_fd_ >= 0) {
+    // The page may change under the write, so a copy is written that matches its checksum, as in DiskManager;
+    // the worker threads leave that to DiskManager::WritePage.
+    request->snapshot_.reset(static_cast<char *>(std::aligned_alloc(PAGE_SIZE, PAGE_SIZE)));
+    memcpy(request->snapshot_.get(), request->page_data_, PAGE_SIZE);
+    request->checksum_ = DiskManager::PageChecksum(request->snapshot_.get());
+    request->page_data_ = request->snapshot_.get();
+  }
+  if (IsIoUringEnabled() && request->is_write_) {
+    // As in DiskManager, the page leaves the free page bitmap before its data goes out.
+    disk_manager_->MarkPagesUsed(request->page_id_, 1);
+  }
+  std::unique_lock<std::mutex> lock(sq_latch_);
+  sq_cv_.wait(lock, [&] { return num_in_flight_ < queue_depth_; });
+  num_in_flight_++;
+  if (!IsIoUringEnabled()) {
+    worker_queue_.push_back(request);
+    lock.unlock();
+    sq_cv_.notify_all();
+    return;
+  }
+  if (request->is_write_) {
+    disk_manager_->num_writes_ += 1;
+  }
+  request->start_ = std::chrono::steady_clock::now();
+  PushSubmission(request);
+}
+
+void AsyncDiskManager::Complete(Request *request, bool success) {
+  Callback callback = std::move(request->callback_);
+  delete request;
+  callback(success);
+  {
+    std::scoped_lock lock(sq_latch_);
+    num_in_flight_--;
+  }
+  sq_cv_.notify_all();
+}
+
+/*****************************************************************************
+ * IO_URING
+ *****************************************************************************/
+auto AsyncDiskManager::SetUpIoUring(uint32_t queue_depth) -> bool {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth, &params));
+  if (ring_fd < 0) {
+    LOG_DEBUG("io_uring is not available, falling back to worker threads");
+    return false;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                  IORING_OFF_SQ_RING);
+  cq_ring_ = single_mmap ? sq_ring_
+                         : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                                IORING_OFF_CQ_RING);
+  sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  ring_fd_ = ring_fd;
+  if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes_ == MAP_FAILED) {
+    LOG_DEBUG("failed to map the io_uring queues, falling back to worker threads");
+    TearDownIoUring();
+    return false;
+  }
+
+  auto *sq_ring = static_cast<char *>(sq_ring_);
+  sq_tail_ = reinterpret_cast<uint32_t *>(sq_ring + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<uint32_t *>(sq_ring + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<uint32_t *>(sq_ring + params.sq_off.array);
+  auto *cq_ring = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<uint32_t *>(cq_ring + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<uint32_t *>(cq_ring + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<uint32_t *>(cq_ring + params.cq_off.ring_mask);
+  cqes_ = cq_ring + params.cq_off.cqes;
+  return true;
+}
+
+void AsyncDiskManager::TearDownIoUring() {
+  if (ring_fd_ < 0) {
+    return;
+  }
+  if (sqes_ != nullptr && sqes_ != MAP_FAILED) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr && sq_ring_ != MAP_FAILED) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  sq_ring_ = cq_ring_ = sqes_ = nullptr;
+  close(ring_fd_);
+  ring_fd_ = -1;
+}
+
+void AsyncDiskManager::PushSubmission(Request *request) {
+  // Only this thread moves the tail, the kernel moves the head as it consumes entries.
+  uint32_t tail = *sq_tail_;
+  uint32_t index = tail & *sq_mask_;
+  auto *sqe = static_cast<struct io_uring_sqe *>(sqes_) + index;
+  memset(sqe, 0, sizeof(*sqe));
+  if (request == nullptr) {
+    sqe->opcode = IORING_OP_NOP;
+  } else {
+    request->iov_.iov_base = request->page_data_ + request->done_;
+    request->iov_.iov_len = PAGE_SIZE - request->done_;
+    sqe->opcode = request->is_write_ ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = disk_manager_->db_fd_;
+    sqe->off = static_cast<uint64_t>(request->page_id_) * PAGE_SIZE + request->done_;
+    sqe->addr = reinterpret_cast<uint64_t>(&request->iov_);
+    sqe->len = 1;
+  }
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  while (syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0) < 0) {
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      LOG_DEBUG("I/O error while submitting to io_uring");
+      break;
+    }
+  }
+}
+
+void AsyncDiskManager::RunCompletionThread() {
+  while (true) {
+    syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+    bool stop = false;
+    // Only this thread moves the head, the kernel moves the tail as requests complete.
+    uint32_t head = *cq_head_;
+    uint32_t tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+      auto *cqe = static_cast<struct io_uring_cqe *>(cqes_) + (head & *cq_mask_);
+      auto *request = reinterpret_cast<Request *>(cqe->user_data);
+      int res = cqe->res;
+      __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+      if (request == nullptr) {
+        stop = true;
+        continue;
+      }
+      if (res == -EINTR || res == -EAGAIN) {
+        std::scoped_lock lock(sq_latch_);
+        PushSubmission(request);
+        continue;
+      }
+      if (res < 0 || (res == 0 && request->is_write_)) {
+        LOG_DEBUG("I/O error while %s page %d", request->is_write_ ? "writing" : "reading", request->page_id_);
+        Complete(request, false);
+        continue;
+      }
+      request->done_ += res;
+      if (res == 0) {
+        // The file ends before the page does.
+        memset(request->page_data_ + request->done_, 0, PAGE_SIZE - request->done_);
+        request->done_ = PAGE_SIZE;
+      }
+      if (request->done_ < PAGE_SIZE && disk_manager_->IsDirectIo()) {
+        // O_DIRECT cannot go on from an unaligned offset. Pages are only ever written whole, so a short transfer
+        // means the device failed part way through.
+        LOG_DEBUG("Short %s of page %d under direct I/O", request->is_write_ ? "write" : "read", request->page_id_);
+        Complete(request, false);
+        continue;
+      }
+      if (request->done_ < PAGE_SIZE) {
+        std::scoped_lock lock(sq_latch_);
+        PushSubmission(request);
+        continue;
+      }
+      // Synchronous requests are recorded by DiskManager, these are recorded here.
+      (request->is_write_ ? disk_manager_->write_latency_ : disk_manager_->read_latency_).RecordSince(request->start_);
+      if (request->is_write_) {
+        disk_manager_->StoreChecksums(request->page_id_, &request->checksum_, 1);
+        disk_manager_->ExtendFileSize(static_cast<size_t>(request->page_id_ + 1) * PAGE_SIZE);
+        Complete(request, true);
+        continue;
+      }
+      Complete(request, disk_manager_->VerifyChecksum(request->page_id_, request->page_data_));
+    }
+    if (stop) {
+      return;
+    }
+  }
+}
+
+/*****************************************************************************
+ * WORKER THREADS
+ *****************************************************************************/
+void AsyncDiskManager::RunWorkerThread() {
+  while (true) {
+    Request *request;
+    {
+      std::unique_lock<std::mutex> lock(sq_latch_);
+      sq_cv_.wait(lock, [&] { return shut_down_ || !worker_queue_.empty(); });
+      if (worker_queue_.empty()) {
+        return;
+      }
+      request = worker_queue_.front();
+      worker_queue_.pop_front();
+    }
+    Complete(request, ServeSynchronously(request));
+  }
+}
+
+auto AsyncDiskManager::ServeSynchronously(Request *request) -> bool {
+  if (request->is_write_) {
+    disk_manager_->WritePage(request->page_id_, request->page_data_);
+    return true;
+  }
+  try {
+    disk_manager_->ReadPage(request->page_id_, request->page_data_);
+  } catch (const Exception &e) {
+    // the page failed checksum verification
+    return false;
+  }
+  return true;
+}
+
+}  // namespace bustub
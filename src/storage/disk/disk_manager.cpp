@@ -10,16 +10,27 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <chrono>  // NOLINT
+#include <climits>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <mutex>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/util/crc32c_util.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
@@ -30,7 +41,9 @@ static char *buffer_used;
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+DiskManager::DiskManager(const std::string &db_file, uint32_t sync_interval, bool direct_io,
+                         PageChecksumMode checksum_mode)
+    : file_name_(db_file), sync_interval_(sync_interval), checksum_mode_(checksum_mode) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -52,82 +65,441 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
     }
   }
 
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+  // open the db file, creating it if it does not exist
+  if (direct_io) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_DIRECT, 0644);
+    // some file systems, e.g. tmpfs, do not support O_DIRECT
+    if (db_fd_ >= 0) {
+      direct_io_ = true;
+    } else if (errno == EINVAL) {
+      LOG_DEBUG("O_DIRECT not supported, falling back to buffered I/O");
+    }
+  }
+  if (db_fd_ < 0) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  }
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) == 0) {
+    db_file_size_ = static_cast<size_t>(stat_buf.st_size);
+  }
+
+  // open the checksum file, it is small and read a few bytes at a time, so it goes through the OS cache
+  if (checksum_mode_ != PageChecksumMode::DISABLED) {
+    crc_name_ = file_name_.substr(0, n) + ".crc";
+    crc_fd_ = open(crc_name_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (crc_fd_ < 0) {
+      throw Exception("can't open checksum file");
+    }
+  }
+
+  // load the free page bitmap if there is one; bits past the end of the db file are stale, e.g. from a db file that
+  // was deleted and created anew
+  free_name_ = file_name_.substr(0, n) + ".free";
+  free_fd_ = open(free_name_.c_str(), O_RDWR | O_CLOEXEC);
+  if (free_fd_ >= 0 && fstat(free_fd_, &stat_buf) == 0) {
+    free_bitmap_.resize(stat_buf.st_size);
+    if (pread(free_fd_, free_bitmap_.data(), free_bitmap_.size(), 0) != static_cast<ssize_t>(free_bitmap_.size())) {
+      LOG_DEBUG("I/O error while reading free page file");
+      free_bitmap_.assign(free_bitmap_.size(), 0);
+    }
+    for (uint8_t bits : free_bitmap_) {
+      num_free_pages_ += __builtin_popcount(bits);
     }
+    TrimFreeBits(GetNumPages());
   }
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() {
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
+  if (crc_fd_ >= 0) {
+    close(crc_fd_);
+  }
+  if (free_fd_ >= 0) {
+    close(free_fd_);
+  }
+}
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  if (crc_fd_ >= 0) {
+    close(crc_fd_);
+    crc_fd_ = -1;
+  }
   {
-    std::scoped_lock scoped_db_io_latch(db_io_latch_);
-    db_io_.close();
+    std::scoped_lock lock(free_latch_);
+    if (free_fd_ >= 0) {
+      close(free_fd_);
+      free_fd_ = -1;
+    }
   }
   log_io_.close();
 }
 
+/**
+ * Cut the db file down to num_pages pages
+ */
+void DiskManager::Truncate(page_id_t num_pages) {
+  size_t file_size = static_cast<size_t>(num_pages) * PAGE_SIZE;
+  if (file_size >= db_file_size_.load()) {
+    return;
+  }
+  if (ftruncate(db_fd_, file_size) != 0) {
+    LOG_DEBUG("I/O error while truncating");
+    return;
+  }
+  db_file_size_ = file_size;
+  // drop the checksums of the pages cut off, so that pages written there again are not verified against them
+  if (crc_fd_ >= 0 && ftruncate(crc_fd_, static_cast<off_t>(num_pages) * sizeof(uint32_t)) != 0) {
+    LOG_DEBUG("I/O error while truncating checksum file");
+  }
+  // and the free page bits, so that pages allocated there again are not taken for free ones when the file is reopened
+  std::scoped_lock lock(free_latch_);
+  TrimFreeBits(num_pages);
+}
+
+/**
+ * Mark a deallocated page free in the free page bitmap
+ */
+void DiskManager::MarkPageFree(page_id_t page_id) {
+  std::scoped_lock lock(free_latch_);
+  if (free_fd_ < 0) {
+    if (db_fd_ < 0 || free_name_.empty()) {
+      return;
+    }
+    free_fd_ = open(free_name_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (free_fd_ < 0) {
+      LOG_DEBUG("can't open free page file");
+      return;
+    }
+  }
+  size_t byte = static_cast<size_t>(page_id) / 8;
+  uint8_t bit = 1U << (page_id % 8);
+  if (byte >= free_bitmap_.size()) {
+    free_bitmap_.resize(byte + 1);
+  }
+  if ((free_bitmap_[byte] & bit) != 0) {
+    return;
+  }
+  free_bitmap_[byte] |= bit;
+  num_free_pages_++;
+  StoreFreeBits(page_id);
+}
+
+auto DiskManager::GetFreePages() -> std::vector<page_id_t> {
+  std::vector<page_id_t> free_pages;
+  page_id_t num_pages = GetNumPages();
+  std::scoped_lock lock(free_latch_);
+  for (size_t byte = 0; byte < free_bitmap_.size(); byte++) {
+    for (uint32_t bits = free_bitmap_[byte]; bits != 0; bits &= bits - 1) {
+      auto page_id = static_cast<page_id_t>(byte * 8 + __builtin_ctz(bits));
+      // a page freed before it was ever written is past the end of the file, where pages are allocated anyway
+      if (page_id < num_pages) {
+        free_pages.push_back(page_id);
+      }
+    }
+  }
+  return free_pages;
+}
+
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  // with checksums, the page may change under the write, so a copy is written that matches its checksum
+  if (crc_fd_ >= 0 || (direct_io_ && !IsAligned(page_data))) {
+    std::unique_ptr<char, decltype(&free)> bounce(static_cast<char *>(std::aligned_alloc(PAGE_SIZE, PAGE_SIZE)), &free);
+    memcpy(bounce.get(), page_data, PAGE_SIZE);
+    WriteAlignedPage(page_id, bounce.get());
+    return;
+  }
+  WriteAlignedPage(page_id, page_data);
+}
+
+void DiskManager::WriteAlignedPage(page_id_t page_id, const char *page_data) {
   size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
+  uint32_t checksum = crc_fd_ >= 0 ? PageChecksum(page_data) : 0;
+  MarkPagesUsed(page_id, 1);
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
+  auto start = std::chrono::steady_clock::now();
+  size_t written = 0;
+  while (written < PAGE_SIZE) {
+    ssize_t rc = pwrite(db_fd_, page_data + written, PAGE_SIZE - written, offset + written);
+    // check for I/O error
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    written += rc;
+  }
+  write_latency_.RecordSince(start);
+  StoreChecksums(page_id, &checksum, 1);
+  // remember the new end of file
+  ExtendFileSize(offset + PAGE_SIZE);
+  // batch the syncs to disk if requested
+  if (sync_interval_ > 0 && ++writes_since_sync_ >= sync_interval_) {
+    SyncPages();
+  }
+}
+
+/**
+ * Write pages into disk file, one pwritev per run of consecutive pages
+ */
+void DiskManager::WritePages(const std::vector<PageWrite> &pages) {
+  std::vector<const char *> run;
+  size_t begin = 0;
+  for (size_t i = 0; i < pages.size(); i++) {
+    const char *page_data = pages[i].page_data_;
+    if (direct_io_ && !IsAligned(page_data)) {
+      // an unaligned page cannot be part of a vectored write under O_DIRECT, it goes alone
+      WriteAlignedPages(pages[begin].page_id_, run.data(), run.size());
+      WritePage(pages[i].page_id_, page_data);
+      run.clear();
+      begin = i + 1;
+      continue;
+    }
+    if (!run.empty() && (pages[i].page_id_ != pages[i - 1].page_id_ + 1 || run.size() == IOV_MAX)) {
+      WriteAlignedPages(pages[begin].page_id_, run.data(), run.size());
+      run.clear();
+      begin = i;
+    }
+    run.push_back(page_data);
+  }
+  WriteAlignedPages(begin < pages.size() ? pages[begin].page_id_ : INVALID_PAGE_ID, run.data(), run.size());
+}
+
+void DiskManager::WriteAlignedPages(page_id_t page_id, const char *const *page_data, size_t count) {
+  if (count == 0) {
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  // with checksums, the pages may change under the write, so copies are written that match their checksums
+  std::unique_ptr<char, decltype(&free)> snapshot(nullptr, &free);
+  std::vector<uint32_t> checksums;
+  if (crc_fd_ >= 0) {
+    snapshot.reset(static_cast<char *>(std::aligned_alloc(PAGE_SIZE, count * PAGE_SIZE)));
+    checksums.resize(count);
+  }
+  std::vector<struct iovec> iovs(count);
+  for (size_t i = 0; i < count; i++) {
+    if (snapshot != nullptr) {
+      char *copy = snapshot.get() + i * PAGE_SIZE;
+      memcpy(copy, page_data[i], PAGE_SIZE);
+      checksums[i] = PageChecksum(copy);
+      iovs[i].iov_base = copy;
+    } else {
+      iovs[i].iov_base = const_cast<char *>(page_data[i]);
+    }
+    iovs[i].iov_len = PAGE_SIZE;
+  }
+  MarkPagesUsed(page_id, count);
+  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
+  num_writes_ += count;
+  auto start = std::chrono::steady_clock::now();
+  size_t written = 0;
+  size_t first_iov = 0;
+  while (first_iov < count) {
+    ssize_t rc = pwritev(db_fd_, iovs.data() + first_iov, static_cast<int>(count - first_iov), offset + written);
+    // check for I/O error
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    written += rc;
+    // skip the pages written in full, and the written part of a partially written one
+    while (first_iov < count && static_cast<size_t>(rc) >= iovs[first_iov].iov_len) {
+      rc -= iovs[first_iov].iov_len;
+      first_iov++;
+    }
+    if (first_iov < count) {
+      iovs[first_iov].iov_base = static_cast<char *>(iovs[first_iov].iov_base) + rc;
+      iovs[first_iov].iov_len -= rc;
+    }
+  }
+  write_latency_.RecordSince(start);
+  StoreChecksums(page_id, checksums.data(), count);
+  // remember the new end of file
+  ExtendFileSize(offset + written);
+  // batch the syncs to disk if requested
+  if (sync_interval_ > 0 && (writes_since_sync_ += count) >= sync_interval_) {
+    SyncPages();
+  }
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * PAGE_SIZE;
+  if (direct_io_ && !IsAligned(page_data)) {
+    std::unique_ptr<char, decltype(&free)> bounce(static_cast<char *>(std::aligned_alloc(PAGE_SIZE, PAGE_SIZE)), &free);
+    ReadAlignedPage(page_id, bounce.get());
+    memcpy(page_data, bounce.get(), PAGE_SIZE);
+  } else {
+    ReadAlignedPage(page_id, page_data);
+  }
+  if (!VerifyChecksum(page_id, page_data)) {
+    throw Exception("page checksum mismatch");
+  }
+}
+
+void DiskManager::ReadAlignedPage(page_id_t page_id, char *page_data) {
+  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (offset > db_file_size_.load()) {
     LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  size_t read_count = 0;
+  while (read_count < PAGE_SIZE) {
+    ssize_t rc = pread(db_fd_, page_data + read_count, PAGE_SIZE - read_count, offset + read_count);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
       LOG_DEBUG("I/O error while reading");
-      return;
+      break;
+    }
+    read_count += rc;
+    // a short read hits the end of file; under O_DIRECT, reading on from an unaligned offset would fail anyway
+    if (rc == 0 || direct_io_) {
+      break;
+    }
+  }
+  read_latency_.RecordSince(start);
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+  }
+}
+
+/**
+ * Force the page writes to disk
+ */
+void DiskManager::SyncPages() {
+  writes_since_sync_ = 0;
+  if (fdatasync(db_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing");
+  }
+  if (crc_fd_ >= 0 && fdatasync(crc_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing checksum file");
+  }
+  std::scoped_lock lock(free_latch_);
+  if (free_fd_ >= 0 && fdatasync(free_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing free page file");
+  }
+}
+
+auto DiskManager::PageChecksum(const char *page_data) -> uint32_t {
+  // 0 marks a page without a checksum, so a page whose checksum happens to be 0 stores 1 instead
+  return std::max(Crc32cUtil::Crc32c(page_data, PAGE_SIZE), 1U);
+}
+
+/**
+ * Private helper function to store the checksums of pages just written
+ */
+void DiskManager::StoreChecksums(page_id_t page_id, const uint32_t *checksums, size_t count) {
+  if (crc_fd_ < 0 || count == 0) {
+    return;
+  }
+  if (pwrite(crc_fd_, checksums, count * sizeof(uint32_t), static_cast<off_t>(page_id) * sizeof(uint32_t)) !=
+      static_cast<ssize_t>(count * sizeof(uint32_t))) {
+    LOG_DEBUG("I/O error while writing checksums");
+  }
+}
+
+/**
+ * Private helper function to take pages about to be written off the free page bitmap
+ */
+void DiskManager::MarkPagesUsed(page_id_t page_id, size_t count) {
+  // nearly always, no page is free
+  if (num_free_pages_.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+  std::scoped_lock lock(free_latch_);
+  for (page_id_t last_page_id = page_id + static_cast<page_id_t>(count); page_id < last_page_id; page_id++) {
+    size_t byte = static_cast<size_t>(page_id) / 8;
+    uint8_t bit = 1U << (page_id % 8);
+    if (byte < free_bitmap_.size() && (free_bitmap_[byte] & bit) != 0) {
+      free_bitmap_[byte] &= ~bit;
+      num_free_pages_--;
+      StoreFreeBits(page_id);
+    }
+  }
+}
+
+void DiskManager::StoreFreeBits(page_id_t page_id) {
+  size_t byte = static_cast<size_t>(page_id) / 8;
+  if (free_fd_ >= 0 && pwrite(free_fd_, &free_bitmap_[byte], 1, static_cast<off_t>(byte)) != 1) {
+    LOG_DEBUG("I/O error while writing free page file");
+  }
+}
+
+void DiskManager::TrimFreeBits(page_id_t num_pages) {
+  size_t num_bytes = (static_cast<size_t>(num_pages) + 7) / 8;
+  if (free_bitmap_.size() * 8 <= static_cast<size_t>(num_pages)) {
+    return;
+  }
+  for (size_t page_id = num_pages; page_id < free_bitmap_.size() * 8; page_id++) {
+    if ((free_bitmap_[page_id / 8] & (1U << (page_id % 8))) != 0) {
+      num_free_pages_--;
+    }
+  }
+  free_bitmap_.resize(num_bytes);
+  if (num_pages % 8 != 0) {
+    free_bitmap_.back() &= (1U << (num_pages % 8)) - 1;
+  }
+  if (free_fd_ >= 0) {
+    if (ftruncate(free_fd_, static_cast<off_t>(num_bytes)) != 0) {
+      LOG_DEBUG("I/O error while truncating free page file");
     }
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    if (num_pages % 8 != 0) {
+      StoreFreeBits(num_pages - 1);
     }
   }
 }
 
+/**
+ * Private helper function to verify a page just read against its stored checksum
+ */
+auto DiskManager::VerifyChecksum(page_id_t page_id, const char *page_data) -> bool {
+  if (crc_fd_ < 0) {
+    return true;
+  }
+  uint32_t stored = 0;
+  // a page past the end of the checksum file has never been written with checksums
+  if (pread(crc_fd_, &stored, sizeof(stored), static_cast<off_t>(page_id) * sizeof(uint32_t)) !=
+          static_cast<ssize_t>(sizeof(stored)) ||
+      stored == 0) {
+    return true;
+  }
+  uint32_t checksum = PageChecksum(page_data);
+  if (checksum == stored) {
+    return true;
+  }
+  num_checksum_failures_++;
+  LOG_WARN("checksum mismatch on page %d: stored %08x, computed %08x", page_id, stored, checksum);
+  return checksum_mode_ != PageChecksumMode::STRICT;
+}
+
 /**
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
@@ -200,6 +572,19 @@ auto DiskManager::GetNumFlushes() const -> int { return num_flushes_; }
  */
 auto DiskManager::GetNumWrites() const -> int { return num_writes_; }
 
+/**
+ * Returns a snapshot of the I/O counters and latencies
+ */
+auto DiskManager::GetStats() const -> DiskManagerStats {
+  DiskManagerStats stats;
+  stats.num_writes_ = num_writes_;
+  stats.num_flushes_ = num_flushes_;
+  stats.num_checksum_failures_ = num_checksum_failures_;
+  stats.read_latency_ = read_latency_.GetSnapshot();
+  stats.write_latency_ = write_latency_.GetSnapshot();
+  return stats;
+}
+
 /**
  * Returns true if the log is currently being flushed
  */
@@ -214,4 +599,16 @@ auto DiskManager::GetFileSize(const std::string &file_name) -> int {
   return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
 }
 
+/**
+ * Private helper function to grow the cached db file size
+ */
+void DiskManager::ExtendFileSize(size_t file_size) {
+  size_t cur_file_size = db_file_size_.load();
+  while (cur_file_size < file_size) {
+    if (db_file_size_.compare_exchange_weak(cur_file_size, file_size)) {
+      break;
+    }
+  }
+}
+
 }  // namespace bustub
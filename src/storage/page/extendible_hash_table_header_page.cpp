@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extendible_hash_table_header_page.cpp
+//
+// Identification: src/storage/page/extendible_hash_table_header_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/extendible_hash_table_header_page.h"
+
+#include <unordered_map>
+
+#include "common/logger.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+auto ExtendibleHashTableHeaderPage::GetPageId() const -> page_id_t { return page_id_; }
+
+void ExtendibleHashTableHeaderPage::SetPageId(page_id_t page_id) { page_id_ = page_id; }
+
+auto ExtendibleHashTableHeaderPage::GetLSN() const -> lsn_t { return lsn_; }
+
+void ExtendibleHashTableHeaderPage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+auto ExtendibleHashTableHeaderPage::GetDirectoryPageId(uint32_t header_idx) const -> page_id_t {
+  return directory_page_ids_[header_idx];
+}
+
+void ExtendibleHashTableHeaderPage::SetDirectoryPageId(uint32_t header_idx, page_id_t directory_page_id) {
+  directory_page_ids_[header_idx] = directory_page_id;
+}
+
+auto ExtendibleHashTableHeaderPage::GetGlobalDepthMask() const -> uint32_t { return (0x1 << global_depth_) - 1; }
+
+auto ExtendibleHashTableHeaderPage::GetGlobalDepth() const -> uint32_t { return global_depth_; }
+
+void ExtendibleHashTableHeaderPage::IncrGlobalDepth() {
+  BUSTUB_ASSERT(global_depth_ < HEADER_MAX_DEPTH, "The header page is full.");
+  uint32_t size = Size();
+  for (uint32_t i = 0; i < size; i++) {
+    directory_page_ids_[i + size] = directory_page_ids_[i];
+    local_depths_[i + size] = local_depths_[i];
+  }
+  global_depth_++;
+}
+
+auto ExtendibleHashTableHeaderPage::Size() const -> uint32_t { return 0x1 << global_depth_; }
+
+auto ExtendibleHashTableHeaderPage::GetLocalDepth(uint32_t header_idx) const -> uint32_t {
+  return local_depths_[header_idx];
+}
+
+void ExtendibleHashTableHeaderPage::SetLocalDepth(uint32_t header_idx, uint8_t local_depth) {
+  local_depths_[header_idx] = local_depth;
+}
+
+void ExtendibleHashTableHeaderPage::VerifyIntegrity() const {
+  std::unordered_map<page_id_t, uint32_t> page_id_to_count;
+  std::unordered_map<page_id_t, uint32_t> page_id_to_ld;
+  for (uint32_t curr_idx = 0; curr_idx < Size(); curr_idx++) {
+    page_id_t curr_page_id = directory_page_ids_[curr_idx];
+    uint32_t curr_ld = local_depths_[curr_idx];
+    BUSTUB_ASSERT(curr_ld <= global_depth_, "The local depth of a directory page exceeds the global depth.");
+    ++page_id_to_count[curr_page_id];
+    auto it = page_id_to_ld.find(curr_page_id);
+    if (it != page_id_to_ld.end() && it->second != curr_ld) {
+      LOG_WARN("Verify Integrity: curr_local_depth: %u, old_local_depth %u, for directory page_id: %d", curr_ld,
+               it->second, curr_page_id);
+      BUSTUB_ASSERT(false, "The slots of a directory page disagree on its local depth.");
+    }
+    page_id_to_ld[curr_page_id] = curr_ld;
+  }
+  for (const auto &[page_id, count] : page_id_to_count) {
+    uint32_t required_count = 0x1 << (global_depth_ - page_id_to_ld[page_id]);
+    if (count != required_count) {
+      LOG_WARN("Verify Integrity: curr_count: %u, required_count %u, for directory page_id: %d", count,
+               required_count, page_id);
+      BUSTUB_ASSERT(false, "A directory page has the wrong number of header slots.");
+    }
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,56 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_page.cpp
+//
+// Identification: src/storage/page/free_space_map_page.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/free_space_map_page.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+void FreeSpaceMapPage::Init(page_id_t page_id) {
+  memcpy(GetData(), &page_id, sizeof(page_id));
+  SetNextPageId(INVALID_PAGE_ID);
+  SetEntryCount(0);
+}
+
+auto FreeSpaceMapPage::AppendEntry(page_id_t table_page_id, uint32_t free_space) -> uint32_t {
+  uint32_t slot_num = GetEntryCount();
+  if (slot_num >= CAPACITY) {
+    return CAPACITY;
+  }
+  memcpy(GetData() + OFFSET_ENTRIES + SIZE_ENTRY * slot_num, &table_page_id, sizeof(page_id_t));
+  SetFreeSpace(slot_num, free_space);
+  SetEntryCount(slot_num + 1);
+  return slot_num;
+}
+
+auto FreeSpaceMapPage::FindEntry(uint32_t required, uint32_t *slot_num) -> bool {
+  uint32_t entry_count = GetEntryCount();
+  for (uint32_t i = 0; i < entry_count; i++) {
+    if (GetFreeSpace(i) >= required) {
+      *slot_num = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+auto FreeSpaceMapPage::GetMaxFreeSpace() -> uint32_t {
+  uint32_t max_free_space = 0;
+  uint32_t entry_count = GetEntryCount();
+  for (uint32_t i = 0; i < entry_count; i++) {
+    max_free_space = std::max(max_free_space, GetFreeSpace(i));
+  }
+  return max_free_space;
+}
+
+}  // namespace bustub
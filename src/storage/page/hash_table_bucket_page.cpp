@@ -11,6 +11,14 @@
 //===----------------------------------------------------------------------===//
 
 #include "storage/page/hash_table_bucket_page.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
 #include "common/logger.h"
 #include "common/util/hash_util.h"
 #include "storage/index/generic_key.h"
@@ -19,53 +27,115 @@
 
 namespace bustub {
 
+namespace {
+
+/** Number of slots whose fingerprints a probe compares at once; a multiple of 8, so that groups start on a byte. */
+#if defined(__AVX2__)
+constexpr uint32_t PROBE_GROUP_SIZE = 32;
+#else
+constexpr uint32_t PROBE_GROUP_SIZE = 16;
+#endif
+
+}  // namespace
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) -> bool {
-  for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; ++i) {
-    if (!IsReadable(i)) {
-      if (!IsOccupied(i)) {
-        break;
-      }
-      continue;
+auto HASH_TABLE_BUCKET_TYPE::GroupBits(const char *bitmap, uint32_t start) const -> uint32_t {
+  uint32_t bits = 0;
+  // The bits past the last slot are always 0.
+  memcpy(&bits, bitmap + start / 8,
+         std::min(PROBE_GROUP_SIZE / 8, static_cast<uint32_t>(GetNumofChars()) - start / 8));
+  return bits;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BUCKET_TYPE::MatchFingerprint(uint32_t start, uint8_t fingerprint) const -> uint32_t {
+  if (start + PROBE_GROUP_SIZE <= BUCKET_ARRAY_SIZE) {
+#if defined(__AVX2__)
+    __m256i group = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(fingerprints_ + start));
+    __m256i match = _mm256_cmpeq_epi8(group, _mm256_set1_epi8(static_cast<char>(fingerprint)));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(match));
+#elif defined(__SSE2__)
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(fingerprints_ + start));
+    __m128i match = _mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(fingerprint)));
+    return static_cast<uint32_t>(_mm_movemask_epi8(match));
+#endif
+  }
+  // The last, partial group, or no SIMD instructions.
+  uint32_t matches = 0;
+  for (uint32_t i = start; i < std::min(start + PROBE_GROUP_SIZE, static_cast<uint32_t>(BUCKET_ARRAY_SIZE)); i++) {
+    matches |= static_cast<uint32_t>(fingerprints_[i] == fingerprint) << (i - start);
+  }
+  return matches;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, KeyComparator cmp, uint8_t fingerprint,
+                                      std::vector<ValueType> *result) const -> bool {
+  for (uint32_t start = 0; start < BUCKET_ARRAY_SIZE; start += PROBE_GROUP_SIZE) {
+    // Inserts take the first free slot, so the occupied slots are a prefix of the bucket.
+    if (GroupBits(occupied_, start) == 0) {
+      break;
     }
-    if (cmp(key, KeyAt(i)) == 0) {
-      result->push_back(ValueAt(i));
+    uint32_t matches = MatchFingerprint(start, fingerprint) & GroupBits(readable_, start);
+    for (; matches != 0; matches &= matches - 1) {
+      uint32_t i = start + __builtin_ctz(matches);
+      if (cmp(key, KeyAt(i)) == 0) {
+        result->push_back(ValueAt(i));
+      }
     }
   }
   return !result->empty();
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_BUCKET_TYPE::Insert(KeyType key, ValueType value, KeyComparator cmp) -> bool {
-  if (IsFull()) {
-    return false;
+auto HASH_TABLE_BUCKET_TYPE::Insert(KeyType key, ValueType value, KeyComparator cmp, uint8_t fingerprint) -> bool {
+  static_assert(sizeof(HASH_TABLE_BUCKET_TYPE) + BUCKET_ARRAY_SIZE * sizeof(MappingType) <= PAGE_SIZE,
+                "a bucket should fit in a page");
+  // 找到第一个非空的array存放新的键值对，同时检查是否已有相同的键值对。
+  uint32_t free_slot = BUCKET_ARRAY_SIZE;
+  for (uint32_t start = 0; start < BUCKET_ARRAY_SIZE; start += PROBE_GROUP_SIZE) {
+    uint32_t readable = GroupBits(readable_, start);
+    if (free_slot == BUCKET_ARRAY_SIZE) {
+      uint32_t num_slots = std::min(PROBE_GROUP_SIZE, static_cast<uint32_t>(BUCKET_ARRAY_SIZE) - start);
+      uint32_t free = ~readable & (num_slots == 32 ? ~0U : (1U << num_slots) - 1);
+      if (free != 0) {
+        free_slot = start + __builtin_ctz(free);
+      }
+    }
+    if (GroupBits(occupied_, start) == 0) {
+      break;
+    }
+    uint32_t matches = MatchFingerprint(start, fingerprint) & readable;
+    for (; matches != 0; matches &= matches - 1) {
+      uint32_t i = start + __builtin_ctz(matches);
+      if (cmp(key, KeyAt(i)) == 0 && ValueAt(i) == value) {
+        return false;
+      }
+    }
   }
-  std::vector<ValueType> exit_values;
-  GetValue(key, cmp, &exit_values);
-  if (std::find(exit_values.begin(), exit_values.end(), value) != exit_values.cend()) {
+  if (free_slot == BUCKET_ARRAY_SIZE) {
     return false;
   }
-  // 找到第一个非空的array存放新的键值对。
-  for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
-    if (!IsReadable(i)) {
-      array_[i] = MappingType(key, value);
-      SetReadable(i);
-      SetOccupied(i);
-      return true;
-    }
-  }
-  return false;
+  array_[free_slot] = MappingType(key, value);
+  fingerprints_[free_slot] = fingerprint;
+  SetReadable(free_slot);
+  SetOccupied(free_slot);
+  return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_BUCKET_TYPE::Remove(KeyType key, ValueType value, KeyComparator cmp) -> bool {
-  for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; ++i) {
-    if (!IsReadable(i)) {
-      continue;
+auto HASH_TABLE_BUCKET_TYPE::Remove(KeyType key, ValueType value, KeyComparator cmp, uint8_t fingerprint) -> bool {
+  for (uint32_t start = 0; start < BUCKET_ARRAY_SIZE; start += PROBE_GROUP_SIZE) {
+    if (GroupBits(occupied_, start) == 0) {
+      break;
     }
-    if (cmp(key, KeyAt(i)) == 0 && ValueAt(i) == value) {
-      RemoveAt(i);
-      return true;
+    uint32_t matches = MatchFingerprint(start, fingerprint) & GroupBits(readable_, start);
+    for (; matches != 0; matches &= matches - 1) {
+      uint32_t i = start + __builtin_ctz(matches);
+      if (cmp(key, KeyAt(i)) == 0 && ValueAt(i) == value) {
+        RemoveAt(i);
+        return true;
+      }
     }
   }
   return false;
@@ -115,31 +185,42 @@ void HASH_TABLE_BUCKET_TYPE::SetReadable(uint32_t bucket_idx) {
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_BUCKET_TYPE::IsFull() -> bool {
+auto HASH_TABLE_BUCKET_TYPE::IsFull() const -> bool {
   return NumReadable() == BUCKET_ARRAY_SIZE;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_BUCKET_TYPE::NumReadable() -> uint32_t {
+auto HASH_TABLE_BUCKET_TYPE::NumReadable() const -> uint32_t {
   uint32_t num_readable = 0;
-  for (auto i = 0; i < GetNumofChars(); i++) {
-    uint8_t readable = readable_[i];
-    // 位运算——二进制中1的个数
-    while (readable != 0) {
-      readable &= (readable - 1);
-      num_readable++;
-    }
+  // 位运算——二进制中1的个数，一次数8个字节
+  int i = 0;
+  for (; i + 8 <= GetNumofChars(); i += 8) {
+    uint64_t readable;
+    memcpy(&readable, readable_ + i, sizeof(readable));
+    num_readable += __builtin_popcountll(readable);
+  }
+  for (; i < GetNumofChars(); i++) {
+    num_readable += __builtin_popcount(static_cast<uint8_t>(readable_[i]));
   }
   return num_readable;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_BUCKET_TYPE::IsEmpty() -> bool {
+auto HASH_TABLE_BUCKET_TYPE::IsEmpty() const -> bool {
   return NumReadable() == 0;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BUCKET_TYPE::PrintBucket() {
+void HASH_TABLE_BUCKET_TYPE::Prefetch() const {
+  // Everything before array_.
+  auto data = reinterpret_cast<const char *>(this);
+  for (size_t offset = 0; offset < sizeof(HASH_TABLE_BUCKET_TYPE); offset += CACHE_LINE_SIZE) {
+    __builtin_prefetch(data + offset);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_BUCKET_TYPE::PrintBucket() const {
   uint32_t size = 0;
   uint32_t taken = 0;
   uint32_t free = 0;
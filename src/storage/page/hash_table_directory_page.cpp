@@ -25,9 +25,9 @@ auto HashTableDirectoryPage::GetLSN() const -> lsn_t { return lsn_; }
 
 void HashTableDirectoryPage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
 
-auto HashTableDirectoryPage::GetGlobalDepth() -> uint32_t { return global_depth_; }
+auto HashTableDirectoryPage::GetGlobalDepth() const -> uint32_t { return global_depth_; }
 
-auto HashTableDirectoryPage::GetGlobalDepthMask() -> uint32_t { return (0x1 << global_depth_) - 1; }
+auto HashTableDirectoryPage::GetGlobalDepthMask() const -> uint32_t { return (0x1 << global_depth_) - 1; }
 // 它的作用是返回一个掩码，掩码决定了一个Key/Value对会被放入哪个bucket里面。
 // 如key的hash值是10，depth为2，则放入1010 & 0011 = 2号桶里面。
 
@@ -35,15 +35,17 @@ void HashTableDirectoryPage::IncrGlobalDepth() { global_depth_++; }
 
 void HashTableDirectoryPage::DecrGlobalDepth() { global_depth_--; }
 
-auto HashTableDirectoryPage::GetBucketPageId(uint32_t bucket_idx) -> page_id_t { return bucket_page_ids_[bucket_idx]; }
+auto HashTableDirectoryPage::GetBucketPageId(uint32_t bucket_idx) const -> page_id_t {
+  return bucket_page_ids_[bucket_idx];
+}
 
 void HashTableDirectoryPage::SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id) {
   bucket_page_ids_[bucket_idx] = bucket_page_id;
 }
 
-auto HashTableDirectoryPage::Size() -> uint32_t { return (0x1 << global_depth_); }
+auto HashTableDirectoryPage::Size() const -> uint32_t { return (0x1 << global_depth_); }
 
-auto HashTableDirectoryPage::CanShrink() -> bool {
+auto HashTableDirectoryPage::CanShrink() const -> bool {
   for (uint32_t i = 0; i < Size(); i++) {
     if (local_depths_[i] == global_depth_) {
       return false;
@@ -52,7 +54,13 @@ auto HashTableDirectoryPage::CanShrink() -> bool {
   return true;
 }
 
-auto HashTableDirectoryPage::GetLocalDepth(uint32_t bucket_idx) -> uint32_t { return local_depths_[bucket_idx]; }
+void HashTableDirectoryPage::Shrink() {
+  while (global_depth_ > 0 && CanShrink()) {
+    global_depth_--;
+  }
+}
+
+auto HashTableDirectoryPage::GetLocalDepth(uint32_t bucket_idx) const -> uint32_t { return local_depths_[bucket_idx]; }
 
 void HashTableDirectoryPage::SetLocalDepth(uint32_t bucket_idx, uint8_t local_depth) {
   local_depths_[bucket_idx] = local_depth;
@@ -62,13 +70,15 @@ void HashTableDirectoryPage::IncrLocalDepth(uint32_t bucket_idx) { local_depths_
 
 void HashTableDirectoryPage::DecrLocalDepth(uint32_t bucket_idx) { local_depths_[bucket_idx]--; }
 
-uint32_t HashTableDirectoryPage::GetLocalHighBit(uint32_t bucket_idx) { return (0x1 << local_depths_[bucket_idx]); }
+uint32_t HashTableDirectoryPage::GetLocalHighBit(uint32_t bucket_idx) const {
+  return (0x1 << local_depths_[bucket_idx]);
+}
 
-auto HashTableDirectoryPage::GetSplitImageIndex(uint32_t bucket_idx) -> uint32_t {
-  uint32_t high_bit = (0x1 << local_depths_[bucket_idx - 1]);
+auto HashTableDirectoryPage::GetSplitImageIndex(uint32_t bucket_idx) const -> uint32_t {
+  uint32_t high_bit = (0x1 << (local_depths_[bucket_idx] - 1));
   return bucket_idx ^ high_bit;
 }
-auto HashTableDirectoryPage::GetLocalDepthMask(uint32_t bucket_idx) -> uint32_t {
+auto HashTableDirectoryPage::GetLocalDepthMask(uint32_t bucket_idx) const -> uint32_t {
   return ((0x1 << local_depths_[bucket_idx]) - 1);
 }
 /**
@@ -81,7 +91,7 @@ auto HashTableDirectoryPage::GetLocalDepthMask(uint32_t bucket_idx) -> uint32_t
  * (2) Each bucket has precisely 2^(GD - LD) pointers pointing to it.
  * (3) The LD is the same at each index with the same bucket_page_id
  */
-void HashTableDirectoryPage::VerifyIntegrity() {
+void HashTableDirectoryPage::VerifyIntegrity() const {
   //  build maps of {bucket_page_id : pointer_count} and {bucket_page_id : local_depth}
   std::unordered_map<page_id_t, uint32_t> page_id_to_count = std::unordered_map<page_id_t, uint32_t>();
   std::unordered_map<page_id_t, uint32_t> page_id_to_ld = std::unordered_map<page_id_t, uint32_t>();
@@ -123,7 +133,7 @@ void HashTableDirectoryPage::VerifyIntegrity() {
   }
 }
 
-void HashTableDirectoryPage::PrintDirectory() {
+void HashTableDirectoryPage::PrintDirectory() const {
   LOG_DEBUG("======== DIRECTORY (global_depth_: %u) ========", global_depth_);
   LOG_DEBUG("| bucket_idx | page_id | local_depth |");
   for (uint32_t idx = 0; idx < static_cast<uint32_t>(0x1 << global_depth_); idx++) {
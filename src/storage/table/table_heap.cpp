@@ -10,7 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
+#include <memory>
 
 #include "common/logger.h"
 #include "storage/table/table_heap.h"
@@ -32,59 +34,84 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_m
   BUSTUB_ASSERT(first_page != nullptr, "Couldn't create a page for the table heap.");
   first_page->WLatch();
   first_page->Init(first_page_id_, PAGE_SIZE, INVALID_LSN, log_manager_, txn);
+  // Initialize the free space map, which so far only tracks the first page.
+  page_id_t fsm_page_id;
+  auto fsm_page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->NewPage(&fsm_page_id));
+  BUSTUB_ASSERT(fsm_page != nullptr, "Couldn't create a free space map page for the table heap.");
+  fsm_page->Init(fsm_page_id);
+  fsm_page->AppendEntry(first_page_id_, first_page->GetFreeSpaceRemaining());
+  buffer_pool_manager_->UnpinPage(fsm_page_id, true);
+  first_page->SetFreeSpaceMapPageId(fsm_page_id);
   first_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(first_page_id_, true);
 }
 
-auto TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> bool {
-  if (tuple.size_ + 32 > PAGE_SIZE) {  // larger than one page size
+auto TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, BufferAccessStrategy *strategy) -> bool {
+  if (tuple.size_ > TablePage::GetMaxTupleSize()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
 
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-  if (cur_page == nullptr) {
+  uint32_t required = TablePage::GetRequiredFreeSpace(tuple.size_);
+  std::unique_lock<std::mutex> fsm_lock(fsm_latch_);
+  LoadFreeSpaceMap();
+  // Try the pages that the FSM thinks have enough space. The FSM is only a hint, so an insert can still fail; in that
+  // case the FSM is corrected and the next candidate is tried.
+  for (page_id_t page_id = FindPageWithFreeSpace(required); page_id != INVALID_PAGE_ID;
+       page_id = FindPageWithFreeSpace(required)) {
+    fsm_lock.unlock();
+    auto cur_page = FetchTablePage(page_id, strategy);
+    if (cur_page == nullptr) {
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+    cur_page->WLatch();
+    bool is_inserted = cur_page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_);
+    uint32_t free_space = cur_page->GetFreeSpaceRemaining();
+    cur_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, is_inserted);
+    fsm_lock.lock();
+    UpdateFreeSpace(page_id, free_space);
+    if (is_inserted) {
+      fsm_lock.unlock();
+      // Update the transaction's write set.
+      txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
+      return true;
+    }
+  }
+
+  // No page has enough space, so we append a new page to the table. Holding fsm_latch_ serializes the appends.
+  auto last_page = FetchTablePage(last_page_id_, strategy);
+  if (last_page == nullptr) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
-
-  cur_page->WLatch();
-  // Insert into the first page with enough space. If no such page exists, create a new page and insert into that.
-  // INVARIANT: cur_page is WLatched if you leave the loop normally.
-  while (!cur_page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_)) {
-    auto next_page_id = cur_page->GetNextPageId();
-    // If the next page is a valid page,
-    if (next_page_id != INVALID_PAGE_ID) {
-      // Unlatch and unpin the current page.
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
-      // And repeat the process with the next page.
-      cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
-      cur_page->WLatch();
-    } else {
-      // Otherwise we have run out of valid pages. We need to create a new page.
-      auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&next_page_id));
-      // If we could not create a new page,
-      if (new_page == nullptr) {
-        // Then life sucks and we abort the transaction.
-        cur_page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
-        txn->SetState(TransactionState::ABORTED);
-        return false;
-      }
-      // Otherwise we were able to create a new page. We initialize it now.
-      new_page->WLatch();
-      cur_page->SetNextPageId(next_page_id);
-      new_page->Init(next_page_id, PAGE_SIZE, cur_page->GetTablePageId(), log_manager_, txn);
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
-      cur_page = new_page;
-    }
+  page_id_t new_page_id;
+  auto new_page = NewTablePage(&new_page_id, strategy);
+  // If we could not create a new page,
+  if (new_page == nullptr) {
+    // Then life sucks and we abort the transaction.
+    buffer_pool_manager_->UnpinPage(last_page_id_, false);
+    txn->SetState(TransactionState::ABORTED);
+    return false;
   }
-  // This line has caused most of us to double-take and "whoa double unlatch".
-  // We are not, in fact, double unlatching. See the invariant above.
-  cur_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
+  // Otherwise we were able to create a new page. We initialize it now.
+  new_page->WLatch();
+  last_page->WLatch();
+  last_page->SetNextPageId(new_page_id);
+  new_page->Init(new_page_id, PAGE_SIZE, last_page_id_, log_manager_, txn);
+  last_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(last_page_id_, true);
+  last_page_id_ = new_page_id;
+  // The tuple always fits into an empty page, see the size check above.
+  bool is_inserted = new_page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_);
+  BUSTUB_ASSERT(is_inserted, "Inserting into an empty page should always work.");
+  uint32_t free_space = new_page->GetFreeSpaceRemaining();
+  new_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(new_page_id, true);
+  // If the new page cannot be tracked, it is merely invisible to the FSM until the FSM is loaded again.
+  TrackPage(new_page_id, free_space);
+  fsm_lock.unlock();
   // Update the transaction's write set.
   txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
   return true;
@@ -93,17 +120,15 @@ auto TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> b
 auto TableHeap::MarkDelete(const RID &rid, Transaction *txn) -> bool {
   // TODO(Amadou): remove empty page
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto page_guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
   // If the page could not be found, then abort the transaction.
-  if (page == nullptr) {
+  if (!page_guard.IsValid()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   // Otherwise, mark the tuple as deleted.
-  page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  page_guard.AsMut<TablePage>()->MarkDelete(rid, txn, lock_manager_, log_manager_);
+  page_guard.Drop();
   // Update the transaction's write set.
   txn->GetWriteSet()->emplace_back(rid, WType::DELETE, Tuple{}, this);
   return true;
@@ -111,18 +136,23 @@ auto TableHeap::MarkDelete(const RID &rid, Transaction *txn) -> bool {
 
 auto TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn) -> bool {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto page_guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
   // If the page could not be found, then abort the transaction.
-  if (page == nullptr) {
+  if (!page_guard.IsValid()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   // Update the tuple; but first save the old value for rollbacks.
   Tuple old_tuple;
-  page->WLatch();
+  auto page = page_guard.AsMut<TablePage>();
   bool is_updated = page->UpdateTuple(tuple, &old_tuple, rid, txn, lock_manager_, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), is_updated);
+  uint32_t free_space = page->GetFreeSpaceRemaining();
+  page_guard.Drop();
+  if (is_updated) {
+    std::scoped_lock fsm_lock(fsm_latch_);
+    LoadFreeSpaceMap();
+    UpdateFreeSpace(rid.GetPageId(), free_space);
+  }
   // Update the transaction's write set.
   if (is_updated && txn->GetState() != TransactionState::ABORTED) {
     txn->GetWriteSet()->emplace_back(rid, WType::UPDATE, old_tuple, this);
@@ -132,63 +162,197 @@ auto TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn
 
 void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
+  auto page_guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  BUSTUB_ASSERT(page_guard.IsValid(), "Couldn't find a page containing that RID.");
   // Delete the tuple from the page.
-  page->WLatch();
+  auto page = page_guard.AsMut<TablePage>();
   page->ApplyDelete(rid, txn, log_manager_);
   lock_manager_->Unlock(txn, rid);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  uint32_t free_space = page->GetFreeSpaceRemaining();
+  page_guard.Drop();
+  // The space of the deleted tuple can now be reused by inserts.
+  std::scoped_lock fsm_lock(fsm_latch_);
+  LoadFreeSpaceMap();
+  UpdateFreeSpace(rid.GetPageId(), free_space);
 }
 
 void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
   // Find the page which contains the tuple.
-  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
+  auto page_guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  BUSTUB_ASSERT(page_guard.IsValid(), "Couldn't find a page containing that RID.");
   // Rollback the delete.
-  page->WLatch();
-  page->RollbackDelete(rid, txn, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  page_guard.AsMut<TablePage>()->RollbackDelete(rid, txn, log_manager_);
 }
 
 auto TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) -> bool {
   // Find the page which contains the tuple.
-  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto page_guard = buffer_pool_manager_->FetchPageRead(rid.GetPageId());
   // If the page could not be found, then abort the transaction.
-  if (page == nullptr) {
+  if (!page_guard.IsValid()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   // Read the tuple from the page.
-  page->RLatch();
-  bool res = page->GetTuple(rid, tuple, txn, lock_manager_);
-  page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
-  return res;
+  return page_guard.As<TablePage>()->GetTuple(rid, tuple, txn, lock_manager_);
 }
 
 auto TableHeap::Begin(Transaction *txn) -> TableIterator {
   // Start an iterator from the first page.
   // TODO(Wuwen): Hacky fix for now. Removing empty pages is a better way to handle this.
+  // A full scan reads every page once, so it recycles a ring of frames rather than evicting the rest of the pool.
+  auto strategy = std::make_shared<BufferAccessStrategy>(AccessStrategyType::SEQUENTIAL_SCAN);
   RID rid;
   auto page_id = first_page_id_;
   while (page_id != INVALID_PAGE_ID) {
-    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    auto page = FetchTablePage(page_id, strategy.get());
     page->RLatch();
     // If this fails because there is no tuple, then RID will be the default-constructed value, which means EOF.
     auto found_tuple = page->GetFirstTupleRid(&rid);
+    page_id_t next_page_id = page->GetNextPageId();
     page->RUnlatch();
     buffer_pool_manager_->UnpinPage(page_id, false);
     if (found_tuple) {
       break;
     }
-    page_id = page->GetNextPageId();
+    page_id = next_page_id;
   }
-  return {this, rid, txn};
+  return {this, rid, txn, strategy};
 }
 
 auto TableHeap::End() -> TableIterator { return {this, RID(INVALID_PAGE_ID, 0), nullptr}; }
 
+void TableHeap::LoadFreeSpaceMap() {
+  if (fsm_loaded_) {
+    return;
+  }
+  auto first_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+  BUSTUB_ASSERT(first_page != nullptr, "Couldn't fetch the first page of the table heap.");
+  first_page->WLatch();
+  page_id_t fsm_page_id = first_page->GetFreeSpaceMapPageId();
+  bool is_created = fsm_page_id == INVALID_PAGE_ID;
+  if (is_created) {
+    // The FSM was never persisted. Start an empty one, the page list walk below fills it in.
+    auto fsm_page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->NewPage(&fsm_page_id));
+    BUSTUB_ASSERT(fsm_page != nullptr, "Couldn't create a free space map page for the table heap.");
+    fsm_page->Init(fsm_page_id);
+    buffer_pool_manager_->UnpinPage(fsm_page_id, true);
+    first_page->SetFreeSpaceMapPageId(fsm_page_id);
+  }
+  first_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(first_page_id_, is_created);
+
+  // Read the persisted FSM pages.
+  while (fsm_page_id != INVALID_PAGE_ID) {
+    auto fsm_page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(fsm_page_id));
+    BUSTUB_ASSERT(fsm_page != nullptr, "Couldn't fetch a free space map page of the table heap.");
+    // A page that never made it to disk is reset; the pages it tracked are recovered by the page list walk below.
+    bool is_reset = fsm_page->GetFreeSpaceMapPageId() != fsm_page_id;
+    if (is_reset) {
+      fsm_page->Init(fsm_page_id);
+    }
+    auto first_entry = static_cast<uint32_t>(fsm_page_ids_.size() * FreeSpaceMapPage::CAPACITY);
+    for (uint32_t slot_num = 0; slot_num < fsm_page->GetEntryCount(); slot_num++) {
+      fsm_entries_[fsm_page->GetTablePageId(slot_num)] = first_entry + slot_num;
+      last_page_id_ = fsm_page->GetTablePageId(slot_num);
+    }
+    fsm_page_ids_.push_back(fsm_page_id);
+    fsm_max_free_space_.push_back(fsm_page->GetMaxFreeSpace());
+    page_id_t next_page_id = fsm_page->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(fsm_page_id, is_reset);
+    fsm_page_id = next_page_id;
+  }
+
+  // Track the pages that were linked into the table after the FSM was last persisted.
+  page_id_t page_id = last_page_id_ == INVALID_PAGE_ID ? first_page_id_ : last_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch a page of the table heap.");
+    page->RLatch();
+    uint32_t free_space = page->GetFreeSpaceRemaining();
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    if (fsm_entries_.count(page_id) == 0) {
+      TrackPage(page_id, free_space);
+    }
+    last_page_id_ = page_id;
+    page_id = next_page_id;
+  }
+  fsm_loaded_ = true;
+}
+
+auto TableHeap::FindPageWithFreeSpace(uint32_t required) -> page_id_t {
+  for (size_t i = 0; i < fsm_page_ids_.size(); i++) {
+    size_t index = (fsm_search_hint_ + i) % fsm_page_ids_.size();
+    if (fsm_max_free_space_[index] < required) {
+      continue;
+    }
+    auto fsm_page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(fsm_page_ids_[index]));
+    if (fsm_page == nullptr) {
+      return INVALID_PAGE_ID;
+    }
+    uint32_t slot_num;
+    page_id_t page_id = INVALID_PAGE_ID;
+    if (fsm_page->FindEntry(required, &slot_num)) {
+      page_id = fsm_page->GetTablePageId(slot_num);
+    } else {
+      // Tighten the upper bound so that this FSM page is skipped until some of its pages gain space.
+      fsm_max_free_space_[index] = fsm_page->GetMaxFreeSpace();
+    }
+    buffer_pool_manager_->UnpinPage(fsm_page_ids_[index], false);
+    if (page_id != INVALID_PAGE_ID) {
+      fsm_search_hint_ = index;
+      return page_id;
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+void TableHeap::UpdateFreeSpace(page_id_t page_id, uint32_t free_space) {
+  auto it = fsm_entries_.find(page_id);
+  if (it == fsm_entries_.end()) {
+    return;
+  }
+  size_t index = it->second / FreeSpaceMapPage::CAPACITY;
+  uint32_t slot_num = it->second % FreeSpaceMapPage::CAPACITY;
+  auto fsm_page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(fsm_page_ids_[index]));
+  if (fsm_page == nullptr) {
+    return;
+  }
+  bool is_dirty = fsm_page->GetFreeSpace(slot_num) != free_space;
+  fsm_page->SetFreeSpace(slot_num, free_space);
+  buffer_pool_manager_->UnpinPage(fsm_page_ids_[index], is_dirty);
+  fsm_max_free_space_[index] = std::max(fsm_max_free_space_[index], free_space);
+}
+
+auto TableHeap::TrackPage(page_id_t page_id, uint32_t free_space) -> bool {
+  page_id_t fsm_page_id = fsm_page_ids_.back();
+  auto fsm_page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(fsm_page_id));
+  if (fsm_page == nullptr) {
+    return false;
+  }
+  uint32_t slot_num = fsm_page->AppendEntry(page_id, free_space);
+  if (slot_num == FreeSpaceMapPage::CAPACITY) {
+    // The last FSM page is full, so we link a new one after it.
+    page_id_t new_fsm_page_id;
+    auto new_fsm_page = reinterpret_cast<FreeSpaceMapPage *>(buffer_pool_manager_->NewPage(&new_fsm_page_id));
+    if (new_fsm_page == nullptr) {
+      buffer_pool_manager_->UnpinPage(fsm_page_id, false);
+      return false;
+    }
+    new_fsm_page->Init(new_fsm_page_id);
+    fsm_page->SetNextPageId(new_fsm_page_id);
+    buffer_pool_manager_->UnpinPage(fsm_page_id, true);
+    fsm_page_ids_.push_back(new_fsm_page_id);
+    fsm_max_free_space_.push_back(0);
+    fsm_page = new_fsm_page;
+    fsm_page_id = new_fsm_page_id;
+    slot_num = fsm_page->AppendEntry(page_id, free_space);
+  }
+  buffer_pool_manager_->UnpinPage(fsm_page_id, true);
+  fsm_entries_[page_id] = static_cast<uint32_t>((fsm_page_ids_.size() - 1) * FreeSpaceMapPage::CAPACITY) + slot_num;
+  fsm_max_free_space_.back() = std::max(fsm_max_free_space_.back(), free_space);
+  return true;
+}
+
 }  // namespace bustub
@@ -10,14 +10,17 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
+#include <vector>
 
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                             std::shared_ptr<BufferAccessStrategy> strategy)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn), strategy_(std::move(strategy)) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
     table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
   }
@@ -35,7 +38,7 @@ auto TableIterator::operator->() -> Tuple * {
 
 auto TableIterator::operator++() -> TableIterator & {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
+  auto cur_page = table_heap_->FetchTablePage(tuple_->rid_.GetPageId(), strategy_.get());
   cur_page->RLatch();
   assert(cur_page != nullptr);  // all pages are pinned
 
@@ -43,11 +46,12 @@ auto TableIterator::operator++() -> TableIterator & {
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  &next_tuple_rid)) {  // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
+      auto next_page = table_heap_->FetchTablePage(cur_page->GetNextPageId(), strategy_.get());
       cur_page->RUnlatch();
       buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
       cur_page = next_page;
       cur_page->RLatch();
+      PrefetchAhead(cur_page);
       if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
@@ -64,6 +68,47 @@ auto TableIterator::operator++() -> TableIterator & {
   return *this;
 }
 
+void TableIterator::PrefetchAhead(TablePage *cur_page) {
+  // A prefetched page stays in the ring of the scan's strategy until the scan gets to it, so read ahead by less than
+  // the ring holds.
+  size_t distance = TABLE_SCAN_PREFETCH_DISTANCE;
+  if (strategy_ != nullptr && strategy_->GetRingSize() > 0) {
+    distance = std::min(distance, strategy_->GetMinRingSize() / 2);
+  }
+  if (num_prefetched_ahead_ > 0) {
+    num_prefetched_ahead_--;
+  } else {
+    // The scan caught up with the prefetches, start over from here.
+    prefetch_frontier_ = cur_page->GetTablePageId();
+  }
+  // The chain is only known up to the frontier, so the next page to prefetch is found in the frontier page. It is only
+  // looked at once its read has completed, so the scan never waits for a prefetch here; a page still being read is
+  // fetched as usual when the scan gets to it. Advancing the frontier by up to two pages per page scanned lets the
+  // read-ahead grow toward the distance whenever the reads complete quickly enough.
+  for (size_t step = 0; step < 2 && num_prefetched_ahead_ < distance; step++) {
+    page_id_t next_page_id;
+    if (prefetch_frontier_ == cur_page->GetTablePageId()) {
+      next_page_id = cur_page->GetNextPageId();
+    } else {
+      auto frontier_page =
+          static_cast<TablePage *>(table_heap_->buffer_pool_manager_->FetchPageIfResident(prefetch_frontier_));
+      if (frontier_page == nullptr) {
+        return;
+      }
+      frontier_page->RLatch();
+      next_page_id = frontier_page->GetNextPageId();
+      frontier_page->RUnlatch();
+      table_heap_->buffer_pool_manager_->UnpinPage(prefetch_frontier_, false);
+    }
+    if (next_page_id == INVALID_PAGE_ID) {
+      return;
+    }
+    table_heap_->PrefetchTablePages({next_page_id}, strategy_.get());
+    prefetch_frontier_ = next_page_id;
+    num_prefetched_ahead_++;
+  }
+}
+
 auto TableIterator::operator++(int) -> TableIterator {
   TableIterator clone(*this);
   ++(*this);
@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_manager_benchmark_test.cpp
+//
+// Identification: test/buffer/buffer_pool_manager_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// NOLINTNEXTLINE
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+// NOLINTNEXTLINE
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// Fetches and unpins random resident pages from num_threads threads, and returns the number of hits per second.
+static auto RunHitPathBenchmark(BufferPoolManager *bpm, const std::vector<page_id_t> &page_ids, size_t num_threads,
+                                size_t num_hits) -> double {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t thread_itr = 0; thread_itr < num_threads; thread_itr++) {
+    threads.emplace_back([&, thread_itr] {
+      std::mt19937 gen(thread_itr);
+      std::uniform_int_distribution<size_t> dis(0, page_ids.size() - 1);
+      for (size_t i = 0; i < num_hits / num_threads; i++) {
+        page_id_t page_id = page_ids[dis(gen)];
+        Page *page = bpm->FetchPage(page_id);
+        EXPECT_NE(nullptr, page);
+        EXPECT_EQ(page_id, page->GetPageId());
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return static_cast<double>(num_hits / num_threads * num_threads) / elapsed.count();
+}
+
+// Creates buffer_pool_size pages in bpm, all resident and unpinned, and returns their ids.
+static auto CreateResidentPages(BufferPoolManager *bpm, size_t buffer_pool_size) -> std::vector<page_id_t> {
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    EXPECT_NE(nullptr, page);
+    if (page == nullptr) {
+      break;
+    }
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    page_ids.push_back(page_id);
+  }
+  return page_ids;
+}
+
+// Hits on resident pages only take the latch of one page table stripe, never the instance latch, and never go to disk.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerBenchmarkTest, HitPathLatchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const size_t num_threads = 4;
+  const size_t num_hits = 1 << 12;
+
+  auto *disk_manager = new DiskManager(db_name);
+  for (auto replacer_type : {ReplacerType::LRU, ReplacerType::CLOCK, ReplacerType::LRU_K}) {
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, replacer_type);
+    std::vector<page_id_t> page_ids = CreateResidentPages(bpm, buffer_pool_size);
+    ASSERT_EQ(buffer_pool_size, page_ids.size());
+    auto before = bpm->GetStats();
+    RunHitPathBenchmark(bpm, page_ids, num_threads, num_hits);
+    auto after = bpm->GetStats();
+    EXPECT_EQ(num_hits, after.num_fetches_ - before.num_fetches_);
+    EXPECT_EQ(num_hits, after.num_hits_ - before.num_hits_);
+    EXPECT_EQ(before.num_misses_, after.num_misses_);
+    EXPECT_EQ(before.num_latch_acquisitions_, after.num_latch_acquisitions_);
+    delete bpm;
+  }
+  EXPECT_EQ(0, disk_manager->GetStats().read_latency_.count_);
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+// Measures the throughput of buffer pool hits from 1 to 32 threads, for each replacer.
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerBenchmarkTest, DISABLED_HitPathScalingTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 256;
+  const size_t num_hits = 1 << 19;
+
+  auto *disk_manager = new DiskManager(db_name);
+  for (auto replacer_type : {ReplacerType::LRU, ReplacerType::CLOCK, ReplacerType::LRU_K}) {
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, replacer_type);
+    std::vector<page_id_t> page_ids = CreateResidentPages(bpm, buffer_pool_size);
+    ASSERT_EQ(buffer_pool_size, page_ids.size());
+
+    std::cout << "replacer: " << static_cast<int>(replacer_type)
+              << ", hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+    for (size_t num_threads = 1; num_threads <= 32; num_threads *= 2) {
+      double hits_per_sec = RunHitPathBenchmark(bpm, page_ids, num_threads, num_hits);
+      std::cout << "threads: " << num_threads << ", hits/s: " << static_cast<uint64_t>(hits_per_sec) << std::endl;
+    }
+
+    // Every page is still resident and unpinned.
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount());
+    }
+    delete bpm;
+  }
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+}  // namespace bustub
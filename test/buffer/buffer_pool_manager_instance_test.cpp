@@ -11,9 +11,14 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <fstream>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
@@ -141,4 +146,573 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ConcurrentFetchTest) {
+  // Scenario: The same workload passes with every replacement policy.
+  for (auto replacer_type : {ReplacerType::LRU, ReplacerType::CLOCK, ReplacerType::LRU_K}) {
+    SCOPED_TRACE(static_cast<int>(replacer_type));
+    const std::string db_name = "test.db";
+    const size_t buffer_pool_size = 8;
+    const int num_pages = 32;
+    const int num_threads = 8;
+
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, replacer_type);
+
+    // Stamp every page with its id; the pool is smaller than the data, so fetches below both hit and miss.
+    for (int i = 0; i < num_pages; ++i) {
+      page_id_t page_id;
+      auto *page = bpm->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    }
+
+    // Scenario: Concurrent fetchers, some of them of the same page and some of them evicting dirty pages, all see the
+    // latest content of the pages they fetch.
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; ++tid) {
+      threads.emplace_back([bpm, tid] {
+        char expected[PAGE_SIZE];
+        for (int i = 0; i < 1000; ++i) {
+          page_id_t page_id = (i * 7 + tid) % num_pages;
+          auto *page = bpm->FetchPage(page_id);
+          if (page == nullptr) {
+            continue;
+          }
+          snprintf(expected, PAGE_SIZE, "page %d", page_id);
+          EXPECT_EQ(0, strcmp(page->GetData(), expected));
+          EXPECT_EQ(true, bpm->UnpinPage(page_id, i % 2 == 0));
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    // Scenario: Flushing writes every page out, so all of them can be read back through a fresh pool.
+    bpm->FlushAllPages();
+    delete bpm;
+    bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, replacer_type);
+    char expected[PAGE_SIZE];
+    for (int i = 0; i < num_pages; ++i) {
+      auto *page = bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      snprintf(expected, PAGE_SIZE, "page %d", i);
+      EXPECT_EQ(0, strcmp(page->GetData(), expected));
+      EXPECT_EQ(true, bpm->UnpinPage(i, false));
+    }
+
+    // Shutdown the disk manager and remove the temporary file we created.
+    disk_manager->ShutDown();
+    remove("test.db");
+
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, LRUKScanResistanceTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_hot_pages = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, ReplacerType::LRU_K, 2);
+
+  // Scenario: a few pages are accessed twice.
+  std::vector<page_id_t> hot_page_ids;
+  for (size_t i = 0; i < num_hot_pages; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    hot_page_ids.push_back(page_id);
+  }
+
+  // Scenario: a scan touches many more pages than fit in the pool, once each.
+  for (size_t i = 0; i < buffer_pool_size * 4; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: the scan only evicted its own pages.
+  for (auto page_id : hot_page_ids) {
+    bool resident = false;
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      resident = resident || bpm->GetPages()[i].GetPageId() == page_id;
+    }
+    EXPECT_TRUE(resident) << "page " << page_id << " was evicted";
+  }
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, AccessStrategyRingTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 64;
+  const size_t num_hot_pages = 16;
+  const size_t num_scan_pages = 200;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  auto is_resident = [&](page_id_t page_id) {
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      if (bpm->GetPages()[i].GetPageId() == page_id) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  // Scenario: a bulk write creates many more pages than fit in the pool, recycling a ring of frames.
+  BufferAccessStrategy bulk_write(AccessStrategyType::BULK_WRITE);
+  std::vector<page_id_t> scan_page_ids;
+  for (size_t i = 0; i < num_scan_pages; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id, bulk_write);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    scan_page_ids.push_back(page_id);
+  }
+
+  // Scenario: the hot pages fit in the rest of the pool.
+  std::vector<page_id_t> hot_page_ids;
+  for (size_t i = 0; i < num_hot_pages; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    hot_page_ids.push_back(page_id);
+  }
+  for (auto page_id : hot_page_ids) {
+    EXPECT_TRUE(is_resident(page_id));
+  }
+
+  // Scenario: a sequential scan reads all the written pages back and only recycles its own frames.
+  BufferAccessStrategy seq_scan(AccessStrategyType::SEQUENTIAL_SCAN);
+  char expected[PAGE_SIZE];
+  for (auto page_id : scan_page_ids) {
+    auto *page = bpm->FetchPage(page_id, seq_scan);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  for (auto page_id : hot_page_ids) {
+    EXPECT_TRUE(is_resident(page_id)) << "page " << page_id << " was evicted";
+  }
+
+  // Scenario: the same scan without a strategy flushes the hot pages out.
+  for (auto page_id : scan_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  for (auto page_id : hot_page_ids) {
+    EXPECT_FALSE(is_resident(page_id));
+  }
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BackgroundWriterTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 16;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: fill the pool with dirty pages.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: the writer cleans the coldest half of the pool.
+  BackgroundWriterOptions options;
+  options.clean_target_percent_ = 50;
+  options.interval_ = std::chrono::milliseconds(10);
+  bpm->StartBackgroundWriter(options);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (bpm->GetNumBackgroundWrites() < buffer_pool_size / 2 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_GE(bpm->GetNumBackgroundWrites(), buffer_pool_size / 2);
+  // Pinned pages are left alone, and clean pages are not written twice.
+  auto *pinned_page = bpm->FetchPage(page_ids.back());
+  ASSERT_NE(nullptr, pinned_page);
+  bpm->StopBackgroundWriter();
+  EXPECT_LE(bpm->GetNumBackgroundWrites(), buffer_pool_size - 1);
+  ASSERT_TRUE(bpm->UnpinPage(page_ids.back(), false));
+
+  // Scenario: the victims of new pages are clean, nothing is written in the foreground.
+  for (size_t i = 0; i < buffer_pool_size / 2; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0, bpm->GetNumSyncWrites());
+
+  // Scenario: the pages written by the background writer read back intact.
+  char expected[PAGE_SIZE];
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PrefetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 16;
+  const size_t num_pages = 3 * buffer_pool_size;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  auto is_resident = [&](page_id_t page_id) {
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      if (bpm->GetPages()[i].GetPageId() == page_id) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+
+  // Scenario: prefetched pages become resident, unpinned, without being fetched.
+  std::vector<page_id_t> prefetch_page_ids(page_ids.begin(), page_ids.begin() + buffer_pool_size / 2);
+  for (auto page_id : prefetch_page_ids) {
+    ASSERT_FALSE(is_resident(page_id));
+  }
+  bpm->PrefetchPages(prefetch_page_ids);
+  for (auto page_id : prefetch_page_ids) {
+    EXPECT_TRUE(is_resident(page_id));
+  }
+
+  // Scenario: fetches of prefetched pages wait for the reads in flight and see the page content.
+  char expected[PAGE_SIZE];
+  for (auto page_id : prefetch_page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: a resident page can be pinned without I/O, a page that is not resident is not read in.
+  auto *resident_page = bpm->FetchPageIfResident(prefetch_page_ids[0]);
+  ASSERT_NE(nullptr, resident_page);
+  EXPECT_EQ(1, resident_page->GetPinCount());
+  ASSERT_TRUE(bpm->UnpinPage(prefetch_page_ids[0], false));
+  EXPECT_EQ(nullptr, bpm->FetchPageIfResident(page_ids[buffer_pool_size]));
+  EXPECT_FALSE(is_resident(page_ids[buffer_pool_size]));
+
+  // Scenario: prefetching resident pages, or with every frame pinned, changes nothing.
+  bpm->PrefetchPages(prefetch_page_ids);
+  std::vector<page_id_t> pinned_page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id = page_ids[num_pages - buffer_pool_size + i];
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    pinned_page_ids.push_back(page_id);
+  }
+  bpm->PrefetchPages({page_ids[buffer_pool_size]});
+  EXPECT_FALSE(is_resident(page_ids[buffer_pool_size]));
+  for (auto page_id : pinned_page_ids) {
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ChecksumFailureTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const size_t num_pages = 2 * buffer_pool_size;
+
+  auto *disk_manager = new DiskManager(db_name, 0, false, PageChecksumMode::STRICT);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  page_id_t page_id;
+  for (size_t i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+
+  // Corrupt pages 1 and 2 behind the buffer pool's back; neither is resident any more.
+  {
+    std::fstream file(db_name, std::ios::binary | std::ios::in | std::ios::out);
+    for (page_id_t corrupt_page_id : {1, 2}) {
+      file.seekp(corrupt_page_id * PAGE_SIZE);
+      file.write("x", 1);
+    }
+  }
+
+  // Scenario: fetching a corrupt page fails, and the frame it was read into goes back to the free list.
+  EXPECT_EQ(0, bpm->GetStats().num_free_frames_);
+  EXPECT_EQ(nullptr, bpm->FetchPage(1));
+  EXPECT_EQ(1, bpm->GetStats().num_free_frames_);
+  EXPECT_EQ(nullptr, bpm->FetchPage(1));
+  EXPECT_EQ(1, bpm->GetStats().num_free_frames_);
+
+  // Scenario: a corrupt page that is prefetched is dropped instead of becoming resident; a fetch waiting for the read
+  // fails like any other.
+  bpm->PrefetchPages({2});
+  EXPECT_EQ(nullptr, bpm->FetchPage(2));
+  // The I/O thread returns the frame of the prefetch, possibly after the fetch gave up waiting for it and evicted
+  // another page to read 2 again.
+  auto num_accounted_frames = [&] {
+    size_t num_frames = bpm->GetStats().num_free_frames_;
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      num_frames += bpm->GetPages()[i].GetPageId() != INVALID_PAGE_ID ? 1 : 0;
+    }
+    return num_frames;
+  };
+  while (num_accounted_frames() < buffer_pool_size) {
+    std::this_thread::yield();
+  }
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_NE(2, bpm->GetPages()[i].GetPageId());
+  }
+  EXPECT_GE(bpm->GetStats().num_free_frames_, 1);
+
+  // Scenario: no frame is lost to the failed reads, every one of them can be pinned.
+  for (page_id_t good_page_id = 4; good_page_id < 4 + static_cast<page_id_t>(buffer_pool_size); good_page_id++) {
+    auto *page = bpm->FetchPage(good_page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(good_page_id, page->GetPageId());
+  }
+  for (page_id_t good_page_id = 4; good_page_id < 4 + static_cast<page_id_t>(buffer_pool_size); good_page_id++) {
+    ASSERT_TRUE(bpm->UnpinPage(good_page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("test.crc");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FlushWhileFetchingTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 16;
+  const int num_pages = 2 * buffer_pool_size;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: a flush only pins a batch of the dirty pages at a time, so that a fetch always finds a victim while the
+  // pool is full of dirty pages being flushed.
+  std::atomic<bool> done{false};
+  std::thread flusher([&] {
+    while (!done) {
+      bpm->FlushAllPages();
+    }
+  });
+  for (int i = 0; i < 2000; i++) {
+    page_id = i % num_pages;
+    auto *page = bpm->FetchPage(page_id);
+    EXPECT_NE(nullptr, page) << "No victim for page " << page_id;
+    if (page != nullptr) {
+      EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+  }
+  done = true;
+  flusher.join();
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FreePageReuseTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const page_id_t num_pages = 10;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  page_id_t page_id;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_pages, disk_manager->GetNumPages());
+
+  // Scenario: deleted pages are reused lowest first, before the file grows.
+  for (page_id_t deleted_page_id : {5, 3}) {
+    ASSERT_TRUE(bpm->DeletePage(deleted_page_id));
+  }
+  EXPECT_EQ(2, bpm->GetNumFreePages());
+  for (page_id_t expected_page_id : {3, 5, 10}) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(expected_page_id, page_id);
+    EXPECT_EQ('\0', page->GetData()[0]);
+    snprintf(page->GetData(), PAGE_SIZE, "new page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: a reused page is written out even if it was not modified, so it does not read as free on disk.
+  for (page_id_t i = num_pages + 1; i < num_pages + 1 + static_cast<page_id_t>(buffer_pool_size); i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  auto *page = bpm->FetchPage(3);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "new page 3"));
+  ASSERT_TRUE(bpm->UnpinPage(3, false));
+
+  // Scenario: deleting pinned pages fails and does not free them.
+  ASSERT_NE(nullptr, bpm->FetchPage(4));
+  EXPECT_FALSE(bpm->DeletePage(4));
+  EXPECT_EQ(0, bpm->GetNumFreePages());
+  ASSERT_TRUE(bpm->UnpinPage(4, false));
+
+  // Scenario: deleting the pages at the end of the file lets it shrink.
+  bpm->FlushAllPages();
+  page_id_t end_page_id = disk_manager->GetNumPages();
+  for (page_id_t deleted_page_id : {1, end_page_id - 2, end_page_id - 1}) {
+    ASSERT_TRUE(bpm->DeletePage(deleted_page_id));
+  }
+  bpm->ShrinkFile();
+  EXPECT_EQ(end_page_id - 2, disk_manager->GetNumPages());
+  EXPECT_EQ(1, bpm->GetNumFreePages());
+
+  // Scenario: the free pages survive a restart, with the database file reopened.
+  bpm->FlushAllPages();
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  disk_manager = new DiskManager(db_name);
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  EXPECT_EQ(1, bpm->GetNumFreePages());
+  EXPECT_EQ(0, disk_manager->GetStats().read_latency_.count_);
+  for (page_id_t expected_page_id : {1, end_page_id - 2}) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(expected_page_id, page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  page = bpm->FetchPage(4);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "page 4"));
+  ASSERT_TRUE(bpm->UnpinPage(4, false));
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("test.free");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, StatsTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 3;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  page_id_t page_id;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+
+  // Scenario: with all frames pinned, new pages and misses fail, hits do not.
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(nullptr, bpm->FetchPage(5));
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(3, stats.num_new_pages_);
+  EXPECT_EQ(2, stats.num_fetches_);
+  EXPECT_EQ(1, stats.num_hits_);
+  EXPECT_EQ(0, stats.num_misses_);
+  EXPECT_EQ(2, stats.num_pin_failures_);
+
+  // Scenario: evicting clean and dirty pages is counted apart.
+  ASSERT_TRUE(bpm->UnpinPage(0, false));
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); i++) {
+    ASSERT_TRUE(bpm->UnpinPage(i, false));
+  }
+  bpm->FlushAllPages();
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  ASSERT_TRUE(bpm->UnpinPage(1, true));
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  EXPECT_EQ(nullptr, bpm->FetchPage(1));
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  stats = bpm->GetStats();
+  EXPECT_EQ(5, stats.num_fetches_);
+  EXPECT_EQ(2, stats.num_hits_);
+  EXPECT_EQ(1, stats.num_misses_);
+  EXPECT_EQ(3, stats.num_pin_failures_);
+  EXPECT_EQ(2, stats.num_clean_evictions_);
+  EXPECT_EQ(2, stats.num_dirty_evictions_);
+  EXPECT_EQ(2, stats.num_sync_writes_);
+  EXPECT_DOUBLE_EQ(0.4, stats.HitRatio());
+
+  // Scenario: the disk manager timed the read of the miss, the flush as one write per batch, a single page in a pool
+  // this small, and the two write backs.
+  auto disk_stats = disk_manager->GetStats();
+  EXPECT_EQ(1, disk_stats.read_latency_.count_);
+  EXPECT_EQ(buffer_pool_size + 2, disk_stats.write_latency_.count_);
+  EXPECT_EQ(buffer_pool_size + 2, disk_stats.num_writes_);
+  EXPECT_LE(disk_stats.write_latency_.PercentileNs(50), disk_stats.write_latency_.PercentileNs(100));
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
@@ -19,7 +19,7 @@
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +59,55 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(ClockReplacerTest, ConcurrencyTest) {
+  const size_t num_pages = 64;
+  const size_t num_threads = 4;
+  ClockReplacer clock_replacer(num_pages);
+
+  // Scenario: every thread unpins, accesses and pins its own share of the frames.
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      for (int round = 0; round < 100; round++) {
+        for (size_t frame_id = tid; frame_id < num_pages; frame_id += num_threads) {
+          clock_replacer.Unpin(frame_id);
+          clock_replacer.RecordAccess(frame_id);
+          clock_replacer.Pin(frame_id);
+        }
+      }
+      for (size_t frame_id = tid; frame_id < num_pages; frame_id += num_threads) {
+        clock_replacer.Unpin(frame_id);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_pages, clock_replacer.Size());
+
+  // Scenario: concurrent victims never return the same frame twice.
+  std::vector<std::vector<frame_id_t>> victims(num_threads);
+  threads.clear();
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      frame_id_t frame_id;
+      for (size_t i = 0; i < num_pages / num_threads; i++) {
+        ASSERT_TRUE(clock_replacer.Victim(&frame_id));
+        victims[tid].push_back(frame_id);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::vector<bool> seen(num_pages, false);
+  for (const auto &thread_victims : victims) {
+    for (auto frame_id : thread_victims) {
+      EXPECT_FALSE(seen[frame_id]);
+      seen[frame_id] = true;
+    }
+  }
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
 }  // namespace bustub
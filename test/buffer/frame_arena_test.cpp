@@ -0,0 +1,68 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena_test.cpp
+//
+// Identification: test/buffer/frame_arena_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, SampleTest) {
+  // Scenario: a small pool and a pool big enough for huge pages both get zeroed, page-aligned, contiguous frames.
+  for (size_t num_frames : {size_t{10}, size_t{2} * HUGE_PAGE_SIZE / PAGE_SIZE + 1}) {
+    FrameArena arena(num_frames);
+    for (size_t i = 0; i < num_frames; i++) {
+      char *data = arena.GetFrameData(static_cast<frame_id_t>(i));
+      ASSERT_EQ(0, reinterpret_cast<uintptr_t>(data) % PAGE_SIZE);
+      ASSERT_EQ(arena.GetFrameData(0) + i * PAGE_SIZE, data);
+      ASSERT_EQ(0, data[0]);
+      ASSERT_EQ(0, data[PAGE_SIZE - 1]);
+      memset(data, static_cast<int>(i), PAGE_SIZE);
+    }
+    EXPECT_EQ(static_cast<char>(num_frames - 1), arena.GetFrameData(static_cast<frame_id_t>(num_frames - 1))[0]);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, BufferPoolLayoutTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 16;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: every frame's metadata takes its own cache line, and its data is a separate, page-aligned block.
+  Page *pages = bpm->GetPages();
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(&pages[i]) % CACHE_LINE_SIZE);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(pages[i].GetData()) % PAGE_SIZE);
+    EXPECT_EQ(pages[0].GetData() + i * PAGE_SIZE, pages[i].GetData());
+  }
+
+  // Scenario: pages outside of a buffer pool still come with their own data.
+  Page page;
+  snprintf(page.GetData(), PAGE_SIZE, "Hello");
+  EXPECT_EQ(0, strcmp(page.GetData(), "Hello"));
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,120 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <vector>
+
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+
+  // Scenario: access six frames and unpin each of them, then access frame 1 again.
+  for (frame_id_t frame_id = 1; frame_id <= 6; frame_id++) {
+    lru_k_replacer.RecordAccess(frame_id);
+    lru_k_replacer.Unpin(frame_id);
+  }
+  lru_k_replacer.RecordAccess(1);
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: frames with a single access have an infinite backward K-distance and go first, oldest first.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(4, lru_k_replacer.Size());
+
+  // Scenario: pinned frames cannot be victimized.
+  lru_k_replacer.Pin(4);
+  lru_k_replacer.Pin(5);
+  EXPECT_EQ(2, lru_k_replacer.Size());
+
+  // Scenario: a second access to 6 gives it a finite distance, but 1 was accessed twice earlier.
+  lru_k_replacer.RecordAccess(6);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+
+  // Scenario: a removed frame forgets its history and comes back with an infinite distance.
+  lru_k_replacer.Unpin(4);
+  lru_k_replacer.Unpin(5);
+  lru_k_replacer.RecordAccess(5);
+  lru_k_replacer.Remove(5);
+  EXPECT_EQ(1, lru_k_replacer.Size());
+  lru_k_replacer.RecordAccess(5);
+  lru_k_replacer.Unpin(5);
+  lru_k_replacer.RecordAccess(4);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+}
+
+TEST(LRUKReplacerTest, CorrelatedReferenceTest) {
+  LRUKReplacer lru_k_replacer(4, 2, 3);
+  // Frame 3 is only unpinned to make the clock of the replacer tick.
+  auto tick = [&](int ticks) {
+    for (int i = 0; i < ticks; i++) {
+      lru_k_replacer.Unpin(3);
+      lru_k_replacer.Pin(3);
+    }
+  };
+
+  // Scenario: 0 and 1 get two uncorrelated references each, and 1 and 2 are accessed last.
+  for (frame_id_t frame_id = 0; frame_id < 3; frame_id++) {
+    lru_k_replacer.Unpin(frame_id);
+  }
+  lru_k_replacer.RecordAccess(0);
+  lru_k_replacer.RecordAccess(1);
+  tick(3);
+  lru_k_replacer.RecordAccess(0);
+  tick(3);
+  lru_k_replacer.RecordAccess(1);
+  lru_k_replacer.RecordAccess(2);
+
+  // Scenario: 2 has an infinite distance, but it is still within its correlated reference period, as is 1.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  // Scenario: when every frame is within its period, the period is ignored.
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: back-to-back accesses to 0 are correlated and only count as one reference.
+  for (frame_id_t frame_id = 0; frame_id < 3; frame_id++) {
+    lru_k_replacer.Remove(frame_id);
+  }
+  lru_k_replacer.RecordAccess(1);
+  tick(3);
+  for (frame_id_t frame_id : {1, 2, 0, 0}) {
+    lru_k_replacer.RecordAccess(frame_id);
+  }
+  tick(3);
+  lru_k_replacer.RecordAccess(2);
+  for (frame_id_t frame_id = 0; frame_id < 3; frame_id++) {
+    lru_k_replacer.Unpin(frame_id);
+  }
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+}
+
+}  // namespace bustub
@@ -59,4 +59,27 @@ TEST(LRUReplacerTest, SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+TEST(LRUReplacerTest, RecordAccessTest) {
+  LRUReplacer lru_replacer(7);
+
+  // Scenario: frames accessed while they are in the replacer move behind the ones unpinned before the access.
+  for (frame_id_t frame_id = 1; frame_id <= 4; frame_id++) {
+    lru_replacer.Unpin(frame_id);
+  }
+  lru_replacer.RecordAccess(1);
+  lru_replacer.Unpin(5);
+  lru_replacer.RecordAccess(2);
+  std::vector<frame_id_t> frame_ids;
+  lru_replacer.PeekVictims(5, &frame_ids);
+  EXPECT_EQ((std::vector<frame_id_t>{3, 4, 1, 5, 2}), frame_ids);
+
+  // Scenario: a hot frame is still victimized once it is the least recently used.
+  int value;
+  for (frame_id_t expected : {3, 4, 1, 5, 2}) {
+    ASSERT_TRUE(lru_replacer.Victim(&value));
+    EXPECT_EQ(expected, value);
+  }
+  EXPECT_FALSE(lru_replacer.Victim(&value));
+}
+
 }  // namespace bustub
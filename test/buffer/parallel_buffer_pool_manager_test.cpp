@@ -11,9 +11,11 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/parallel_buffer_pool_manager.h"
+#include <algorithm>
 #include <cstdio>
 #include <random>
 #include <string>
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
@@ -151,4 +153,162 @@ TEST(ParallelBufferPoolManagerTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, AllocationBalanceTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+  const size_t num_instances = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: New pages are spread evenly over the instances.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size * num_instances; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  auto stats = bpm->GetInstanceStats();
+  ASSERT_EQ(num_instances, stats.size());
+  for (const auto &instance_stats : stats) {
+    EXPECT_EQ(buffer_pool_size, instance_stats.pool_size_);
+    EXPECT_EQ(0, instance_stats.num_free_frames_);
+    EXPECT_EQ(buffer_pool_size, instance_stats.num_new_pages_);
+    EXPECT_LE(instance_stats.num_latch_waits_, instance_stats.num_latch_acquisitions_);
+  }
+
+  // Scenario: An instance with free frames takes the new pages until it has no more free frames than the others.
+  for (page_id_t page_id : {2, 6, 10}) {
+    EXPECT_EQ(true, bpm->DeletePage(page_id));
+  }
+  EXPECT_EQ(3, bpm->GetInstanceStats()[2].num_free_frames_);
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(2, page_id_temp % num_instances);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+
+  // Scenario: Once no instance has free frames, new pages go round robin again.
+  for (size_t i = 0; i < num_instances; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  stats = bpm->GetInstanceStats();
+  for (size_t i = 0; i < num_instances; ++i) {
+    EXPECT_EQ(buffer_pool_size + (i == 2 ? 4 : 1), stats[i].num_new_pages_);
+  }
+
+  // Scenario: The summed counters cover all instances. The last new pages each evicted a page that was never written.
+  auto total_stats = bpm->GetStats();
+  EXPECT_EQ(buffer_pool_size * num_instances, total_stats.pool_size_);
+  EXPECT_EQ(buffer_pool_size * num_instances + 3 + num_instances, total_stats.num_new_pages_);
+  EXPECT_EQ(0, total_stats.num_clean_evictions_);
+  EXPECT_EQ(num_instances, total_stats.num_dirty_evictions_);
+  EXPECT_EQ(num_instances, total_stats.num_sync_writes_);
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, FlushAllPagesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 500;
+  const size_t num_instances = 4;
+  const int num_pages = buffer_pool_size * num_instances;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; ++i) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: every dirty page is written once, by several writer threads, and pinned pages are flushed too.
+  auto *pinned_page = bpm->FetchPage(7);
+  ASSERT_NE(nullptr, pinned_page);
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_pages, disk_manager->GetNumWrites());
+  EXPECT_EQ(num_pages, disk_manager->GetNumPages());
+
+  // Scenario: clean pages are not written again, but pages modified since are.
+  snprintf(pinned_page->GetData(), PAGE_SIZE, "modified");
+  EXPECT_EQ(true, bpm->UnpinPage(7, true));
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_pages + 1, disk_manager->GetNumWrites());
+
+  // Scenario: the pages can be read back through a fresh pool.
+  delete bpm;
+  bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size / 10, disk_manager);
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < num_pages; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, i == 7 ? "modified" : "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ReopenTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+  const size_t num_instances = 4;
+  const int num_pages = 20;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  for (page_id_t deleted_page_id : {5, 6}) {
+    ASSERT_TRUE(bpm->DeletePage(deleted_page_id));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  // Scenario: a pool over a reopened database file reuses its free pages, then allocates past its end, instead of
+  // handing out pages that are in use.
+  disk_manager = new DiskManager(db_name);
+  bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < 2 * num_instances; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    page_ids.push_back(page_id);
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+  EXPECT_EQ(5, page_ids[0]);
+  EXPECT_EQ(6, page_ids[1]);
+  for (size_t i = 2; i < page_ids.size(); ++i) {
+    EXPECT_LE(num_pages, page_ids[i]);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.free");
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
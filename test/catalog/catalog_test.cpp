@@ -688,4 +688,52 @@ TEST(CatalogTest, DISABLED_IndexInteraction3) {
   remove("catalog_test.log");
 }
 
+// A batch of keys should find the same entries in an index as one key at a time
+TEST(CatalogTest, IndexScanKeys) {
+  auto disk_manager = std::make_unique<DiskManager>("catalog_test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(32, disk_manager.get());
+  auto catalog = std::make_unique<Catalog>(bpm.get(), nullptr, nullptr);
+  auto txn = std::make_unique<Transaction>(0);
+
+  const std::string table_name{"foobar"};
+  const std::string index_name{"index1"};
+
+  // Construct a new table and add it to the catalog
+  std::vector<Column> columns{{"A", TypeId::BIGINT}, {"B", TypeId::INTEGER}};
+  Schema table_schema{columns};
+  auto *table_info = catalog->CreateTable(nullptr, table_name, table_schema);
+  EXPECT_NE(Catalog::NULL_TABLE_INFO, table_info);
+
+  // Construct an index for the table
+  std::vector<Column> key_columns{{"A", TypeId::BIGINT}};
+  std::vector<uint32_t> key_attrs{0};
+  Schema key_schema{key_columns};
+  auto *index_info = catalog->CreateIndex<BigintKeyType, BigintValueType, BigintComparatorType>(
+      txn.get(), index_name, table_name, table_schema, key_schema, key_attrs, BIGINT_SIZE, BigintHashFunctionType{});
+  EXPECT_NE(Catalog::NULL_INDEX_INFO, index_info);
+  auto *index = index_info->index_.get();
+
+  // Index the even keys, and look up all of them
+  std::vector<Tuple> index_keys;
+  for (int64_t i = 0; i < 2000; i++) {
+    Tuple tuple{std::vector<Value>{ValueFactory::GetBigIntValue(i), ValueFactory::GetIntegerValue(0)}, &table_schema};
+    index_keys.push_back(tuple.KeyFromTuple(table_info->schema_, *index->GetKeySchema(), index->GetKeyAttrs()));
+    if (i % 2 == 0) {
+      index->InsertEntry(index_keys.back(), RID(i), txn.get());
+    }
+  }
+  std::vector<std::vector<RID>> batch_results;
+  index->ScanKeys(index_keys, &batch_results, txn.get());
+  ASSERT_EQ(index_keys.size(), batch_results.size());
+  for (size_t i = 0; i < index_keys.size(); i++) {
+    std::vector<RID> results;
+    index->ScanKey(index_keys[i], &results, txn.get());
+    EXPECT_EQ(results, batch_results[i]);
+    EXPECT_EQ(i % 2 == 0, batch_results[i].size() == 1);
+  }
+
+  remove("catalog_test.db");
+  remove("catalog_test.log");
+}
+
 }  // namespace bustub
@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_benchmark_test.cpp
+//
+// Identification: test/common/crc32c_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// NOLINTNEXTLINE
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "common/config.h"
+#include "common/util/crc32c_util.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// Returns num_pages pages of random bytes, the same ones on every call.
+static auto MakeRandomPages(size_t num_pages) -> std::vector<char> {
+  std::mt19937 gen(0);
+  std::vector<char> data(num_pages * PAGE_SIZE);
+  for (auto &byte : data) {
+    byte = static_cast<char>(gen());
+  }
+  return data;
+}
+
+// Checksums num_pages pages num_rounds times over, and returns the nanoseconds spent per page. The checksums of the
+// pages are XORed into *result.
+template <class Checksum>
+static auto RunChecksumBenchmark(Checksum checksum, size_t num_pages, size_t num_rounds, uint32_t *result) -> double {
+  std::vector<char> data = MakeRandomPages(num_pages);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < num_rounds; round++) {
+    for (size_t i = 0; i < num_pages; i++) {
+      *result ^= checksum(data.data() + i * PAGE_SIZE, PAGE_SIZE);
+    }
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / static_cast<double>(num_pages * num_rounds);
+}
+
+// The pages the benchmark checksums get the same checksum from Crc32c as from Crc32cSoftware, whichever of them is
+// accelerated on this machine, and a zeroed page gets its known checksum.
+// NOLINTNEXTLINE
+TEST(Crc32cBenchmarkTest, PageChecksumTest) {
+  const size_t num_pages = 16;
+  std::vector<char> data = MakeRandomPages(num_pages);
+  for (size_t i = 0; i < num_pages; i++) {
+    EXPECT_EQ(Crc32cUtil::Crc32cSoftware(data.data() + i * PAGE_SIZE, PAGE_SIZE),
+              Crc32cUtil::Crc32c(data.data() + i * PAGE_SIZE, PAGE_SIZE));
+  }
+  std::vector<char> zeroes(PAGE_SIZE);
+  EXPECT_EQ(0x98F94189, Crc32cUtil::Crc32c(zeroes.data(), PAGE_SIZE));
+  EXPECT_EQ(0x98F94189, Crc32cUtil::Crc32cSoftware(zeroes.data(), PAGE_SIZE));
+}
+
+// Measures the cost of checksumming a page, with pages in the CPU caches and with pages coming from memory.
+// NOLINTNEXTLINE
+TEST(Crc32cBenchmarkTest, DISABLED_PageChecksumTest) {
+  std::cout << "hardware accelerated: " << Crc32cUtil::IsHardwareAccelerated() << std::endl;
+  for (size_t num_pages : {16, 16384}) {
+    size_t num_rounds = (1 << 16) / num_pages;
+    uint32_t hardware_result = 0;
+    uint32_t software_result = 0;
+    double hardware_ns = RunChecksumBenchmark(Crc32cUtil::Crc32c, num_pages, num_rounds, &hardware_result);
+    double software_ns = RunChecksumBenchmark(Crc32cUtil::Crc32cSoftware, num_pages, num_rounds, &software_result);
+    EXPECT_EQ(software_result, hardware_result);
+    std::cout << "pages: " << num_pages << ", Crc32c ns/page: " << hardware_ns
+              << ", Crc32cSoftware ns/page: " << software_ns << std::endl;
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,60 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_util_test.cpp
+//
+// Identification: test/common/crc32c_util_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "common/util/crc32c_util.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(Crc32cUtilTest, KnownValuesTest) {
+  const std::string check("123456789");
+  EXPECT_EQ(0xE3069283, Crc32cUtil::Crc32c(check.data(), check.size()));
+  EXPECT_EQ(0xE3069283, Crc32cUtil::Crc32cSoftware(check.data(), check.size()));
+  EXPECT_EQ(0, Crc32cUtil::Crc32c(nullptr, 0));
+
+  // From RFC 3720, B.4.
+  std::vector<char> zeroes(32, 0);
+  std::vector<char> ones(32, static_cast<char>(0xFF));
+  EXPECT_EQ(0x8A9136AA, Crc32cUtil::Crc32c(zeroes.data(), zeroes.size()));
+  EXPECT_EQ(0x62A8AB43, Crc32cUtil::Crc32c(ones.data(), ones.size()));
+}
+
+// NOLINTNEXTLINE
+TEST(Crc32cUtilTest, HardwareMatchesSoftwareTest) {
+  std::mt19937 gen(0);
+  std::vector<char> data(PAGE_SIZE * 2);
+  for (auto &byte : data) {
+    byte = static_cast<char>(gen());
+  }
+  // Every length up to a page and a bit, from aligned and unaligned starts, so that all the stream splits are covered.
+  for (size_t offset = 0; offset < 8; offset += 3) {
+    for (size_t length = 0; length <= PAGE_SIZE + 64; length++) {
+      ASSERT_EQ(Crc32cUtil::Crc32cSoftware(data.data() + offset, length),
+                Crc32cUtil::Crc32c(data.data() + offset, length))
+          << "offset " << offset << ", length " << length;
+    }
+  }
+
+  // Any change to a page changes its checksum.
+  uint32_t checksum = Crc32cUtil::Crc32c(data.data(), PAGE_SIZE);
+  data[PAGE_SIZE / 2] ^= 1;
+  EXPECT_NE(checksum, Crc32cUtil::Crc32c(data.data(), PAGE_SIZE));
+}
+
+}  // namespace bustub
@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// latency_histogram_test.cpp
+//
+// Identification: test/common/latency_histogram_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdint>
+// NOLINTNEXTLINE
+#include <thread>
+#include <vector>
+
+#include "common/latency_histogram.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(LatencyHistogramTest, BucketTest) {
+  LatencyHistogram histogram;
+  auto snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(0, snapshot.count_);
+  EXPECT_EQ(0, snapshot.PercentileNs(50));
+
+  // 90 fast recordings in [64, 128), 10 slow ones in [4096, 8192).
+  for (int i = 0; i < 90; i++) {
+    histogram.Record(100);
+  }
+  for (int i = 0; i < 10; i++) {
+    histogram.Record(5000);
+  }
+  snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(100, snapshot.count_);
+  EXPECT_EQ(90, snapshot.buckets_[6]);
+  EXPECT_EQ(10, snapshot.buckets_[12]);
+  EXPECT_DOUBLE_EQ(590, snapshot.MeanNs());
+  EXPECT_EQ(127, snapshot.PercentileNs(0));
+  EXPECT_EQ(127, snapshot.PercentileNs(89));
+  EXPECT_EQ(8191, snapshot.PercentileNs(90));
+  EXPECT_EQ(8191, snapshot.PercentileNs(100));
+
+  // Zero goes to the first bucket, anything huge to the last.
+  histogram.Record(0);
+  histogram.Record(UINT64_MAX / 2);
+  snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(1, snapshot.buckets_[0]);
+  EXPECT_EQ(1, snapshot.buckets_[LatencyHistogram::NUM_BUCKETS - 1]);
+  EXPECT_EQ(UINT64_MAX, snapshot.PercentileNs(100));
+}
+
+// NOLINTNEXTLINE
+TEST(LatencyHistogramTest, ConcurrentRecordTest) {
+  const int num_threads = 8;
+  const int num_records = 10000;
+  LatencyHistogram histogram;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      for (int i = 0; i < num_records; i++) {
+        histogram.Record(1U << tid);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(num_threads * num_records, snapshot.count_);
+  for (int tid = 0; tid < num_threads; tid++) {
+    EXPECT_EQ(num_records, snapshot.buckets_[tid]);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,116 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// rwlatch_benchmark_test.cpp
+//
+// Identification: test/common/rwlatch_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+// NOLINTNEXTLINE
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+// NOLINTNEXTLINE
+#include <thread>
+#include <vector>
+
+#include "common/hybrid_latch.h"
+#include "common/rwlatch.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// Runs num_ops latched operations on a shared value from num_threads threads, write_percent of them under the write
+// latch and the rest under the read latch, and returns the number of operations per second. Every operation also
+// counts the threads inside the latch, and checks that a writer was alone and a reader saw no writer.
+template <class Latch>
+static auto RunLatchBenchmark(size_t num_threads, size_t num_ops, int write_percent) -> double {
+  Latch latch;
+  uint64_t value = 0;
+  std::atomic<uint64_t> read_sum{0};
+  std::atomic<uint64_t> num_writes{0};
+  std::atomic<int> num_writers_inside{0};
+  std::atomic<int> num_readers_inside{0};
+  std::atomic<uint64_t> num_violations{0};
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t thread_itr = 0; thread_itr < num_threads; thread_itr++) {
+    threads.emplace_back([&, thread_itr] {
+      std::mt19937 gen(thread_itr);
+      std::uniform_int_distribution<int> dis(0, 99);
+      uint64_t sum = 0;
+      uint64_t writes = 0;
+      for (size_t i = 0; i < num_ops / num_threads; i++) {
+        if (dis(gen) < write_percent) {
+          latch.WLock();
+          if (num_writers_inside.fetch_add(1) != 0 || num_readers_inside.load() != 0) {
+            num_violations++;
+          }
+          value++;
+          writes++;
+          num_writers_inside.fetch_sub(1);
+          latch.WUnlock();
+        } else {
+          latch.RLock();
+          num_readers_inside.fetch_add(1);
+          if (num_writers_inside.load() != 0) {
+            num_violations++;
+          }
+          sum += value;
+          num_readers_inside.fetch_sub(1);
+          latch.RUnlock();
+        }
+      }
+      // Publish the reads, so that they are not optimized away.
+      read_sum += sum;
+      num_writes += writes;
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(0, num_violations);
+  EXPECT_EQ(num_writes, value);
+  EXPECT_LE(read_sum, value * num_ops);
+  return static_cast<double>(num_ops / num_threads * num_threads) / elapsed.count();
+}
+
+// Both latches keep writers exclusive and lose no write, with readers and writers contending on more threads than
+// the spin phase of the HybridLatch covers.
+// NOLINTNEXTLINE
+TEST(RWLatchBenchmarkTest, LatchExclusionTest) {
+  const size_t num_ops = 1 << 14;
+
+  for (int write_percent : {5, 50}) {
+    RunLatchBenchmark<ReaderWriterLatch>(16, num_ops, write_percent);
+    RunLatchBenchmark<HybridLatch>(16, num_ops, write_percent);
+  }
+}
+
+// Compares the HybridLatch with the ReaderWriterLatch, under a read-mostly and a write-heavy mix.
+// NOLINTNEXTLINE
+TEST(RWLatchBenchmarkTest, DISABLED_LatchScalingTest) {
+  const size_t num_ops = 1 << 18;
+
+  std::cout << "sizeof(ReaderWriterLatch): " << sizeof(ReaderWriterLatch)
+            << ", sizeof(HybridLatch): " << sizeof(HybridLatch)
+            << ", hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+  for (int write_percent : {5, 50}) {
+    for (size_t num_threads : {1, 4, 16, 64}) {
+      double rw_latch_ops = RunLatchBenchmark<ReaderWriterLatch>(num_threads, num_ops, write_percent);
+      double hybrid_latch_ops = RunLatchBenchmark<HybridLatch>(num_threads, num_ops, write_percent);
+      std::cout << "writes: " << write_percent << "%, threads: " << num_threads
+                << ", ReaderWriterLatch ops/s: " << static_cast<uint64_t>(rw_latch_ops)
+                << ", HybridLatch ops/s: " << static_cast<uint64_t>(hybrid_latch_ops) << std::endl;
+    }
+  }
+}
+
+}  // namespace bustub
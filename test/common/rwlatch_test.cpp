@@ -10,14 +10,18 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <thread>  // NOLINT
 #include <vector>
 
+#include "common/hybrid_latch.h"
 #include "common/rwlatch.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
 
+template <class Latch>
 class Counter {
  public:
   Counter() = default;
@@ -36,13 +40,13 @@ class Counter {
 
  private:
   int count_{0};
-  ReaderWriterLatch mutex_{};
+  Latch mutex_{};
 };
 
 // NOLINTNEXTLINE
 TEST(RWLatchTest, BasicTest) {
   int num_threads = 100;
-  Counter counter{};
+  Counter<ReaderWriterLatch> counter{};
   counter.Add(5);
   std::vector<std::thread> threads;
   for (int tid = 0; tid < num_threads; tid++) {
@@ -57,4 +61,69 @@ TEST(RWLatchTest, BasicTest) {
   }
   EXPECT_EQ(counter.Read(), 55);
 }
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, HybridLatchTest) {
+  int num_threads = 64;
+  int num_iterations = 2000;
+  Counter<HybridLatch> counter{};
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&counter, tid, num_iterations]() {
+      for (int i = 0; i < num_iterations; i++) {
+        if ((tid + i) % 4 == 0) {
+          counter.Add(1);
+        } else {
+          counter.Read();
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(counter.Read(), num_threads * num_iterations / 4);
+}
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, HybridLatchExclusionTest) {
+  HybridLatch latch;
+  std::atomic<int> num_readers{0};
+  std::atomic<bool> writer_in{false};
+
+  // Scenario: readers share the latch.
+  latch.RLock();
+  latch.RLock();
+  latch.RUnlock();
+  latch.RUnlock();
+
+  // Scenario: a writer waits for the readers to leave, and readers wait for the writer.
+  latch.RLock();
+  std::thread writer([&] {
+    latch.WLock();
+    writer_in = true;
+    EXPECT_EQ(0, num_readers.load());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    writer_in = false;
+    latch.WUnlock();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(writer_in);
+  latch.RUnlock();
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&] {
+      latch.RLock();
+      num_readers++;
+      EXPECT_FALSE(writer_in);
+      num_readers--;
+      latch.RUnlock();
+    });
+  }
+  writer.join();
+  for (auto &reader : readers) {
+    reader.join();
+  }
+}
+
 }  // namespace bustub
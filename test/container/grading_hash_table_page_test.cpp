@@ -69,7 +69,7 @@ TEST(HashTablePageTest, BucketPageSampleTest) {
 
   // insert a few (key, value) pairs
   for (unsigned i = 0; i < 10; i++) {
-    assert(bucket_page->Insert(i, i, IntComparator()));
+    assert(bucket_page->Insert(i, i, IntComparator(), static_cast<uint8_t>(i)));
   }
 
   // check for the inserted pairs
@@ -81,7 +81,7 @@ TEST(HashTablePageTest, BucketPageSampleTest) {
   // remove a few pairs
   for (unsigned i = 0; i < 10; i++) {
     if (i % 2 == 1) {
-      assert(bucket_page->Remove(i, i, IntComparator()));
+      assert(bucket_page->Remove(i, i, IntComparator(), static_cast<uint8_t>(i)));
     }
   }
 
@@ -102,7 +102,7 @@ TEST(HashTablePageTest, BucketPageSampleTest) {
   // try to remove the already-removed pairs
   for (unsigned i = 0; i < 10; i++) {
     if (i % 2 == 1) {
-      assert(!bucket_page->Remove(i, i, IntComparator()));
+      assert(!bucket_page->Remove(i, i, IntComparator(), static_cast<uint8_t>(i)));
     }
   }
 
@@ -146,25 +146,25 @@ TEST(HashTablePageTest, HashTablePageIntegratedTest) {
   // add to first bucket page until it is full
   size_t pairs_total_page_1 = hash_table_size / 2;
   for (unsigned i = 0; i < pairs_total_page_1; i++) {
-    assert(bucket_page_1->Insert(i, i, IntComparator()));
+    assert(bucket_page_1->Insert(i, i, IntComparator(), static_cast<uint8_t>(i)));
   }
 
   // add to second bucket page until it is full
   size_t pairs_total_page_2 = hash_table_size / 2;
   for (unsigned i = 0; i < pairs_total_page_2; i++) {
-    assert(bucket_page_2->Insert(i, i, IntComparator()));
+    assert(bucket_page_2->Insert(i, i, IntComparator(), static_cast<uint8_t>(i)));
   }
 
   // remove every other pair
   for (unsigned i = 0; i < pairs_total_page_1; i++) {
     if (i % 2 == 1) {
-      bucket_page_1->Remove(i, i, IntComparator());
+      bucket_page_1->Remove(i, i, IntComparator(), static_cast<uint8_t>(i));
     }
   }
 
   for (unsigned i = 0; i < pairs_total_page_2; i++) {
     if (i % 2 == 1) {
-      bucket_page_2->Remove(i, i, IntComparator());
+      bucket_page_2->Remove(i, i, IntComparator(), static_cast<uint8_t>(i));
     }
   }
 
@@ -0,0 +1,75 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_benchmark_test.cpp
+//
+// Identification: test/container/hash_table_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// NOLINTNEXTLINE
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "container/hash/extendible_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// Compares lookups one key at a time with batched lookups of a few batch sizes, in a table that fits in the pool.
+// Disabled by default, like the other benchmarks.
+// NOLINTNEXTLINE
+TEST(HashTableBenchmarkTest, DISABLED_BatchLookupTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(1024, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  const int num_keys = 50000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << "Failed to insert " << i;
+  }
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dis(0, num_keys - 1);
+  std::vector<int> keys(1 << 16);
+  for (auto &key : keys) {
+    key = dis(gen);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  size_t num_found = 0;
+  for (int key : keys) {
+    std::vector<int> res;
+    num_found += static_cast<size_t>(ht.GetValue(nullptr, key, &res));
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(keys.size(), num_found);
+  std::cout << "GetValue ns/lookup: " << elapsed.count() / keys.size() << std::endl;
+
+  for (size_t batch_size : {64, 256, 1024}) {
+    start = std::chrono::steady_clock::now();
+    num_found = 0;
+    std::vector<std::vector<int>> results;
+    for (size_t begin = 0; begin < keys.size(); begin += batch_size) {
+      std::vector<int> batch(keys.begin() + begin, keys.begin() + begin + batch_size);
+      num_found += ht.GetValues(nullptr, batch, &results);
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(keys.size(), num_found);
+    std::cout << "batch size: " << batch_size << ", GetValues ns/lookup: " << elapsed.count() / keys.size()
+              << std::endl;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+}  // namespace bustub
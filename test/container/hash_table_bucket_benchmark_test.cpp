@@ -0,0 +1,167 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_bucket_benchmark_test.cpp
+//
+// Identification: test/container/hash_table_bucket_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// NOLINTNEXTLINE
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "container/hash/hash_function.h"
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "storage/page/hash_table_bucket_page.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+// Scans the bucket the way GetValue did before fingerprints: the comparator is called on every readable slot.
+template <typename KeyType, typename ValueType, typename KeyComparator>
+static auto ScanBucket(HASH_TABLE_BUCKET_TYPE *bucket_page, const KeyType &key, KeyComparator cmp,
+                       std::vector<ValueType> *result) -> bool {
+  for (uint32_t i = 0; i < BUCKET_ARRAY_SIZE; ++i) {
+    if (!bucket_page->IsReadable(i)) {
+      if (!bucket_page->IsOccupied(i)) {
+        break;
+      }
+      continue;
+    }
+    if (cmp(key, bucket_page->KeyAt(i)) == 0) {
+      result->push_back(bucket_page->ValueAt(i));
+    }
+  }
+  return !result->empty();
+}
+
+// Returns the fingerprint of key, the top byte of its hash, as in the hash table, which computes the hash anyway.
+template <size_t KeySize>
+static auto KeyFingerprint(const GenericKey<KeySize> &key) -> uint8_t {
+  HashFunction<GenericKey<KeySize>> hash_fn;
+  return static_cast<uint8_t>(static_cast<uint32_t>(hash_fn.GetHash(key)) >> 24);
+}
+
+// Fills the bucket page with the keys i * 7919 and the values RID(i), and appends the keys to *keys and their
+// fingerprints to *fingerprints.
+template <size_t KeySize>
+static void FillBucket(HashTableBucketPage<GenericKey<KeySize>, RID, GenericComparator<KeySize>> *bucket_page,
+                       const GenericComparator<KeySize> &comparator, std::vector<GenericKey<KeySize>> *keys,
+                       std::vector<uint8_t> *fingerprints) {
+  for (int64_t i = 0; !bucket_page->IsFull(); i++) {
+    GenericKey<KeySize> key;
+    key.SetFromInteger(i * 7919);
+    fingerprints->push_back(KeyFingerprint(key));
+    EXPECT_TRUE(bucket_page->Insert(key, RID(i), comparator, fingerprints->back()));
+    keys->push_back(key);
+  }
+}
+
+// GetValue, which only compares the keys whose fingerprint matches, finds what ScanBucket finds: the keys of a full
+// bucket, nothing for absent keys, including ones sharing the fingerprint of a key in the bucket, and nothing for
+// removed keys.
+// NOLINTNEXTLINE
+TEST(HashTableBucketBenchmarkTest, ProbeTest) {
+  using BucketPage = HashTableBucketPage<GenericKey<8>, RID, GenericComparator<8>>;
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto data = std::make_unique<char[]>(PAGE_SIZE);
+  auto bucket_page = reinterpret_cast<BucketPage *>(data.get());
+  std::vector<GenericKey<8>> keys;
+  std::vector<uint8_t> fingerprints;
+  FillBucket(bucket_page, comparator, &keys, &fingerprints);
+  ASSERT_EQ(bucket_page->NumReadable(), keys.size());
+
+  std::vector<RID> result;
+  std::vector<RID> expected;
+  for (size_t i = 0; i < keys.size(); i++) {
+    result.clear();
+    expected.clear();
+    EXPECT_TRUE(bucket_page->GetValue(keys[i], comparator, fingerprints[i], &result));
+    EXPECT_TRUE(ScanBucket(bucket_page, keys[i], comparator, &expected));
+    EXPECT_EQ(expected, result);
+    EXPECT_EQ(std::vector<RID>{RID(i)}, result);
+  }
+
+  // Scenario: absent keys, probed with their own fingerprint and with the fingerprint of a key in the bucket.
+  for (size_t i = 0; i < keys.size(); i++) {
+    GenericKey<8> absent_key;
+    absent_key.SetFromInteger(static_cast<int64_t>(i) * 7919 + 1);
+    result.clear();
+    EXPECT_FALSE(bucket_page->GetValue(absent_key, comparator, KeyFingerprint(absent_key), &result));
+    EXPECT_FALSE(bucket_page->GetValue(absent_key, comparator, fingerprints[i], &result));
+    EXPECT_FALSE(ScanBucket(bucket_page, absent_key, comparator, &result));
+  }
+
+  // Scenario: removed keys leave tombstones, which are skipped, while the keys after them are still found.
+  for (size_t i = 0; i < keys.size(); i += 2) {
+    EXPECT_TRUE(bucket_page->Remove(keys[i], RID(i), comparator, fingerprints[i]));
+  }
+  for (size_t i = 0; i < keys.size(); i++) {
+    result.clear();
+    expected.clear();
+    EXPECT_EQ(i % 2 == 1, bucket_page->GetValue(keys[i], comparator, fingerprints[i], &result));
+    ScanBucket(bucket_page, keys[i], comparator, &expected);
+    EXPECT_EQ(expected, result);
+  }
+}
+
+// Fills a bucket page and looks up each of its keys num_rounds times, with GetValue and with ScanBucket; returns the
+// nanoseconds spent per lookup by each.
+template <size_t KeySize>
+static auto RunProbeBenchmark(const std::string &create_statement, size_t num_rounds) -> std::pair<double, double> {
+  using BucketPage = HashTableBucketPage<GenericKey<KeySize>, RID, GenericComparator<KeySize>>;
+  auto key_schema = ParseCreateStatement(create_statement);
+  GenericComparator<KeySize> comparator(key_schema.get());
+  auto data = std::make_unique<char[]>(PAGE_SIZE);
+  auto bucket_page = reinterpret_cast<BucketPage *>(data.get());
+  std::vector<GenericKey<KeySize>> keys;
+  std::vector<uint8_t> fingerprints;
+  FillBucket(bucket_page, comparator, &keys, &fingerprints);
+
+  std::pair<double, double> ns_per_lookup;
+  size_t num_found = 0;
+  std::vector<RID> result;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < num_rounds; round++) {
+    for (size_t i = 0; i < keys.size(); i++) {
+      result.clear();
+      num_found += static_cast<size_t>(bucket_page->GetValue(keys[i], comparator, fingerprints[i], &result));
+    }
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  ns_per_lookup.first = elapsed.count() / static_cast<double>(num_rounds * keys.size());
+  start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < num_rounds; round++) {
+    for (const auto &key : keys) {
+      result.clear();
+      num_found += static_cast<size_t>(ScanBucket(bucket_page, key, comparator, &result));
+    }
+  }
+  elapsed = std::chrono::steady_clock::now() - start;
+  ns_per_lookup.second = elapsed.count() / static_cast<double>(num_rounds * keys.size());
+  EXPECT_EQ(2 * num_rounds * keys.size(), num_found);
+  return ns_per_lookup;
+}
+
+// Compares the lookups of a full bucket with fingerprints against a scan of all its keys, for 8 and 16 byte keys.
+// NOLINTNEXTLINE
+TEST(HashTableBucketBenchmarkTest, DISABLED_ProbeScalingTest) {
+  auto [fingerprint_ns, scan_ns] = RunProbeBenchmark<8>("a bigint", 20);
+  std::cout << "8-byte keys, GetValue ns/lookup: " << fingerprint_ns << ", scan ns/lookup: " << scan_ns << std::endl;
+  std::tie(fingerprint_ns, scan_ns) = RunProbeBenchmark<16>("a bigint,b bigint", 20);
+  std::cout << "16-byte keys, GetValue ns/lookup: " << fingerprint_ns << ", scan ns/lookup: " << scan_ns << std::endl;
+}
+
+}  // namespace bustub
@@ -69,7 +69,7 @@ TEST(HashTablePageTest, BucketPageSampleTest) {
 
   // insert a few (key, value) pairs
   for (unsigned i = 0; i < 10; i++) {
-    assert(bucket_page->Insert(i, i, IntComparator()));
+    assert(bucket_page->Insert(i, i, IntComparator(), static_cast<uint8_t>(i)));
   }
 
   // check for the inserted pairs
@@ -81,7 +81,7 @@ TEST(HashTablePageTest, BucketPageSampleTest) {
   // remove a few pairs
   for (unsigned i = 0; i < 10; i++) {
     if (i % 2 == 1) {
-      assert(bucket_page->Remove(i, i, IntComparator()));
+      assert(bucket_page->Remove(i, i, IntComparator(), static_cast<uint8_t>(i)));
     }
   }
 
@@ -102,7 +102,7 @@ TEST(HashTablePageTest, BucketPageSampleTest) {
   // try to remove the already-removed pairs
   for (unsigned i = 0; i < 10; i++) {
     if (i % 2 == 1) {
-      assert(!bucket_page->Remove(i, i, IntComparator()));
+      assert(!bucket_page->Remove(i, i, IntComparator(), static_cast<uint8_t>(i)));
     }
   }
 
@@ -114,4 +114,56 @@ TEST(HashTablePageTest, BucketPageSampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, BucketPageFingerprintTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
+
+  page_id_t bucket_page_id = INVALID_PAGE_ID;
+  auto bucket_page = reinterpret_cast<HashTableBucketPage<int, int, IntComparator> *>(
+      bpm->NewPage(&bucket_page_id, nullptr)->GetData());
+
+  // Half the pairs share key 0, and so their fingerprint; the fingerprints of the other keys take few values, so that
+  // most probes also compare keys that only share their fingerprint.
+  auto fingerprint = [](int key) { return static_cast<uint8_t>(key % 7); };
+  int bucket_size = 0;
+  for (; !bucket_page->IsFull(); bucket_size++) {
+    int key = bucket_size % 2 == 0 ? 0 : bucket_size;
+    ASSERT_TRUE(bucket_page->Insert(key, bucket_size, IntComparator(), fingerprint(key)));
+  }
+  EXPECT_GT(bucket_size, 400);
+  EXPECT_FALSE(bucket_page->Insert(bucket_size, bucket_size, IntComparator(), fingerprint(bucket_size)));
+  EXPECT_FALSE(bucket_page->Insert(0, 0, IntComparator(), fingerprint(0)));
+  std::vector<int> res;
+  ASSERT_TRUE(bucket_page->GetValue(0, IntComparator(), fingerprint(0), &res));
+  EXPECT_EQ((bucket_size + 1) / 2, res.size());
+  for (int i = 1; i < bucket_size; i += 2) {
+    res.clear();
+    ASSERT_TRUE(bucket_page->GetValue(i, IntComparator(), fingerprint(i), &res)) << "Failed to find " << i;
+    EXPECT_EQ(std::vector<int>{i}, res);
+  }
+
+  // Removed pairs are not found anymore, and their slots are reused, the first one first.
+  for (int i = 0; i < bucket_size; i += 3) {
+    int key = i % 2 == 0 ? 0 : i;
+    ASSERT_TRUE(bucket_page->Remove(key, i, IntComparator(), fingerprint(key))) << "Failed to remove " << i;
+  }
+  EXPECT_EQ(bucket_size - (bucket_size + 2) / 3, bucket_page->NumReadable());
+  res.clear();
+  EXPECT_FALSE(bucket_page->GetValue(3, IntComparator(), fingerprint(3), &res));
+  EXPECT_TRUE(bucket_page->Insert(-1, -1, IntComparator(), fingerprint(-1)));
+  EXPECT_EQ(-1, bucket_page->KeyAt(0));
+  EXPECT_TRUE(bucket_page->Insert(-2, -2, IntComparator(), fingerprint(-2)));
+  EXPECT_EQ(-2, bucket_page->KeyAt(3));
+  res.clear();
+  EXPECT_TRUE(bucket_page->GetValue(-2, IntComparator(), fingerprint(-2), &res));
+  EXPECT_EQ(std::vector<int>{-2}, res);
+
+  bpm->UnpinPage(bucket_page_id, true, nullptr);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -10,6 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <atomic>
+#include <random>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -117,4 +120,371 @@ TEST(HashTableTest, SampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTableTest, PinLeakTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  const size_t buffer_pool_size = 10;
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // Scenario: splits, lookups, removes and merges all leave the pages they touched unpinned.
+  const int num_keys = 2000;
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    EXPECT_EQ(1, res.size());
+  }
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    std::vector<int> res;
+    EXPECT_FALSE(ht.GetValue(nullptr, i, &res));
+  }
+  ht.VerifyIntegrity();
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, OutOfFramesTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  const size_t buffer_pool_size = 10;
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // Fill the only bucket, so that the next insert has to split it.
+  using KeyType = int;
+  using ValueType = int;
+  const int bucket_size = BUCKET_ARRAY_SIZE;
+  for (int i = 0; i < bucket_size; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+
+  // Scenario: with every frame pinned, all operations fail instead of touching a page they could not get.
+  std::vector<page_id_t> pinned_page_ids(buffer_pool_size);
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&pinned_page_ids[i]));
+  }
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 0, &res));
+  EXPECT_FALSE(ht.Insert(nullptr, bucket_size, bucket_size));
+  EXPECT_FALSE(ht.Remove(nullptr, 0, 0));
+  std::vector<std::vector<int>> results;
+  EXPECT_EQ(0, ht.GetValues(nullptr, {0, 1}, &results));
+
+  // Scenario: with two frames left, the bucket and the directory page can be latched but the split cannot go on. It
+  // fails without losing any entry.
+  EXPECT_TRUE(bpm->UnpinPage(pinned_page_ids[0], false));
+  EXPECT_TRUE(bpm->UnpinPage(pinned_page_ids[1], false));
+  EXPECT_FALSE(ht.Insert(nullptr, bucket_size, bucket_size));
+
+  for (size_t i = 2; i < buffer_pool_size; i++) {
+    EXPECT_TRUE(bpm->UnpinPage(pinned_page_ids[i], false));
+  }
+  EXPECT_TRUE(ht.Insert(nullptr, bucket_size, bucket_size));
+  for (int i = 0; i <= bucket_size; i++) {
+    res.clear();
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    EXPECT_EQ(1, res.size());
+  }
+  ht.VerifyIntegrity();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, DirectorySplitTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // A single directory page holds 512 buckets of about 500 int pairs each; this many keys need more buckets, so the
+  // directory page has to split, and the header to grow.
+  const int num_keys = 250000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << "Failed to insert " << i;
+  }
+  EXPECT_GT(ht.GetGlobalDepth(), DIRECTORY_MAX_DEPTH);
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, i, &res)) << "Failed to find " << i;
+    EXPECT_EQ(1, res.size());
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // The keys stay removable after the split.
+  for (int i = 0; i < num_keys; i += 2) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    EXPECT_EQ(i % 2 == 1, ht.GetValue(nullptr, i, &res));
+  }
+  ht.VerifyIntegrity();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, MergeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  const int num_keys = 20000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << "Failed to insert " << i;
+  }
+  uint32_t full_depth = ht.GetGlobalDepth();
+  EXPECT_GE(full_depth, 5);
+  EXPECT_EQ(0, bpm->GetNumFreePages());
+
+  // Leaving an eighth of the keys makes the buckets underfull, so that the removes merge them.
+  for (int i = 0; i < num_keys; i++) {
+    if (i % 8 != 0) {
+      ASSERT_TRUE(ht.Remove(nullptr, i, i)) << "Failed to remove " << i;
+    }
+  }
+  ht.VerifyIntegrity();
+  EXPECT_LT(ht.GetGlobalDepth(), full_depth);
+  size_t num_free_pages = bpm->GetNumFreePages();
+  EXPECT_GT(num_free_pages, 0);
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ASSERT_EQ(i % 8 == 0, ht.GetValue(nullptr, i, &res)) << "Wrong lookup of " << i;
+  }
+
+  // A compaction merges what the removes left behind, and the table shrinks back to a single bucket once empty.
+  ht.Compact();
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_keys; i += 8) {
+    ASSERT_TRUE(ht.Remove(nullptr, i, i)) << "Failed to remove " << i;
+  }
+  ht.Compact();
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+
+  // The freed bucket pages are reused when the table grows again.
+  num_free_pages = bpm->GetNumFreePages();
+  EXPECT_GT(num_free_pages, 0);
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << "Failed to insert " << i;
+  }
+  EXPECT_LT(bpm->GetNumFreePages(), num_free_pages);
+  ht.VerifyIntegrity();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, MergePinnedBucketTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // Scenario: one split leaves two buckets, pages 2 and 3 after the header and the directory page.
+  const int num_keys = 600;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << "Failed to insert " << i;
+  }
+  ASSERT_EQ(1, ht.GetGlobalDepth());
+
+  // Scenario: the buckets merge while someone else has both of them pinned, so the freed one cannot be deleted yet.
+  ASSERT_NE(nullptr, bpm->FetchPage(2));
+  ASSERT_NE(nullptr, bpm->FetchPage(3));
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Remove(nullptr, i, i)) << "Failed to remove " << i;
+  }
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+  EXPECT_EQ(0, bpm->GetNumFreePages());
+
+  // Scenario: once it is unpinned, the next compaction deletes it.
+  EXPECT_TRUE(bpm->UnpinPage(2, false));
+  EXPECT_TRUE(bpm->UnpinPage(3, false));
+  ht.Compact();
+  EXPECT_EQ(1, bpm->GetNumFreePages());
+  ht.VerifyIntegrity();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, CompactorTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  const int num_keys = 20000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << "Failed to insert " << i;
+  }
+  uint32_t full_depth = ht.GetGlobalDepth();
+
+  // Remove from a few threads while the compactor does the merges.
+  ht.StartCompactor(std::chrono::milliseconds(1));
+  std::vector<std::thread> threads;
+  const int num_threads = 4;
+  for (int thread_itr = 0; thread_itr < num_threads; thread_itr++) {
+    threads.emplace_back([&, thread_itr] {
+      for (int i = thread_itr; i < num_keys; i += num_threads) {
+        EXPECT_TRUE(ht.Remove(nullptr, i, i)) << "Failed to remove " << i;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ht.StopCompactor();
+
+  ht.VerifyIntegrity();
+  EXPECT_LT(ht.GetGlobalDepth(), full_depth);
+  EXPECT_GT(bpm->GetNumFreePages(), 0);
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ASSERT_FALSE(ht.GetValue(nullptr, i, &res)) << "Found removed key " << i;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// Lookups run while other threads split the buckets, and must never miss a key that was there all along.
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentSplitTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  const int num_preloaded = 1000;
+  for (int i = 0; i < num_preloaded; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << "Failed to insert " << i;
+  }
+
+  const int num_inserters = 4;
+  const int keys_per_inserter = 10000;
+  std::atomic<int> num_inserters_done{0};
+  std::vector<std::thread> threads;
+  for (int thread_itr = 0; thread_itr < num_inserters; thread_itr++) {
+    threads.emplace_back([&, thread_itr] {
+      int first = num_preloaded + thread_itr * keys_per_inserter;
+      for (int i = first; i < first + keys_per_inserter; i++) {
+        EXPECT_TRUE(ht.Insert(nullptr, i, i)) << "Failed to insert " << i;
+      }
+      num_inserters_done++;
+    });
+  }
+  for (int thread_itr = 0; thread_itr < 2; thread_itr++) {
+    threads.emplace_back([&] {
+      while (num_inserters_done < num_inserters) {
+        for (int i = 0; i < num_preloaded; i++) {
+          std::vector<int> res;
+          ASSERT_TRUE(ht.GetValue(nullptr, i, &res)) << "Missed " << i;
+          ASSERT_EQ(std::vector<int>{i}, res);
+        }
+      }
+    });
+  }
+  // Batched lookups too.
+  threads.emplace_back([&] {
+    std::vector<int> keys;
+    for (int i = 0; i < num_preloaded; i++) {
+      keys.push_back(i);
+    }
+    while (num_inserters_done < num_inserters) {
+      std::vector<std::vector<int>> res;
+      ASSERT_EQ(num_preloaded, ht.GetValues(nullptr, keys, &res));
+      for (int i = 0; i < num_preloaded; i++) {
+        ASSERT_EQ(std::vector<int>{i}, res[i]) << "Missed " << i << " in a batch";
+      }
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_preloaded + num_inserters * keys_per_inserter; i++) {
+    std::vector<int> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, i, &res)) << "Failed to find " << i;
+    EXPECT_EQ(std::vector<int>{i}, res);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, GetValuesTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // The even keys have two values.
+  const int num_keys = 20000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << "Failed to insert " << i;
+    if (i % 2 == 0) {
+      ASSERT_TRUE(ht.Insert(nullptr, i, num_keys + i)) << "Failed to insert " << i;
+    }
+  }
+
+  // A batch of random keys, some of them missing and some repeated, gets the same values as one lookup at a time.
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dis(0, num_keys + num_keys / 10);
+  for (size_t batch_size : {1, 64, 1024}) {
+    std::vector<int> keys;
+    for (size_t i = 0; i < batch_size; i++) {
+      keys.push_back(dis(gen));
+    }
+    keys.push_back(keys.front());
+    std::vector<std::vector<int>> results;
+    size_t num_found = ht.GetValues(nullptr, keys, &results);
+    ASSERT_EQ(keys.size(), results.size());
+    size_t expected_num_found = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+      std::vector<int> res;
+      expected_num_found += static_cast<size_t>(ht.GetValue(nullptr, keys[i], &res));
+      std::sort(res.begin(), res.end());
+      std::sort(results[i].begin(), results[i].end());
+      EXPECT_EQ(res, results[i]) << "Wrong values of " << keys[i];
+    }
+    EXPECT_EQ(expected_num_found, num_found);
+  }
+
+  // An empty batch is fine too.
+  std::vector<std::vector<int>> results{{1}};
+  EXPECT_EQ(0, ht.GetValues(nullptr, {}, &results));
+  EXPECT_TRUE(results.empty());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
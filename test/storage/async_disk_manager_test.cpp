@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_manager_test.cpp
+//
+// Identification: test/storage/async_disk_manager_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <future>  // NOLINT
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/disk/async_disk_manager.h"
+
+namespace bustub {
+
+class AsyncDiskManagerTest : public ::testing::TestWithParam<bool> {
+ protected:
+  // This function is called before every test.
+  void SetUp() override {
+    remove("test.db");
+    remove("test.log");
+  }
+
+  // This function is called after every test.
+  void TearDown() override {
+    remove("test.db");
+    remove("test.log");
+  };
+};
+
+// NOLINTNEXTLINE
+TEST_P(AsyncDiskManagerTest, ReadWritePageTest) {
+  const int num_pages = 256;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *async_disk_manager = new AsyncDiskManager(disk_manager, 8, GetParam());
+
+  // Keep many writes in flight at once.
+  std::vector<std::unique_ptr<char[]>> pages;
+  std::vector<std::future<bool>> futures;
+  for (int i = 0; i < num_pages; i++) {
+    pages.emplace_back(new char[PAGE_SIZE]);
+    std::memset(pages.back().get(), i % 128, PAGE_SIZE);
+    futures.push_back(async_disk_manager->WritePage(i, pages.back().get()));
+  }
+  for (auto &future : futures) {
+    EXPECT_TRUE(future.get());
+  }
+  EXPECT_EQ(num_pages, disk_manager->GetNumWrites());
+
+  // Read them back through callbacks.
+  std::vector<std::unique_ptr<char[]>> bufs;
+  std::atomic<int> num_read{0};
+  for (int i = 0; i < num_pages; i++) {
+    bufs.emplace_back(new char[PAGE_SIZE]);
+    async_disk_manager->ReadPage(i, bufs.back().get(), [&num_read](bool success) {
+      EXPECT_TRUE(success);
+      num_read++;
+    });
+  }
+  // Reading past the end of the file returns a zeroed page.
+  char buf[PAGE_SIZE];
+  char zeros[PAGE_SIZE] = {0};
+  std::memset(buf, 1, sizeof(buf));
+  EXPECT_TRUE(async_disk_manager->ReadPage(num_pages + 10, buf).get());
+  EXPECT_EQ(std::memcmp(buf, zeros, sizeof(buf)), 0);
+
+  // The destructor waits for all requests in flight.
+  delete async_disk_manager;
+  EXPECT_EQ(num_pages, num_read.load());
+  for (int i = 0; i < num_pages; i++) {
+    EXPECT_EQ(std::memcmp(bufs[i].get(), pages[i].get(), PAGE_SIZE), 0);
+  }
+
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST_P(AsyncDiskManagerTest, DirectIoTest) {
+  const int num_pages = 64;
+  auto *disk_manager = new DiskManager("test.db", 0, true);
+  auto *async_disk_manager = new AsyncDiskManager(disk_manager, 8, GetParam());
+
+  // Aligned buffers go to the file as is, the others are bounced.
+  std::unique_ptr<char, decltype(&free)> aligned(static_cast<char *>(std::aligned_alloc(PAGE_SIZE, PAGE_SIZE * 2)),
+                                                 &free);
+  char *unaligned = aligned.get() + PAGE_SIZE / 2;
+  for (int i = 0; i < num_pages; i++) {
+    char *page_data = i % 2 == 0 ? aligned.get() : unaligned;
+    std::memset(page_data, i, PAGE_SIZE);
+    EXPECT_TRUE(async_disk_manager->WritePage(i, page_data).get());
+  }
+  for (int i = 0; i < num_pages; i++) {
+    char *page_data = i % 2 == 0 ? unaligned : aligned.get();
+    std::memset(page_data, -1, PAGE_SIZE);
+    EXPECT_TRUE(async_disk_manager->ReadPage(i, page_data).get());
+    EXPECT_EQ(i, page_data[0]);
+    EXPECT_EQ(i, page_data[PAGE_SIZE - 1]);
+  }
+  EXPECT_TRUE(async_disk_manager->ReadPage(num_pages, aligned.get()).get());
+  EXPECT_EQ(0, aligned.get()[0]);
+
+  delete async_disk_manager;
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+
+INSTANTIATE_TEST_SUITE_P(IoUringAndWorkerThreads, AsyncDiskManagerTest, ::testing::Bool());
+
+}  // namespace bustub
@@ -0,0 +1,122 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_benchmark_test.cpp
+//
+// Identification: test/storage/disk_manager_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// NOLINTNEXTLINE
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+// Runs num_ops random page accesses, a tenth of them writes, through a buffer pool that holds an eighth of num_pages
+// pages, and returns the number of accesses per second.
+static auto RunDiskBenchmark(bool direct_io, page_id_t num_pages, size_t num_ops) -> double {
+  const std::string db_name = direct_io ? "direct_io_benchmark.db" : "buffered_io_benchmark.db";
+  auto *disk_manager = new DiskManager(db_name, 0, direct_io);
+  auto *bpm = new BufferPoolManagerInstance(num_pages / 8, disk_manager);
+  page_id_t page_id;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+  bpm->FlushAllPages();
+
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<page_id_t> page_dis(0, num_pages - 1);
+  std::uniform_int_distribution<int> write_dis(0, 9);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_ops; i++) {
+    page_id = page_dis(gen);
+    auto *page = bpm->FetchPage(page_id);
+    EXPECT_NE(nullptr, page);
+    bool is_write = write_dis(gen) == 0;
+    if (is_write) {
+      page->GetData()[PAGE_SIZE - 1]++;
+    }
+    bpm->UnpinPage(page_id, is_write);
+  }
+  bpm->FlushAllPages();
+  disk_manager->SyncPages();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+  return static_cast<double>(num_ops) / elapsed.count();
+}
+
+// Direct I/O and buffered I/O do the same page reads and writes for a buffer pool, one per miss and one per dirty
+// eviction or flush, and read back what they wrote.
+// NOLINTNEXTLINE
+TEST(DiskManagerBenchmarkTest, DirectIoCountersTest) {
+  const page_id_t num_pages = 64;
+  const size_t buffer_pool_size = 8;
+
+  for (bool direct_io : {false, true}) {
+    const std::string db_name = direct_io ? "direct_io_benchmark.db" : "buffered_io_benchmark.db";
+    auto *disk_manager = new DiskManager(db_name, 0, direct_io);
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+    page_id_t page_id;
+    for (page_id_t i = 0; i < num_pages; i++) {
+      auto *page = bpm->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+      ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+    bpm->FlushAllPages();
+    auto stats = disk_manager->GetStats();
+    EXPECT_EQ(num_pages, stats.num_writes_);
+    EXPECT_EQ(0, stats.read_latency_.count_);
+
+    // Scenario: a scan larger than the pool misses on every page, and writes nothing back since no page is dirty.
+    char expected[PAGE_SIZE];
+    for (page_id_t i = 0; i < num_pages; i++) {
+      auto *page = bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      snprintf(expected, PAGE_SIZE, "page %d", i);
+      EXPECT_STREQ(expected, page->GetData());
+      ASSERT_TRUE(bpm->UnpinPage(i, false));
+    }
+    stats = disk_manager->GetStats();
+    EXPECT_EQ(num_pages, stats.num_writes_);
+    EXPECT_EQ(num_pages, stats.read_latency_.count_);
+    EXPECT_EQ(0, stats.num_checksum_failures_);
+
+    disk_manager->ShutDown();
+    remove(db_name.c_str());
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// Compares direct I/O with buffered I/O. The default data set fits in the OS page cache, which flatters buffered I/O;
+// raise num_pages beyond the RAM of the machine for a real comparison.
+// NOLINTNEXTLINE
+TEST(DiskManagerBenchmarkTest, DISABLED_DirectIoTest) {
+  const page_id_t num_pages = 4096;
+  const size_t num_ops = 1 << 15;
+
+  double buffered_ops = RunDiskBenchmark(false, num_pages, num_ops);
+  double direct_ops = RunDiskBenchmark(true, num_pages, num_ops);
+  std::cout << "pages: " << num_pages << ", buffered I/O ops/s: " << static_cast<uint64_t>(buffered_ops)
+            << ", direct I/O ops/s: " << static_cast<uint64_t>(direct_ops) << std::endl;
+}
+
+}  // namespace bustub
@@ -10,7 +10,14 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
@@ -24,12 +31,16 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.crc");
+    remove("test.free");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.crc");
+    remove("test.free");
   };
 };
 
@@ -55,6 +66,253 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentReadWritePageTest) {
+  const int num_threads = 8;
+  const int pages_per_thread = 64;
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file, 16);
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&dm, tid] {
+      char buf[PAGE_SIZE];
+      char data[PAGE_SIZE];
+      // Each thread owns the pages congruent to its id, like a buffer pool instance does.
+      for (int i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id = i * num_threads + tid;
+        std::memset(data, page_id % 128, sizeof(data));
+        dm.WritePage(page_id, data);
+        dm.ReadPage(page_id, buf);
+        EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * pages_per_thread, dm.GetNumWrites());
+
+  // Reading past the end of the file returns a zeroed page.
+  char buf[PAGE_SIZE];
+  char zeros[PAGE_SIZE] = {0};
+  std::memset(buf, 1, sizeof(buf));
+  dm.ReadPage(num_threads * pages_per_thread + 1, buf);
+  EXPECT_EQ(std::memcmp(buf, zeros, sizeof(buf)), 0);
+
+  dm.SyncPages();
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WritePagesTest) {
+  const int num_pages = 20;
+  std::vector<std::vector<char>> pages(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<DiskManager::PageWrite> writes;
+  // Two runs of consecutive pages with a gap between them, and a lone page.
+  for (page_id_t page_id : {0, 1, 2, 3, 7, 8, 9, 15}) {
+    std::memset(pages[page_id].data(), page_id + 1, PAGE_SIZE);
+    writes.push_back({page_id, pages[page_id].data()});
+  }
+  auto dm = DiskManager("test.db");
+  dm.WritePages(writes);
+  EXPECT_EQ(writes.size(), dm.GetNumWrites());
+  EXPECT_EQ(16, dm.GetNumPages());
+
+  char buf[PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < 16; page_id++) {
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ(std::memcmp(buf, pages[page_id].data(), PAGE_SIZE), 0);
+  }
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreePagesTest) {
+  char data[PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto *dm = new DiskManager(db_file);
+  for (page_id_t page_id = 0; page_id < 20; page_id++) {
+    dm->WritePage(page_id, data);
+  }
+  EXPECT_TRUE(dm->GetFreePages().empty());
+
+  // Scenario: pages marked free stay free across a reopen, without any page being read.
+  for (page_id_t page_id : {3, 9, 17, 18}) {
+    dm->MarkPageFree(page_id);
+  }
+  dm->ShutDown();
+  delete dm;
+  dm = new DiskManager(db_file);
+  EXPECT_EQ((std::vector<page_id_t>{3, 9, 17, 18}), dm->GetFreePages());
+  EXPECT_EQ(0, dm->GetStats().read_latency_.count_);
+
+  // Scenario: writing a free page takes it off the free pages, on disk as well.
+  dm->WritePage(9, data);
+  dm->WritePages({{2, data}, {3, data}});
+  EXPECT_EQ((std::vector<page_id_t>{17, 18}), dm->GetFreePages());
+
+  // Scenario: truncating the file drops the free pages cut off, so pages written there later are not free.
+  dm->Truncate(18);
+  EXPECT_EQ((std::vector<page_id_t>{17}), dm->GetFreePages());
+  dm->WritePage(18, data);
+  dm->ShutDown();
+  delete dm;
+  dm = new DiskManager(db_file);
+  EXPECT_EQ((std::vector<page_id_t>{17}), dm->GetFreePages());
+
+  // Scenario: a database file created anew does not pick up the free pages of the one it replaced.
+  dm->ShutDown();
+  delete dm;
+  remove("test.db");
+  dm = new DiskManager(db_file);
+  EXPECT_TRUE(dm->GetFreePages().empty());
+  dm->WritePage(17, data);
+  dm->ShutDown();
+  delete dm;
+  dm = new DiskManager(db_file);
+  EXPECT_TRUE(dm->GetFreePages().empty());
+
+  dm->ShutDown();
+  delete dm;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIoTest) {
+  // A file that ends in the middle of page 1.
+  {
+    std::ofstream file("test.db", std::ios::binary);
+    std::string contents(PAGE_SIZE + 100, 'a');
+    file.write(contents.data(), contents.size());
+  }
+  auto dm = DiskManager("test.db", 0, true);
+  // Only file systems like tmpfs refuse O_DIRECT.
+  if (!dm.IsDirectIo()) {
+    GTEST_SKIP() << "O_DIRECT is not supported here";
+  }
+
+  std::unique_ptr<char, decltype(&free)> aligned(static_cast<char *>(std::aligned_alloc(PAGE_SIZE, PAGE_SIZE * 2)),
+                                                 &free);
+  char *unaligned = aligned.get() + 1;
+
+  // Scenario: the partial page reads up to the end of the file, and zeroes after it.
+  for (char *buf : {aligned.get(), unaligned}) {
+    std::memset(buf, 'x', PAGE_SIZE);
+    dm.ReadPage(1, buf);
+    EXPECT_EQ('a', buf[99]);
+    EXPECT_EQ(0, buf[100]);
+    EXPECT_EQ(0, buf[PAGE_SIZE - 1]);
+  }
+
+  // Scenario: aligned and unaligned buffers both make it to the file and back.
+  std::memset(unaligned, 'u', PAGE_SIZE);
+  dm.WritePage(2, unaligned);
+  std::memset(aligned.get(), 'b', PAGE_SIZE);
+  dm.WritePage(1, aligned.get());
+  dm.ReadPage(2, aligned.get());
+  EXPECT_EQ('u', aligned.get()[PAGE_SIZE - 1]);
+  dm.ReadPage(1, unaligned);
+  EXPECT_EQ('b', unaligned[100]);
+
+  // Scenario: reading past the end of the file gives a zeroed page.
+  std::memset(aligned.get(), 'x', PAGE_SIZE);
+  dm.ReadPage(10, aligned.get());
+  EXPECT_EQ(0, aligned.get()[0]);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumTest) {
+  char data[PAGE_SIZE];
+  char buf[PAGE_SIZE];
+  // Page 3 is written before checksums are turned on, so it has none.
+  {
+    auto dm = DiskManager("test.db");
+    std::memset(data, 'c', PAGE_SIZE);
+    dm.WritePage(3, data);
+    dm.ShutDown();
+  }
+  {
+    auto dm = DiskManager("test.db", 0, false, PageChecksumMode::LOG);
+    std::vector<std::vector<char>> pages(3, std::vector<char>(PAGE_SIZE));
+    std::vector<DiskManager::PageWrite> writes;
+    for (page_id_t page_id = 0; page_id < 3; page_id++) {
+      std::memset(pages[page_id].data(), 'a' + page_id, PAGE_SIZE);
+      writes.push_back({page_id, pages[page_id].data()});
+    }
+    dm.WritePages(writes);
+    // An all-zero page has a checksum too.
+    std::memset(data, 0, PAGE_SIZE);
+    dm.WritePage(4, data);
+    for (page_id_t page_id = 0; page_id < 5; page_id++) {
+      dm.ReadPage(page_id, buf);
+    }
+    EXPECT_EQ(0, dm.GetNumChecksumFailures());
+    dm.ShutDown();
+  }
+
+  // Tear page 1 behind the disk manager's back, as a crash in the middle of a write would.
+  {
+    std::fstream file("test.db", std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(PAGE_SIZE + PAGE_SIZE / 2);
+    std::string torn(PAGE_SIZE / 2, 'x');
+    file.write(torn.data(), torn.size());
+  }
+
+  // Scenario: in LOG mode, the torn page is read as is, but counted.
+  {
+    auto dm = DiskManager("test.db", 0, false, PageChecksumMode::LOG);
+    dm.ReadPage(1, buf);
+    EXPECT_EQ('x', buf[PAGE_SIZE - 1]);
+    EXPECT_EQ(1, dm.GetNumChecksumFailures());
+    dm.ShutDown();
+  }
+
+  // Scenario: in STRICT mode, reading the torn page throws, the other pages read fine.
+  {
+    auto dm = DiskManager("test.db", 0, false, PageChecksumMode::STRICT);
+    EXPECT_THROW(dm.ReadPage(1, buf), Exception);
+    EXPECT_EQ(1, dm.GetNumChecksumFailures());
+    for (page_id_t page_id : {0, 2, 3, 4}) {
+      EXPECT_NO_THROW(dm.ReadPage(page_id, buf));
+    }
+    // Scenario: rewriting the page gives it a good checksum again.
+    std::memset(data, 'b', PAGE_SIZE);
+    dm.WritePage(1, data);
+    EXPECT_NO_THROW(dm.ReadPage(1, buf));
+    EXPECT_EQ(1, dm.GetNumChecksumFailures());
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumConcurrentModifyTest) {
+  // The buffer pool writes back frames without latching them, so the pages change while they are being written.
+  auto dm = DiskManager("test.db", 0, false, PageChecksumMode::STRICT);
+  std::vector<std::vector<char>> pages(2, std::vector<char>(PAGE_SIZE));
+  std::atomic<bool> done{false};
+  std::thread scribbler([&] {
+    for (uint32_t i = 0; !done; i++) {
+      pages[i % 2][i / 2 % PAGE_SIZE] = static_cast<char>(i / 2 / PAGE_SIZE);
+    }
+  });
+  // Scenario: the checksums stored are those of the bytes written, not of the pages as they are after the write.
+  char buf[PAGE_SIZE];
+  for (int i = 0; i < 1000; i++) {
+    dm.WritePage(0, pages[0].data());
+    EXPECT_NO_THROW(dm.ReadPage(0, buf));
+    dm.WritePages({{0, pages[0].data()}, {1, pages[1].data()}});
+    EXPECT_NO_THROW(dm.ReadPage(0, buf));
+    EXPECT_NO_THROW(dm.ReadPage(1, buf));
+  }
+  done = true;
+  scribbler.join();
+  EXPECT_EQ(0, dm.GetNumChecksumFailures());
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
@@ -0,0 +1,164 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/storage/page_guard_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  Page *page;
+  {
+    // Scenario: a guard unpins its page when it goes out of scope, as dirty if it was modified.
+    auto guard = bpm->NewPageGuarded(&page_id);
+    ASSERT_TRUE(guard.IsValid());
+    page = guard.GetPage();
+    EXPECT_EQ(page_id, guard.PageId());
+    EXPECT_EQ(1, page->GetPinCount());
+    snprintf(guard.AsMut<char>(), PAGE_SIZE, "Hello");
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+  EXPECT_TRUE(page->IsDirty());
+
+  // Scenario: moving a guard hands over the pin, it is released once.
+  auto guard = bpm->FetchPageBasic(page_id);
+  EXPECT_EQ(1, page->GetPinCount());
+  auto moved_guard = std::move(guard);
+  EXPECT_FALSE(guard.IsValid());  // NOLINT
+  EXPECT_TRUE(moved_guard.IsValid());
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_EQ(0, strcmp(moved_guard.GetData(), "Hello"));
+  moved_guard = bpm->FetchPageBasic(page_id);
+  EXPECT_EQ(1, page->GetPinCount());
+  moved_guard.Drop();
+  moved_guard.Drop();
+  EXPECT_EQ(0, page->GetPinCount());
+
+  // Scenario: read guards share the page, a write guard waits for them to be dropped.
+  {
+    auto read_guard1 = bpm->FetchPageRead(page_id);
+    auto read_guard2 = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(2, page->GetPinCount());
+    EXPECT_EQ(0, strcmp(read_guard2.As<char>(), "Hello"));
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+  {
+    auto write_guard = bpm->FetchPageWrite(page_id);
+    snprintf(write_guard.AsMut<char>(), PAGE_SIZE, "World");
+    WritePageGuard moved_write_guard;
+    moved_write_guard = std::move(write_guard);
+    EXPECT_EQ(1, page->GetPinCount());
+  }
+  {
+    auto read_guard = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(0, strcmp(read_guard.As<char>(), "World"));
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  // Scenario: a page that cannot be fetched gives an empty guard.
+  std::vector<BasicPageGuard> guards;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t new_page_id;
+    guards.push_back(bpm->NewPageGuarded(&new_page_id));
+    ASSERT_TRUE(guards.back().IsValid());
+  }
+  EXPECT_FALSE(bpm->FetchPageRead(page_id).IsValid());
+  guards.clear();
+  EXPECT_TRUE(bpm->FetchPageWrite(page_id).IsValid());
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, OptimisticReadTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+  const int num_writes = 20000;
+  const int num_readers = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  page_id_t page_id;
+  bpm->NewPageGuarded(&page_id).Drop();
+
+  // Scenario: the writer fills the page with one byte value at a time. Optimistic readers never see two values mixed.
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < num_readers; i++) {
+    readers.emplace_back([&] {
+      auto guard = bpm->FetchPageBasic(page_id);
+      while (!done) {
+        char first;
+        bool is_consistent;
+        guard.GetPage()->OptimisticRead([&] {
+          first = guard.GetData()[0];
+          is_consistent = true;
+          for (int j = 1; j < PAGE_SIZE; j++) {
+            is_consistent = is_consistent && guard.GetData()[j] == first;
+          }
+        });
+        EXPECT_TRUE(is_consistent);
+      }
+    });
+  }
+  {
+    auto guard = bpm->FetchPageBasic(page_id);
+    for (int i = 0; i < num_writes; i++) {
+      guard.GetPage()->WLatch();
+      memset(guard.AsMut<char>(), i % 128, PAGE_SIZE);
+      guard.GetPage()->WUnlatch();
+    }
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  // Scenario: a version taken while the write latch is held never validates.
+  auto guard = bpm->FetchPageBasic(page_id);
+  Page *page = guard.GetPage();
+  uint64_t version = page->GetVersion();
+  EXPECT_TRUE(page->ValidateVersion(version));
+  page->WLatch();
+  EXPECT_FALSE(page->ValidateVersion(version));
+  EXPECT_FALSE(page->ValidateVersion(page->GetVersion()));
+  page->WUnlatch();
+  EXPECT_FALSE(page->ValidateVersion(version));
+  guard.Drop();
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
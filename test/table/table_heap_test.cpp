@@ -0,0 +1,155 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_heap_test.cpp
+//
+// Identification: test/table/table_heap_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+#include "storage/table/tuple.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// Walks the page list of the table and returns the ids of its pages.
+static auto GetTablePageIds(BufferPoolManager *bpm, page_id_t first_page_id) -> std::vector<page_id_t> {
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id = first_page_id;
+  while (page_id != INVALID_PAGE_ID) {
+    page_ids.push_back(page_id);
+    auto page = static_cast<TablePage *>(bpm->FetchPage(page_id));
+    EXPECT_NE(nullptr, page);
+    page_id_t next_page_id = page->GetNextPageId();
+    bpm->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return page_ids;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, FreeSpaceMapTest) {
+  Schema schema{{Column{"a", TypeId::BIGINT}, Column{"b", TypeId::BIGINT}}};
+  std::vector<Value> values{ValueFactory::GetBigIntValue(1), ValueFactory::GetBigIntValue(2)};
+  Tuple tuple{values, &schema};
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *txn = new Transaction(0);
+  auto *table = new TableHeap(bpm, lock_manager, nullptr, txn);
+  page_id_t first_page_id = table->GetFirstPageId();
+
+  std::vector<RID> rids;
+  for (int i = 0; i < 5000; i++) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, txn));
+    rids.push_back(rid);
+  }
+  auto page_ids = GetTablePageIds(bpm, first_page_id);
+  ASSERT_GT(page_ids.size(), 10);
+  // Pages are filled in list order.
+  EXPECT_EQ(page_ids.back(), rids.back().GetPageId());
+
+  // Space freed in the middle of the table is reused instead of appending a new page.
+  page_id_t middle_page_id = page_ids[page_ids.size() / 2];
+  size_t num_deleted = 0;
+  for (const auto &rid : rids) {
+    if (rid.GetPageId() == middle_page_id) {
+      table->ApplyDelete(rid, txn);
+      num_deleted++;
+    }
+  }
+  for (size_t i = 0; i < num_deleted; i++) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, txn));
+    EXPECT_EQ(middle_page_id, rid.GetPageId());
+  }
+  EXPECT_EQ(page_ids, GetTablePageIds(bpm, first_page_id));
+  delete table;
+
+  // The free space map is persisted, so a reopened table still finds the free space.
+  table = new TableHeap(bpm, lock_manager, nullptr, first_page_id);
+  RID deleted_rid = rids[rids.size() / 3];
+  table->ApplyDelete(deleted_rid, txn);
+  RID rid;
+  ASSERT_TRUE(table->InsertTuple(tuple, &rid, txn));
+  EXPECT_EQ(deleted_rid.GetPageId(), rid.GetPageId());
+  delete table;
+
+  // A table whose free space map was lost rebuilds it from the page list.
+  auto first_page = static_cast<TablePage *>(bpm->FetchPage(first_page_id));
+  ASSERT_NE(nullptr, first_page);
+  first_page->SetFreeSpaceMapPageId(INVALID_PAGE_ID);
+  bpm->UnpinPage(first_page_id, true);
+  table = new TableHeap(bpm, lock_manager, nullptr, first_page_id);
+  deleted_rid = rids[rids.size() / 4];
+  table->ApplyDelete(deleted_rid, txn);
+  ASSERT_TRUE(table->InsertTuple(tuple, &rid, txn));
+  EXPECT_EQ(deleted_rid.GetPageId(), rid.GetPageId());
+  EXPECT_EQ(page_ids, GetTablePageIds(bpm, first_page_id));
+  delete table;
+
+  delete txn;
+  delete lock_manager;
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, ScanPrefetchTest) {
+  Schema schema{{Column{"a", TypeId::BIGINT}, Column{"b", TypeId::BIGINT}}};
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *txn = new Transaction(0);
+  auto *table = new TableHeap(bpm, lock_manager, nullptr, txn);
+
+  // The table is several times the size of the pool, so the scan reads most pages from disk ahead of itself.
+  const int num_tuples = 30000;
+  for (int i = 0; i < num_tuples; i++) {
+    std::vector<Value> values{ValueFactory::GetBigIntValue(i), ValueFactory::GetBigIntValue(2 * i)};
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(Tuple{values, &schema}, &rid, txn));
+  }
+  ASSERT_GT(GetTablePageIds(bpm, table->GetFirstPageId()).size(), 100);
+
+  for (int round = 0; round < 2; round++) {
+    int64_t i = 0;
+    for (auto it = table->Begin(txn); it != table->End(); ++it) {
+      ASSERT_EQ(i, it->GetValue(&schema, 0).GetAs<int64_t>());
+      ASSERT_EQ(2 * i, it->GetValue(&schema, 1).GetAs<int64_t>());
+      i++;
+    }
+    EXPECT_EQ(num_tuples, i);
+  }
+  // The prefetched pages were all unpinned.
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    EXPECT_EQ(0, bpm->GetPages()[i].GetPinCount());
+  }
+
+  delete table;
+  delete txn;
+  delete lock_manager;
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub